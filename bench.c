@@ -0,0 +1,430 @@
+// Microbenchmarks for cJSON.c over niri-shaped documents.
+//
+// Prints one JSON object per line and measurement, so runs on different
+// commits can be compared with any JSON tool:
+//   {"corpus":"windows_400","bytes":98765,"op":"parse","iterations":512,
+//    "ns_per_byte":1.234,"allocations":2403,"peak_bytes":123456}
+// ns_per_byte is the fastest iteration divided by the size of the compact
+// document, allocations and peak_bytes are what one iteration took from the
+// cJSON hooks. Files given as arguments are benchmarked as well, e.g. event
+// streams recorded from the niri socket; a file with one event per line is
+// turned into an array of its events.
+#include "cJSON.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Every operation runs until it took this long and at least BENCH_MIN_RUNS
+// times, the fastest run counts
+#define BENCH_MIN_NS 200000000.0
+#define BENCH_MIN_RUNS 5
+
+// Windows in the synthetic WindowsChanged events, about 250 bytes each
+static const int window_counts[] = {4, 40, 400, 4000};
+static const unsigned int thread_counts[] = {1, 2, 4, 8};
+
+// Allocation accounting through the cJSON hooks. Each block starts with its
+// size so free knows how much is released. Atomic since cJSON_ParseParallel
+// allocates on several threads.
+typedef union {
+  size_t size;
+  long double align;
+} alloc_header_t;
+
+static atomic_size_t allocations;
+static atomic_size_t live_bytes;
+static atomic_size_t peak_bytes;
+
+static void *counting_malloc(size_t size) {
+  alloc_header_t *header = malloc(sizeof(alloc_header_t) + size);
+  if (!header) {
+    return NULL;
+  }
+  header->size = size;
+  atomic_fetch_add(&allocations, 1);
+  size_t live = atomic_fetch_add(&live_bytes, size) + size;
+  size_t peak = atomic_load(&peak_bytes);
+  while (live > peak &&
+         !atomic_compare_exchange_weak(&peak_bytes, &peak, live)) {
+  }
+  return header + 1;
+}
+
+static void counting_free(void *pointer) {
+  if (!pointer) {
+    return;
+  }
+  alloc_header_t *header = (alloc_header_t *)pointer - 1;
+  atomic_fetch_sub(&live_bytes, header->size);
+  free(header);
+}
+
+typedef struct {
+  const char *name;
+  char *compact;
+  size_t compact_length;
+  char *pretty;
+  size_t pretty_length;
+  cJSON *tree;
+  // output buffer for minify
+  char *scratch;
+} corpus_t;
+
+typedef struct {
+  corpus_t *corpus;
+  cJSON *tree;
+  cJSON *copy;
+  unsigned int threads;
+  // keeps the compiler from dropping results
+  size_t sink;
+} bench_t;
+
+typedef void (*bench_fn)(bench_t *bench);
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void report(const corpus_t *corpus, const char *op, unsigned int threads,
+                   size_t iterations, double best_ns, size_t allocs,
+                   size_t peak) {
+  cJSON *line = cJSON_CreateObject();
+  cJSON_AddStringToObject(line, "corpus", corpus->name);
+  cJSON_AddNumberToObject(line, "bytes", (double)corpus->compact_length);
+  cJSON_AddStringToObject(line, "op", op);
+  if (threads) {
+    cJSON_AddNumberToObject(line, "threads", threads);
+  }
+  cJSON_AddNumberToObject(line, "iterations", (double)iterations);
+  cJSON_AddNumberToObject(line, "ns_per_byte",
+                          best_ns / (double)corpus->compact_length);
+  cJSON_AddNumberToObject(line, "allocations", (double)allocs);
+  cJSON_AddNumberToObject(line, "peak_bytes", (double)peak);
+
+  char *printed = cJSON_PrintUnformatted(line);
+  if (printed) {
+    puts(printed);
+    fflush(stdout);
+  }
+  cJSON_free(printed);
+  cJSON_Delete(line);
+}
+
+// setup and teardown run outside the measured time
+static void run(bench_t *bench, const char *op, bench_fn setup, bench_fn fn,
+                bench_fn teardown) {
+  double best = 0, total = 0;
+  size_t iterations = 0, allocs = 0, peak = 0;
+
+  while (total < BENCH_MIN_NS || iterations < BENCH_MIN_RUNS) {
+    if (setup) {
+      setup(bench);
+    }
+    size_t allocations_before = atomic_load(&allocations);
+    size_t live_before = atomic_load(&live_bytes);
+    atomic_store(&peak_bytes, live_before);
+
+    double start = now_ns();
+    fn(bench);
+    double elapsed = now_ns() - start;
+
+    allocs = atomic_load(&allocations) - allocations_before;
+    peak = atomic_load(&peak_bytes) - live_before;
+    if (teardown) {
+      teardown(bench);
+    }
+    if (iterations == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    total += elapsed;
+    iterations++;
+  }
+  report(bench->corpus, op, bench->threads, iterations, best, allocs, peak);
+}
+
+static void bench_parse(bench_t *bench) {
+  bench->tree = cJSON_ParseWithLength(bench->corpus->compact,
+                                      bench->corpus->compact_length);
+}
+
+static void bench_parse_parallel(bench_t *bench) {
+  bench->tree = cJSON_ParseParallel(bench->corpus->compact,
+                                    bench->corpus->compact_length,
+                                    bench->threads);
+}
+
+// Reuses the tree of the last run, like a stream of events of one shape
+static void bench_parse_into(bench_t *bench) {
+  bench->tree = cJSON_ParseInto(bench->tree, bench->corpus->compact,
+                                bench->corpus->compact_length);
+}
+
+static void bench_delete(bench_t *bench) {
+  cJSON_Delete(bench->tree);
+  bench->tree = NULL;
+}
+
+// Look up every key of every object by name
+static size_t lookup_all(const cJSON *item) {
+  size_t found = 0;
+  const cJSON *child;
+  cJSON_ArrayForEach(child, item) {
+    if (cJSON_IsObject(item) &&
+        cJSON_GetObjectItemCaseSensitive(item, child->string) != NULL) {
+      found++;
+    }
+    found += lookup_all(child);
+  }
+  return found;
+}
+
+static void bench_lookup(bench_t *bench) {
+  bench->sink += lookup_all(bench->corpus->tree);
+}
+
+static size_t iterate_all(const cJSON *item) {
+  size_t count = 1;
+  const cJSON *child;
+  cJSON_ArrayForEach(child, item) { count += iterate_all(child); }
+  return count;
+}
+
+static void bench_iterate(bench_t *bench) {
+  bench->sink += iterate_all(bench->corpus->tree);
+}
+
+static void bench_print(bench_t *bench) {
+  char *printed = cJSON_PrintUnformatted(bench->corpus->tree);
+  bench->sink += printed != NULL;
+  cJSON_free(printed);
+}
+
+static void bench_minify(bench_t *bench) {
+  cJSON_Minifier minifier;
+  cJSON_InitMinifier(&minifier);
+  bench->sink +=
+      cJSON_MinifyChunk(&minifier, bench->corpus->pretty,
+                        bench->corpus->pretty_length, bench->corpus->scratch);
+}
+
+static void bench_duplicate(bench_t *bench) {
+  bench->copy = cJSON_Duplicate(bench->corpus->tree, 1);
+}
+
+static void delete_copy(bench_t *bench) {
+  cJSON_Delete(bench->copy);
+  bench->copy = NULL;
+}
+
+static void bench_compare(bench_t *bench) {
+  bench->sink += cJSON_Compare(bench->corpus->tree, bench->copy, 1);
+}
+
+static void bench_corpus(corpus_t *corpus) {
+  bench_t bench = {corpus, NULL, NULL, 0, 0};
+
+  run(&bench, "parse", NULL, bench_parse, bench_delete);
+  bench_parse(&bench);
+  run(&bench, "parse_into", NULL, bench_parse_into, NULL);
+  bench_delete(&bench);
+  run(&bench, "lookup", NULL, bench_lookup, NULL);
+  run(&bench, "iterate", NULL, bench_iterate, NULL);
+  run(&bench, "print", NULL, bench_print, NULL);
+  run(&bench, "minify", NULL, bench_minify, NULL);
+  run(&bench, "duplicate", NULL, bench_duplicate, delete_copy);
+  bench_duplicate(&bench);
+  run(&bench, "compare", NULL, bench_compare, NULL);
+  delete_copy(&bench);
+  // Lookups again with the hash tables of cJSON_BuildIndex
+  cJSON_BuildIndex(corpus->tree);
+  run(&bench, "lookup_indexed", NULL, bench_lookup, NULL);
+  run(&bench, "delete", bench_parse, bench_delete, NULL);
+
+  // Speedup curve of cJSON_ParseParallel, only documents that get split
+  if (corpus->compact_length >= CJSON_PARALLEL_THRESHOLD) {
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+         i++) {
+      bench.threads = thread_counts[i];
+      run(&bench, "parse_parallel", NULL, bench_parse_parallel, bench_delete);
+    }
+  }
+}
+
+// Takes ownership of tree
+static int init_corpus(corpus_t *corpus, const char *name, cJSON *tree) {
+  memset(corpus, 0, sizeof(*corpus));
+  corpus->name = name;
+  corpus->tree = tree;
+  if (!tree) {
+    return 0;
+  }
+  corpus->compact = cJSON_PrintUnformatted(tree);
+  corpus->pretty = cJSON_Print(tree);
+  if (!corpus->compact || !corpus->pretty) {
+    return 0;
+  }
+  corpus->compact_length = strlen(corpus->compact);
+  corpus->pretty_length = strlen(corpus->pretty);
+  corpus->scratch = malloc(corpus->pretty_length);
+  return corpus->scratch != NULL;
+}
+
+static void free_corpus(corpus_t *corpus) {
+  cJSON_Delete(corpus->tree);
+  cJSON_free(corpus->compact);
+  cJSON_free(corpus->pretty);
+  free(corpus->scratch);
+}
+
+static cJSON *keyboard_layouts_changed(void) {
+  cJSON *event = cJSON_CreateObject();
+  cJSON *payload = cJSON_AddObjectToObject(event, "KeyboardLayoutsChanged");
+  cJSON *layouts = cJSON_AddObjectToObject(payload, "keyboard_layouts");
+  const char *names[] = {"English (US)", "Swedish"};
+  cJSON_AddItemToObject(layouts, "names", cJSON_CreateStringArray(names, 2));
+  cJSON_AddNumberToObject(layouts, "current_idx", 0);
+  return event;
+}
+
+// A WindowsChanged event like the one niri sends on connect
+static cJSON *windows_changed(int count) {
+  cJSON *event = cJSON_CreateObject();
+  cJSON *payload = cJSON_AddObjectToObject(event, "WindowsChanged");
+  cJSON *windows = cJSON_AddArrayToObject(payload, "windows");
+  char title[64];
+
+  for (int i = 0; i < count; i++) {
+    cJSON *window = cJSON_CreateObject();
+    cJSON_AddItemToArray(windows, window);
+    snprintf(title, sizeof(title), "~/src/project-%d: nvim main.c", i);
+    cJSON_AddNumberToObject(window, "id", 1000 + i);
+    cJSON_AddStringToObject(window, "title", title);
+    cJSON_AddStringToObject(window, "app_id",
+                            i % 3 ? "foot" : "org.mozilla.firefox");
+    cJSON_AddNumberToObject(window, "pid", 20000 + 7 * i);
+    cJSON_AddNumberToObject(window, "workspace_id", 1 + i % 9);
+    cJSON_AddBoolToObject(window, "is_focused", i == 1);
+    cJSON_AddBoolToObject(window, "is_floating", i % 11 == 0);
+    cJSON_AddBoolToObject(window, "is_urgent", 0);
+    cJSON *layout = cJSON_AddObjectToObject(window, "layout");
+    int position[] = {1 + i % 5, 1};
+    double size[] = {958.5, 1040.0};
+    cJSON_AddItemToObject(layout, "pos_in_scrolling_layout",
+                          cJSON_CreateIntArray(position, 2));
+    cJSON_AddItemToObject(layout, "tile_size",
+                          cJSON_CreateDoubleArray(size, 2));
+    cJSON_AddItemToObject(layout, "window_offset_in_tile",
+                          cJSON_CreateDoubleArray(size, 0));
+  }
+  return event;
+}
+
+static char *read_file(const char *path, size_t *length) {
+  FILE *file = fopen(path, "rb");
+  char *data = NULL;
+  size_t used = 0, size = 0;
+  size_t n;
+
+  if (!file) {
+    return NULL;
+  }
+  do {
+    if (used == size) {
+      size = size ? 2 * size : 65536;
+      char *grown = realloc(data, size + 1);
+      if (!grown) {
+        free(data);
+        fclose(file);
+        return NULL;
+      }
+      data = grown;
+    }
+    n = fread(data + used, 1, size - used, file);
+    used += n;
+  } while (n > 0);
+  fclose(file);
+  data[used] = '\0';
+  *length = used;
+  return data;
+}
+
+static cJSON_bool collect_event(cJSON *item, const char *line, size_t length,
+                                void *user) {
+  (void)line;
+  (void)length;
+  if (item) {
+    cJSON_AddItemToArray(user, item);
+  }
+  return 1;
+}
+
+// One document, or an array of the events of a recorded stream
+static cJSON *load_recorded(const char *path) {
+  size_t length = 0;
+  char *data = read_file(path, &length);
+  if (!data) {
+    fprintf(stderr, "Can't read %s\n", path);
+    return NULL;
+  }
+  const char *end = NULL;
+  cJSON *tree = cJSON_ParseWithLengthOpts(data, length, &end, 0);
+  while (tree && end < data + length && *end && strchr(" \t\r\n", *end)) {
+    end++;
+  }
+  if (!tree || end < data + length) {
+    cJSON_Delete(tree);
+    tree = cJSON_CreateArray();
+    // the last line doesn't need a newline
+    data[length] = '\n';
+    cJSON_ParseMany(data, length + 1, collect_event, tree);
+  }
+  free(data);
+  return tree;
+}
+
+int main(int argc, char **argv) {
+  char names[sizeof(window_counts) / sizeof(window_counts[0])][32];
+  corpus_t corpus;
+  int ret = EXIT_SUCCESS;
+
+  if (argc > 1 && argv[1][0] == '-') {
+    fprintf(stderr, "Usage: %s [recorded.json ...]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  cJSON_Hooks hooks = {counting_malloc, counting_free};
+  cJSON_InitHooks(&hooks);
+
+  if (init_corpus(&corpus, "keyboard_layouts_changed",
+                  keyboard_layouts_changed())) {
+    bench_corpus(&corpus);
+  } else {
+    ret = EXIT_FAILURE;
+  }
+  free_corpus(&corpus);
+
+  for (size_t i = 0; i < sizeof(window_counts) / sizeof(window_counts[0]);
+       i++) {
+    snprintf(names[i], sizeof(names[i]), "windows_%d", window_counts[i]);
+    if (init_corpus(&corpus, names[i], windows_changed(window_counts[i]))) {
+      bench_corpus(&corpus);
+    } else {
+      ret = EXIT_FAILURE;
+    }
+    free_corpus(&corpus);
+  }
+
+  for (int i = 1; i < argc; i++) {
+    if (init_corpus(&corpus, argv[i], load_recorded(argv[i]))) {
+      bench_corpus(&corpus);
+    } else {
+      ret = EXIT_FAILURE;
+    }
+    free_corpus(&corpus);
+  }
+  return ret;
+}
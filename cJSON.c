@@ -49,6 +49,10 @@
 #include <locale.h>
 #endif
 
+#ifdef ENABLE_THREADS
+#include <pthread.h>
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -85,6 +89,19 @@
 #endif
 #endif
 
+/* 64 bit unsigned integer for integer numbers and the number formatting, C89 has none */
+#if defined(_MSC_VER)
+typedef unsigned __int64 cjson_uint64;
+#elif defined(__GNUC__)
+__extension__ typedef unsigned long long cjson_uint64;
+#else
+typedef unsigned long long cjson_uint64;
+#endif
+#define CJSON_UINT64_C(high, low) ((((cjson_uint64)(high)) << 32) | (cjson_uint64)(low))
+
+#define CJSON_INT64_MAX ((cJSON_int64)CJSON_UINT64_C(0x7FFFFFFF, 0xFFFFFFFF))
+#define CJSON_INT64_MIN (-CJSON_INT64_MAX - 1)
+
 typedef struct {
     const unsigned char *json;
     size_t position;
@@ -116,6 +133,22 @@ CJSON_PUBLIC(double) cJSON_GetNumberValue(const cJSON * const item)
     return item->valuedouble;
 }
 
+static cJSON_int64 double_to_int64(const double number);
+
+CJSON_PUBLIC(cJSON_int64) cJSON_GetInt64Value(const cJSON * const item)
+{
+    if (!cJSON_IsNumber(item))
+    {
+        return 0;
+    }
+    if (cJSON_IsInt64(item))
+    {
+        return item->valueint64;
+    }
+
+    return double_to_int64(item->valuedouble);
+}
+
 /* This is a safeguard to prevent copy-pasters from using incompatible C and header files */
 #if (CJSON_VERSION_MAJOR != 1) || (CJSON_VERSION_MINOR != 7) || (CJSON_VERSION_PATCH != 19)
     #error cJSON.h and cJSON.c have different versions. Make sure that both have the same.
@@ -185,6 +218,9 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 
 static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
 
+/* counts a string from the hooks in the node pool statistics */
+static void count_string_allocation(void);
+
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
     size_t length = 0;
@@ -201,6 +237,10 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     {
         return NULL;
     }
+    if (hooks == &global_hooks)
+    {
+        count_string_allocation();
+    }
     memcpy(copy, string, length);
 
     return copy;
@@ -237,2946 +277,9664 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
-/* Internal constructor. */
-static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+/* number of items carved out of every slab of the node pool */
+#ifndef CJSON_POOL_SLAB_ITEMS
+#define CJSON_POOL_SLAB_ITEMS 256
+#endif
+
+/* bits in cJSON.internalflags */
+#define cJSON_FlagPooled 1 /* item lives in a slab of the node pool */
+#define cJSON_FlagInt64 2 /* valueint64 is the exact value of the number */
+#define cJSON_FlagArena 4 /* item and its strings live in an arena, so does everything below it */
+#define cJSON_FlagLazy 8 /* array/object whose text (valuestring, valueint64 bytes long) isn't parsed yet */
+
+typedef struct node_slab
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
-    if (node)
+    struct node_slab *next;
+    void (CJSON_CDECL *deallocate)(void *pointer);
+} node_slab;
+
+typedef struct
+{
+    cJSON_bool enabled;
+    node_slab *slabs;
+    cJSON *free_list; /* chained through cJSON.next */
+    cJSON_PoolStats stats;
+} node_pool;
+
+static node_pool global_pool = { false, NULL, NULL, { 0, 0, 0, 0, 0, 0, 0 } };
+
+/* allocate a new slab and put all of its items on the free list */
+static cJSON_bool grow_node_pool(node_pool * const pool, const internal_hooks * const hooks)
+{
+    node_slab *slab = NULL;
+    unsigned char *items = NULL;
+    size_t i = 0;
+
+    slab = (node_slab*)hooks->allocate(sizeof(node_slab) + (CJSON_POOL_SLAB_ITEMS * sizeof(cJSON)));
+    if (slab == NULL)
     {
-        memset(node, '\0', sizeof(cJSON));
+        return false;
     }
+    pool->stats.slab_allocations++;
 
-    return node;
-}
+    slab->deallocate = hooks->deallocate;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
 
-/* Delete a cJSON structure. */
-CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
-{
-    cJSON *next = NULL;
-    while (item != NULL)
+    /* the header is two pointers, so the items right behind it are as aligned as malloc_fn made the slab */
+    items = (unsigned char*)(slab + 1);
+
+    for (i = 0; i < CJSON_POOL_SLAB_ITEMS; i++)
     {
-        next = item->next;
-        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
-        {
-            cJSON_Delete(item->child);
-        }
-        if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
-        {
-            global_hooks.deallocate(item->valuestring);
-            item->valuestring = NULL;
-        }
-        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
-        {
-            global_hooks.deallocate(item->string);
-            item->string = NULL;
-        }
-        global_hooks.deallocate(item);
-        item = next;
+        cJSON *item = (cJSON*)(items + (i * sizeof(cJSON)));
+        item->next = pool->free_list;
+        pool->free_list = item;
     }
+    pool->stats.items_free += CJSON_POOL_SLAB_ITEMS;
+
+    return true;
 }
 
-/* get the decimal point character of the current locale */
-static unsigned char get_decimal_point(void)
+static void count_string_allocation(void)
 {
-#ifdef ENABLE_LOCALES
-    struct lconv *lconv = localeconv();
-    return (unsigned char) lconv->decimal_point[0];
-#else
-    return '.';
-#endif
+    global_pool.stats.string_allocations++;
 }
 
-typedef struct
+CJSON_PUBLIC(void) cJSON_EnableNodePool(cJSON_bool enable)
 {
-    const unsigned char *content;
-    size_t length;
-    size_t offset;
-    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
-    internal_hooks hooks;
-} parse_buffer;
+    global_pool.enabled = enable ? true : false;
+}
 
-/* check if the given size is left to read in a given parse buffer (starting with 1) */
-#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
-/* check if the buffer can be accessed at the given index (starting with 0) */
-#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
-#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
-/* get a pointer to the buffer at the position */
-#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+CJSON_PUBLIC(void) cJSON_GetPoolStats(cJSON_PoolStats *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = global_pool.stats;
+    }
+}
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+CJSON_PUBLIC(cJSON_bool) cJSON_ReleaseNodePool(void)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char *number_c_string;
-    unsigned char decimal_point = get_decimal_point();
-    size_t i = 0;
-    size_t number_string_length = 0;
-    cJSON_bool has_decimal_point = false;
+    node_slab *slab = global_pool.slabs;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    if (global_pool.stats.items_in_use > 0)
     {
         return false;
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; can_access_at_index(input_buffer, i); i++)
+    while (slab != NULL)
     {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_string_length++;
-                break;
+        node_slab *next = slab->next;
+        slab->deallocate(slab);
+        slab = next;
+    }
+    global_pool.slabs = NULL;
+    global_pool.free_list = NULL;
+    global_pool.stats.items_free = 0;
 
-            case '.':
-                number_string_length++;
-                has_decimal_point = true;
-                break;
+    return true;
+}
 
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    /* malloc for temporary buffer, add 1 for '\0' */
-    number_c_string = (unsigned char *) input_buffer->hooks.allocate(number_string_length + 1);
-    if (number_c_string == NULL)
+/* most threads cJSON_ParseParallel uses for one array */
+#ifndef CJSON_PARALLEL_MAX_THREADS
+#define CJSON_PARALLEL_MAX_THREADS 16
+#endif
+
+/* Bytes of the next segment that a segment reader copies after a token that doesn't end in its segment.
+ * Doubled until the token fits. */
+#ifndef CJSON_READER_STITCH_SIZE
+#define CJSON_READER_STITCH_SIZE 64
+#endif
+
+/* default size of the blocks of an arena */
+#ifndef CJSON_ARENA_BLOCK_SIZE
+#define CJSON_ARENA_BLOCK_SIZE 16384
+#endif
+
+/* arena allocations are aligned for doubles and 64 bit integers */
+#define arena_align(size) (((size) + 7) & ~(size_t)7)
+
+typedef struct arena_block
+{
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+} arena_block;
+
+#define ARENA_BLOCK_HEADER arena_align(sizeof(arena_block))
+
+struct cJSON_Arena
+{
+    internal_hooks hooks;
+    arena_block *first;
+    /* blocks after this one are free, their used count is reset when they are reached */
+    arena_block *current;
+    size_t block_size;
+};
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    arena_block *block = arena->current;
+    unsigned char *memory = NULL;
+
+    if (size > ((size_t)-1 - ARENA_BLOCK_HEADER - 7))
     {
-        return false; /* allocation failure */
+        return NULL;
     }
+    size = arena_align(size);
 
-    memcpy(number_c_string, buffer_at_offset(input_buffer), number_string_length);
-    number_c_string[number_string_length] = '\0';
-
-    if (has_decimal_point)
+    if ((block == NULL) || ((block->size - block->used) < size))
     {
-        for (i = 0; i < number_string_length; i++)
+        arena_block *free_block = (block != NULL) ? block->next : NULL;
+        arena_block *before = block;
+
+        /* reuse a block from before the last reset, blocks that are too small stay free for later */
+        while ((free_block != NULL) && (free_block->size < size))
         {
-            if (number_c_string[i] == '.')
+            before = free_block;
+            free_block = free_block->next;
+        }
+        if (free_block != NULL)
+        {
+            /* move it right after the current block, so the blocks after it are still the free ones */
+            if (before != block)
             {
-                /* replace '.' with the decimal point of the current locale (for strtod) */
-                number_c_string[i] = decimal_point;
+                before->next = free_block->next;
+                free_block->next = block->next;
+                block->next = free_block;
+            }
+            block = free_block;
+        }
+        else
+        {
+            const size_t block_size = (size > arena->block_size) ? size : arena->block_size;
+            arena_block *new_block = (arena_block*)arena->hooks.allocate(ARENA_BLOCK_HEADER + block_size);
+            if (new_block == NULL)
+            {
+                return NULL;
+            }
+            new_block->size = block_size;
+            if (block == NULL)
+            {
+                new_block->next = arena->first;
+                arena->first = new_block;
+            }
+            else
+            {
+                new_block->next = block->next;
+                block->next = new_block;
             }
+            block = new_block;
         }
+        block->used = 0;
+        arena->current = block;
     }
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
-    {
-        /* free the temporary buffer */
-        input_buffer->hooks.deallocate(number_c_string);
-        return false; /* parse_error */
-    }
+    memory = (unsigned char*)block + ARENA_BLOCK_HEADER + block->used;
+    block->used += size;
 
-    item->valuedouble = number;
+    return memory;
+}
 
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
-    {
-        item->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        item->valueint = INT_MIN;
-    }
-    else
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t block_size)
+{
+    cJSON_Arena *arena = (cJSON_Arena*)global_hooks.allocate(sizeof(cJSON_Arena));
+    if (arena == NULL)
     {
-        item->valueint = (int)number;
+        return NULL;
     }
+    memset(arena, '\0', sizeof(cJSON_Arena));
+    arena->hooks = global_hooks;
+    arena->block_size = (block_size > 0) ? block_size : CJSON_ARENA_BLOCK_SIZE;
 
-    item->type = cJSON_Number;
-
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    /* free the temporary buffer */
-    input_buffer->hooks.deallocate(number_c_string);
-    return true;
+    return arena;
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
 {
-    if (number >= INT_MAX)
+    if ((arena == NULL) || (arena->first == NULL))
     {
-        object->valueint = INT_MAX;
+        return;
     }
-    else if (number <= (double)INT_MIN)
+
+    arena->current = arena->first;
+    arena->current->used = 0;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena)
+{
+    arena_block *block = NULL;
+
+    if (arena == NULL)
     {
-        object->valueint = INT_MIN;
+        return;
     }
-    else
+
+    block = arena->first;
+    while (block != NULL)
     {
-        object->valueint = (int)number;
+        arena_block *next = block->next;
+        arena->hooks.deallocate(block);
+        block = next;
     }
-
-    return object->valuedouble = number;
+    arena->hooks.deallocate(arena);
 }
 
-/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
-CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+/* an item straight from the allocator, bypassing the pool */
+static cJSON *allocate_item(const internal_hooks * const hooks)
 {
-    char *copy = NULL;
-    size_t v1_len;
-    size_t v2_len;
-    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
-    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
-    {
-        return NULL;
-    }
-    /* return NULL if the object is corrupted or valuestring is NULL */
-    if (object->valuestring == NULL || valuestring == NULL)
+    cJSON *node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    if (node)
     {
-        return NULL;
+        memset(node, '\0', sizeof(cJSON));
     }
 
-    v1_len = strlen(valuestring);
-    v2_len = strlen(object->valuestring);
+    return node;
+}
 
-    if (v1_len <= v2_len)
+/* Internal constructor. */
+static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+{
+    cJSON* node = NULL;
+
+    if (global_pool.enabled)
     {
-        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
-        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
+        if ((global_pool.free_list == NULL) && !grow_node_pool(&global_pool, hooks))
         {
             return NULL;
         }
-        strcpy(object->valuestring, valuestring);
-        return object->valuestring;
-    }
-    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
-    if (copy == NULL)
-    {
-        return NULL;
+
+        node = global_pool.free_list;
+        global_pool.free_list = node->next;
+        global_pool.stats.items_free--;
+        global_pool.stats.items_in_use++;
+        global_pool.stats.pool_allocations++;
+
+        memset(node, '\0', sizeof(cJSON));
+        node->internalflags = cJSON_FlagPooled;
+
+        return node;
     }
-    if (object->valuestring != NULL)
+
+    node = allocate_item(hooks);
+    if (node)
     {
-        cJSON_free(object->valuestring);
+        global_pool.stats.item_allocations++;
     }
-    object->valuestring = copy;
 
-    return copy;
+    return node;
 }
 
-typedef struct
+/* Internal destructor for a single item, its strings have to be released already. */
+static void cJSON_Free_Item(cJSON * const item, const internal_hooks * const hooks)
 {
-    unsigned char *buffer;
-    size_t length;
-    size_t offset;
-    size_t depth; /* current nesting depth (for formatted printing) */
-    cJSON_bool noalloc;
-    cJSON_bool format; /* is this print a formatted print */
-    internal_hooks hooks;
-} printbuffer;
+    if (item->internalflags & cJSON_FlagPooled)
+    {
+        /* recycle, even if the pool has been disabled in the meantime */
+        item->next = global_pool.free_list;
+        global_pool.free_list = item;
+        global_pool.stats.items_free++;
+        global_pool.stats.items_in_use--;
+        global_pool.stats.pool_releases++;
+        return;
+    }
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static unsigned char* ensure(printbuffer * const p, size_t needed)
+    hooks->deallocate(item);
+}
+
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic push
+#endif
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+/* helper function to cast away const */
+static void* cast_away_const(const void* string)
 {
-    unsigned char *newbuffer = NULL;
-    size_t newsize = 0;
+    return (void*)string;
+}
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic pop
+#endif
 
-    if ((p == NULL) || (p->buffer == NULL))
+/* Lookup structures of big arrays and objects, built by cJSON_BuildIndex and kept up to date by the functions that
+ * change the children. Lookups only read them, so threads can share an indexed tree. */
+typedef struct cJSON_Index
+{
+    /* contiguous vector of the children, NULL if there is none */
+    cJSON **items;
+    size_t items_capacity;
+    /* hash table over the keys of an object, NULL if there is none */
+    size_t capacity; /* number of hash slots, always a power of two */
+    cJSON **slots; /* open addressing with linear probing, NULL marks an empty slot */
+    unsigned int *hashes; /* hashes of the keys in slots, allocated together with slots */
+    size_t duplicates; /* children that aren't in slots because an earlier one has the same key */
+} cJSON_Index;
+
+static void free_index(cJSON * const item)
+{
+    if ((item == NULL) || (item->index == NULL))
     {
-        return NULL;
+        return;
     }
 
-    if ((p->length > 0) && (p->offset >= p->length))
+    if (item->index->items != NULL)
     {
-        /* make sure that offset is valid */
-        return NULL;
+        global_hooks.deallocate(item->index->items);
     }
-
-    if (needed > INT_MAX)
+    if (item->index->slots != NULL)
     {
-        /* sizes bigger than INT_MAX are currently not supported */
-        return NULL;
+        global_hooks.deallocate(item->index->slots);
     }
+    global_hooks.deallocate(item->index);
+    item->index = NULL;
+}
 
-    needed += p->offset + 1;
-    if (needed <= p->length)
-    {
-        return p->buffer + p->offset;
-    }
+static cJSON_Index *attach_index(cJSON * const item)
+{
+    cJSON_Index *index = item->index;
 
-    if (p->noalloc) {
+    if (item->internalflags & cJSON_FlagArena)
+    {
+        /* nothing may hang off arena items, they are released without being looked at */
         return NULL;
     }
 
-    /* calculate new buffer size */
-    if (needed > (INT_MAX / 2))
+    if (index == NULL)
     {
-        /* overflow of int, use INT_MAX if possible */
-        if (needed <= INT_MAX)
-        {
-            newsize = INT_MAX;
-        }
-        else
+        index = (cJSON_Index*)global_hooks.allocate(sizeof(cJSON_Index));
+        if (index == NULL)
         {
             return NULL;
         }
+        memset(index, '\0', sizeof(cJSON_Index));
+        item->index = index;
     }
-    else
-    {
-        newsize = needed * 2;
-    }
-
-    if (p->hooks.reallocate != NULL)
-    {
-        /* reallocate with realloc if available */
-        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
-        if (newbuffer == NULL)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
 
-            return NULL;
-        }
-    }
-    else
-    {
-        /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
-        if (!newbuffer)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
+    return index;
+}
 
-            return NULL;
-        }
+/* Slot of the key of element, or of the empty slot where it would go */
+static size_t index_find_key(const cJSON_Index * const index, const cJSON * const element, unsigned int * const hash)
+{
+    size_t slot = 0;
 
-        memcpy(newbuffer, p->buffer, p->offset + 1);
-        p->hooks.deallocate(p->buffer);
+    *hash = cJSON_HashKey(element->string, strlen(element->string));
+    slot = *hash & (index->capacity - 1);
+    while ((index->slots[slot] != NULL)
+            && ((index->hashes[slot] != *hash) || (strcmp(index->slots[slot]->string, element->string) != 0)))
+    {
+        slot = (slot + 1) & (index->capacity - 1);
     }
-    p->length = newsize;
-    p->buffer = newbuffer;
 
-    return newbuffer + p->offset;
+    return slot;
 }
 
-/* calculate the new length of the string in a printbuffer and update the offset */
-static void update_offset(printbuffer * const buffer)
+/* Put element into the key hash table, keys that are already there keep their first element like the linear walk */
+static void index_add_key(cJSON_Index * const index, cJSON * const element)
 {
-    const unsigned char *buffer_pointer = NULL;
-    if ((buffer == NULL) || (buffer->buffer == NULL))
+    unsigned int hash = 0;
+    size_t slot = 0;
+
+    if (element->string == NULL)
     {
         return;
     }
-    buffer_pointer = buffer->buffer + buffer->offset;
 
-    buffer->offset += strlen((const char*)buffer_pointer);
+    slot = index_find_key(index, element, &hash);
+    if (index->slots[slot] != NULL)
+    {
+        index->duplicates++;
+        return;
+    }
+    index->slots[slot] = element;
+    index->hashes[slot] = hash;
 }
 
-/* securely comparison of floating-point variables */
-static cJSON_bool compare_double(double a, double b)
+/* Take element out of the key hash table. Returns false if it isn't in there, as an earlier child has its key. */
+static cJSON_bool index_remove_key(cJSON_Index * const index, const cJSON * const element)
 {
-    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
-    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+    const size_t mask = index->capacity - 1;
+    unsigned int hash = 0;
+    size_t slot = index_find_key(index, element, &hash);
+    size_t next = slot;
+
+    if (index->slots[slot] != element)
+    {
+        return false;
+    }
+
+    /* move later entries of the probe sequence up into the gap, so lookups still reach them */
+    for (;;)
+    {
+        size_t home = 0;
+
+        next = (next + 1) & mask;
+        if (index->slots[next] == NULL)
+        {
+            break;
+        }
+        home = index->hashes[next] & mask;
+        if (((next > slot) && ((home <= slot) || (home > next))) || ((next < slot) && (home <= slot) && (home > next)))
+        {
+            index->slots[slot] = index->slots[next];
+            index->hashes[slot] = index->hashes[next];
+            slot = next;
+        }
+    }
+    index->slots[slot] = NULL;
+
+    return true;
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* (Re)build the key hash table of an object. Without memory the object is left without one and is walked. */
+static cJSON_bool build_keys(cJSON * const object)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
+    cJSON_Index *index = NULL;
+    cJSON *current_element = NULL;
+    size_t capacity = 1;
 
-    if (output_buffer == NULL)
+    /* keep the load factor at or below one half */
+    while (capacity < ((size_t)object->childcount * 2))
     {
-        return false;
+        capacity <<= 1;
     }
 
-    /* This checks for NaN and Infinity */
-    if (isnan(d) || isinf(d))
+    index = attach_index(object);
+    if (index == NULL)
     {
-        length = sprintf((char*)number_buffer, "null");
+        return false;
     }
-    else if(d == (double)item->valueint)
+    if (index->slots != NULL)
     {
-        length = sprintf((char*)number_buffer, "%d", item->valueint);
+        global_hooks.deallocate(index->slots);
     }
-    else
+    index->slots = (cJSON**)global_hooks.allocate(capacity * (sizeof(cJSON*) + sizeof(unsigned int)));
+    if (index->slots == NULL)
+    {
+        index->hashes = NULL;
+        index->capacity = 0;
+        return false;
+    }
+    index->capacity = capacity;
+    index->hashes = (unsigned int*)(index->slots + capacity);
+    index->duplicates = 0;
+    memset(index->slots, '\0', capacity * sizeof(cJSON*));
+
+    for (current_element = object->child; current_element != NULL; current_element = current_element->next)
+    {
+        index_add_key(index, current_element);
+    }
+
+    return true;
+}
+
+/* Bring the key hash table of an object (if it has one) up to date after its children changed: removed left them
+ * and added joined them, at the end if appended. Both may be NULL. Entries are changed in place, the table is only
+ * built again when it is full or when it isn't clear which of two children with the same key comes first. */
+static void update_keys(cJSON * const object, const cJSON * const removed, cJSON * const added, const cJSON_bool appended)
+{
+    cJSON_Index *index = object->index;
+    unsigned int hash = 0;
+    size_t slot = 0;
+
+    if ((index == NULL) || (index->slots == NULL))
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
+        return;
+    }
 
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
+    if ((removed != NULL) && (removed->string != NULL))
+    {
+        if (!index_remove_key(index, removed))
+        {
+            index->duplicates--;
+        }
+        else if (index->duplicates > 0)
         {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
+            /* a later child with the same key may have to take its place */
+            build_keys(object);
+            return;
         }
     }
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    if ((added == NULL) || (added->string == NULL))
     {
-        return false;
+        return;
+    }
+    if (((size_t)object->childcount * 2) > index->capacity)
+    {
+        build_keys(object);
+        return;
+    }
+    slot = index_find_key(index, added, &hash);
+    if (index->slots[slot] == NULL)
+    {
+        index->slots[slot] = added;
+        index->hashes[slot] = hash;
+    }
+    else if (appended)
+    {
+        index->duplicates++;
+    }
+    else if (index->slots[slot] != added)
+    {
+        /* which of the two comes first depends on where added went */
+        build_keys(object);
     }
+}
 
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
-    if (output_pointer == NULL)
+/* Give container a vector of its children for access by position */
+static cJSON_bool build_child_vector(cJSON * const container)
+{
+    cJSON_Index *index = attach_index(container);
+    cJSON *current_child = NULL;
+    size_t i = 0;
+
+    if (index == NULL)
     {
         return false;
     }
-
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+    if (index->items != NULL)
     {
-        if (number_buffer[i] == decimal_point)
-        {
-            output_pointer[i] = '.';
-            continue;
-        }
+        return true;
+    }
 
-        output_pointer[i] = number_buffer[i];
+    index->items = (cJSON**)global_hooks.allocate((size_t)container->childcount * sizeof(cJSON*));
+    if (index->items == NULL)
+    {
+        return false;
     }
-    output_pointer[i] = '\0';
+    index->items_capacity = (size_t)container->childcount;
 
-    output_buffer->offset += (size_t)length;
+    for (current_child = container->child; current_child != NULL; current_child = current_child->next)
+    {
+        index->items[i++] = current_child;
+    }
 
     return true;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *item)
 {
-    unsigned int h = 0;
-    size_t i = 0;
+    cJSON_bool success = true;
+    cJSON *child = NULL;
 
-    for (i = 0; i < 4; i++)
+    /* references share their children with another item that may change them, unparsed lazy arrays/objects
+     * have no children yet and arena items can't have anything hanging off them */
+    if ((item == NULL) || !(item->type & (cJSON_Array | cJSON_Object)) || (item->type & cJSON_IsReference)
+            || (item->internalflags & (cJSON_FlagLazy | cJSON_FlagArena)))
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
+        return true;
+    }
+
+    if (item->childcount >= CJSON_INDEX_THRESHOLD)
+    {
+        if (!build_child_vector(item))
         {
-            h += (unsigned int) input[i] - '0';
+            success = false;
         }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        if (((item->type & 0xFF) == cJSON_Object) && (item->index != NULL) && (item->index->slots == NULL) && !build_keys(item))
         {
-            h += (unsigned int) 10 + input[i] - 'A';
+            success = false;
         }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+    }
+
+    for (child = item->child; child != NULL; child = child->next)
+    {
+        if (!cJSON_BuildIndex(child))
         {
-            h += (unsigned int) 10 + input[i] - 'a';
+            success = false;
         }
-        else /* invalid */
+    }
+
+    return success;
+}
+
+/* Insert item at position into the child vector of container (if there is one).
+ * Has to be called before container->childcount is incremented. */
+static void index_insert(cJSON * const container, size_t position, cJSON * const item)
+{
+    cJSON_Index *index = container->index;
+    size_t count = (size_t)container->childcount;
+
+    if ((index == NULL) || (index->items == NULL))
+    {
+        return;
+    }
+
+    if (count >= index->items_capacity)
+    {
+        size_t new_capacity = (index->items_capacity > 0) ? (index->items_capacity * 2) : CJSON_INDEX_THRESHOLD;
+        cJSON **new_items = (cJSON**)global_hooks.allocate(new_capacity * sizeof(cJSON*));
+        if (new_items != NULL)
         {
-            return 0;
+            memcpy(new_items, index->items, count * sizeof(cJSON*));
         }
-
-        if (i < 3)
+        global_hooks.deallocate(index->items);
+        index->items = new_items;
+        index->items_capacity = new_capacity;
+        if (new_items == NULL)
         {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
+            /* fall back to walking the list */
+            index->items_capacity = 0;
+            return;
         }
     }
 
-    return h;
+    memmove(index->items + position + 1, index->items + position, (count - position) * sizeof(cJSON*));
+    index->items[position] = item;
 }
 
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+/* Find item in the child vector of container, returns the number of children if it isn't there */
+static size_t index_find(const cJSON_Index * const index, size_t count, const cJSON * const item)
 {
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
+    size_t position = 0;
 
-    if ((input_end - first_sequence) < 6)
+    while ((position < count) && (index->items[position] != item))
     {
-        /* input ends unexpectedly */
-        goto fail;
+        position++;
     }
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
+    return position;
+}
 
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+/* Remove item from the child vector of container (if there is one).
+ * Has to be called before container->childcount is decremented. */
+static void index_remove(cJSON * const container, const cJSON * const item)
+{
+    cJSON_Index *index = container->index;
+    size_t count = (size_t)container->childcount;
+    size_t position = 0;
+
+    if ((index == NULL) || (index->items == NULL))
     {
-        goto fail;
+        return;
     }
 
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    position = index_find(index, count, item);
+    if (position < count)
     {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
-
-        if ((input_end - second_sequence) < 6)
-        {
-            /* input ends unexpectedly */
-            goto fail;
-        }
-
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
-        {
-            /* missing second half of the surrogate pair */
-            goto fail;
-        }
-
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
-        {
-            /* invalid second half of the surrogate pair */
-            goto fail;
-        }
+        memmove(index->items + position, index->items + position + 1, (count - position - 1) * sizeof(cJSON*));
+    }
+}
 
+static void index_replace(cJSON * const container, const cJSON * const item, cJSON * const replacement)
+{
+    cJSON_Index *index = container->index;
+    size_t count = (size_t)container->childcount;
+    size_t position = 0;
 
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
-    }
-    else
+    if ((index == NULL) || (index->items == NULL))
     {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
+        return;
     }
 
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80)
-    {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
-    }
-    else if (codepoint < 0x800)
-    {
-        /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
-    }
-    else if (codepoint < 0x10000)
-    {
-        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 3;
-        first_byte_mark = 0xE0; /* 11100000 */
-    }
-    else if (codepoint <= 0x10FFFF)
-    {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
-    }
-    else
+    position = index_find(index, count, item);
+    if (position < count)
     {
-        /* invalid unicode codepoint */
-        goto fail;
+        index->items[position] = replacement;
     }
+}
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
-    {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
-    }
-    /* encode first byte */
-    if (utf8_length > 1)
+/* Number of children of an array or object. References don't keep a count, the list they share belongs to another
+ * item and can change behind their back, so it is walked. */
+static int child_count(const cJSON * const item)
+{
+    const cJSON *child = NULL;
+    int count = 0;
+
+    if (!(item->type & cJSON_IsReference))
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        return item->childcount;
     }
-    else
+
+    for (child = item->child; child != NULL; child = child->next)
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        count++;
     }
 
-    *output_pointer += utf8_length;
-
-    return sequence_length;
-
-fail:
-    return 0;
+    return count;
 }
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+/* Delete a tree whose items and strings came from hooks. Children are spliced in front of the remaining siblings
+ * instead of recursing, so deep trees don't need a deep stack. */
+static void delete_item(cJSON *item, const internal_hooks * const hooks)
 {
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
-    unsigned char *output_pointer = NULL;
-    unsigned char *output = NULL;
-
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"')
-    {
-        goto fail;
-    }
-
+    cJSON *next = NULL;
+    while (item != NULL)
     {
-        /* calculate approximate size of the output (overestimate) */
-        size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        next = item->next;
+        if (item->internalflags & cJSON_FlagArena)
         {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
+            /* released with its arena */
+            item = next;
+            continue;
+        }
+        free_index(item);
+        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
+        {
+            /* the head of a child list points back at its last element */
+            cJSON *last_child = item->child->prev;
+            if ((last_child == NULL) || (last_child->next != NULL))
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
+                last_child = item->child;
+                while (last_child->next != NULL)
                 {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
+                    last_child = last_child->next;
                 }
-                skipped_bytes++;
-                input_end++;
             }
-            input_end++;
+            last_child->next = next;
+            next = item->child;
         }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+        if (!(item->type & cJSON_IsReference) && !(item->internalflags & cJSON_FlagLazy) && (item->valuestring != NULL))
         {
-            goto fail; /* string ended unexpectedly */
+            hooks->deallocate(item->valuestring);
+            item->valuestring = NULL;
         }
-
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
         {
-            goto fail; /* allocation failure */
+            hooks->deallocate(item->string);
+            item->string = NULL;
         }
+        cJSON_Free_Item(item, hooks);
+        item = next;
     }
+}
 
-    output_pointer = output;
-    /* loop through the string literal */
-    while (input_pointer < input_end)
+/* Delete a cJSON structure. */
+CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+{
+    delete_item(item, &global_hooks);
+}
+
+/* get the decimal point character of the current locale */
+static unsigned char get_decimal_point(void)
+{
+#ifdef ENABLE_LOCALES
+    struct lconv *lconv = localeconv();
+    return (unsigned char) lconv->decimal_point[0];
+#else
+    return '.';
+#endif
+}
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+    size_t max_depth; /* arrays/objects nested deeper than this are rejected */
+    cJSON_bool pooled; /* items may come from the global node pool */
+    cJSON_Arena *arena; /* if set, items and strings come from here instead of the hooks */
+    cJSON_bool lazy; /* nested arrays/objects are only skimmed, see cJSON_ParseLazy */
+    const struct parallel_plan *parallel; /* the array to parse on several threads, see cJSON_ParseParallel */
+    struct parse_recycler *recycler; /* old items and strings to reuse, see cJSON_ParseInto */
+    internal_hooks hooks;
+} parse_buffer;
+
+/* check if the given size is left to read in a given parse buffer (starting with 1) */
+#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+/* check if the buffer can be accessed at the given index (starting with 0) */
+#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+
+/* What is left of the tree cJSON_ParseInto parses into */
+typedef struct parse_recycler
+{
+    /* items in the order a parse allocates them, linked through next */
+    cJSON *items;
+    /* strings of the item that was handed out last, for the next key and string value */
+    char *key;
+    char *value;
+} parse_recycler;
+
+/* Take tree apart into a list of its items in the order a parse allocates them, which is the order delete_item
+ * walks them in. Items keep only the strings they own. */
+static cJSON *recycle_tree(cJSON * const tree)
+{
+    cJSON *previous = NULL;
+    cJSON *item = tree;
+
+    tree->next = NULL;
+    while (item != NULL)
     {
-        if (*input_pointer != '\\')
+        if (item->internalflags & cJSON_FlagArena)
         {
-            *output_pointer++ = *input_pointer++;
+            /* released with its arena, the root is never one */
+            previous->next = item->next;
+            item = item->next;
+            continue;
         }
-        /* escape sequence */
-        else
+        free_index(item);
+        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
         {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1)
-            {
-                goto fail;
-            }
-
-            switch (input_pointer[1])
+            /* the head of a child list points back at its last element */
+            cJSON *last_child = item->child->prev;
+            if ((last_child == NULL) || (last_child->next != NULL))
             {
-                case 'b':
-                    *output_pointer++ = '\b';
-                    break;
-                case 'f':
-                    *output_pointer++ = '\f';
-                    break;
-                case 'n':
-                    *output_pointer++ = '\n';
-                    break;
-                case 'r':
-                    *output_pointer++ = '\r';
-                    break;
-                case 't':
-                    *output_pointer++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *output_pointer++ = input_pointer[1];
-                    break;
-
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
-                    if (sequence_length == 0)
-                    {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        goto fail;
-                    }
-                    break;
-
-                default:
-                    goto fail;
+                last_child = item->child;
+                while (last_child->next != NULL)
+                {
+                    last_child = last_child->next;
+                }
             }
-            input_pointer += sequence_length;
+            last_child->next = item->next;
+            item->next = item->child;
+        }
+        item->child = NULL;
+        if ((item->type & cJSON_IsReference) || (item->internalflags & cJSON_FlagLazy))
+        {
+            item->valuestring = NULL;
         }
+        if (item->type & cJSON_StringIsConst)
+        {
+            item->string = NULL;
+        }
+        previous = item;
+        item = item->next;
     }
 
-    /* zero terminate the output */
-    *output_pointer = '\0';
-
-    item->type = cJSON_String;
-    item->valuestring = (char*)output;
-
-    input_buffer->offset = (size_t) (input_end - input_buffer->content);
-    input_buffer->offset++;
-
-    return true;
+    return tree;
+}
 
-fail:
-    if (output != NULL)
+static void recycler_release_strings(parse_recycler * const recycler, const internal_hooks * const hooks)
+{
+    if (recycler->key != NULL)
     {
-        input_buffer->hooks.deallocate(output);
-        output = NULL;
+        hooks->deallocate(recycler->key);
+        recycler->key = NULL;
     }
-
-    if (input_pointer != NULL)
+    if (recycler->value != NULL)
     {
-        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+        hooks->deallocate(recycler->value);
+        recycler->value = NULL;
     }
+}
 
-    return false;
+/* Hand out the next old item, its strings wait for the key and value of the new one */
+static cJSON *recycle_item(const parse_buffer * const buffer)
+{
+    parse_recycler * const recycler = buffer->recycler;
+    cJSON *item = recycler->items;
+    int pooled = item->internalflags & cJSON_FlagPooled;
+
+    recycler->items = item->next;
+    recycler_release_strings(recycler, &buffer->hooks);
+    recycler->key = item->string;
+    recycler->value = item->valuestring;
+
+    memset(item, '\0', sizeof(cJSON));
+    item->internalflags = pooled;
+
+    return item;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+/* Memory for a string that is parsed into item and takes at most size bytes with its terminator, reused from the
+ * recycled strings if one is long enough. Keys come first, so a string for an item without a key yet is a key or an
+ * array element. */
+static unsigned char *parse_allocate_string(const parse_buffer * const buffer, const cJSON * const item, const size_t size)
 {
-    const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
+    char **first = NULL;
+    char **second = NULL;
+    char *output = NULL;
 
-    if (output_buffer == NULL)
+    if (buffer->arena != NULL)
     {
-        return false;
+        return (unsigned char*)arena_allocate(buffer->arena, size);
     }
 
-    /* empty string */
-    if (input == NULL)
+    if (buffer->recycler != NULL)
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
+        first = (item->string == NULL) ? &buffer->recycler->key : &buffer->recycler->value;
+        second = (item->string == NULL) ? &buffer->recycler->value : &buffer->recycler->key;
+        if ((*first != NULL) && ((strlen(*first) + sizeof("")) >= size))
         {
-            return false;
+            output = *first;
+            *first = NULL;
+            return (unsigned char*)output;
+        }
+        if ((*second != NULL) && ((strlen(*second) + sizeof("")) >= size))
+        {
+            output = *second;
+            *second = NULL;
+            return (unsigned char*)output;
         }
-        strcpy((char*)output, "\"\"");
-
-        return true;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    output = (char*)buffer->hooks.allocate(size);
+    if ((output != NULL) && buffer->pooled)
     {
-        switch (*input_pointer)
-        {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
-                break;
-            default:
-                if (*input_pointer < 32)
-                {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
-                }
-                break;
-        }
+        count_string_allocation();
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
 
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
-    if (output == NULL)
+    return (unsigned char*)output;
+}
+
+/* items of a parse with its own context never touch the shared node pool */
+static cJSON *parse_new_item(const parse_buffer * const buffer)
+{
+    cJSON *item = NULL;
+
+    if ((buffer->recycler != NULL) && (buffer->recycler->items != NULL))
     {
-        return false;
+        return recycle_item(buffer);
     }
 
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
+    if (buffer->arena == NULL)
     {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
-
-        return true;
+        return buffer->pooled ? cJSON_New_Item(&buffer->hooks) : allocate_item(&buffer->hooks);
     }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    item = (cJSON*)arena_allocate(buffer->arena, sizeof(cJSON));
+    if (item != NULL)
     {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
-        {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
-        }
-        else
-        {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
-            }
-        }
+        memset(item, '\0', sizeof(cJSON));
+        item->internalflags = cJSON_FlagArena;
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
-
-    return true;
-}
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
-{
-    return print_string_ptr((unsigned char*)item->valuestring, p);
+    return item;
 }
 
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
-
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+/* valuedouble saturated to 64 bits, like valueint */
+static cJSON_int64 double_to_int64(const double number)
 {
-    if ((buffer == NULL) || (buffer->content == NULL))
-    {
-        return NULL;
-    }
-
-    if (cannot_access_at_index(buffer, 0))
+    /* both bounds are exactly +-2^63 as doubles */
+    if (number >= 9223372036854775807.0)
     {
-        return buffer;
+        return CJSON_INT64_MAX;
     }
-
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    if (number <= -9223372036854775807.0)
     {
-       buffer->offset++;
+        return CJSON_INT64_MIN;
     }
-
-    if (buffer->offset == buffer->length)
+    if (isnan(number))
     {
-        buffer->offset--;
+        return 0;
     }
 
-    return buffer;
+    return (cJSON_int64)number;
 }
 
-/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
-static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+/* set all number fields of item from an exact integer */
+static void set_int64(cJSON * const item, const cJSON_int64 integer)
 {
-    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    item->valueint64 = integer;
+    item->valuedouble = (double)integer;
+    if (integer >= INT_MAX)
     {
-        return NULL;
+        item->valueint = INT_MAX;
     }
-
-    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    else if (integer <= INT_MIN)
     {
-        buffer->offset += 3;
+        item->valueint = INT_MIN;
     }
-
-    return buffer;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
-{
-    size_t buffer_length;
-
-    if (NULL == value)
+    else
     {
-        return NULL;
+        item->valueint = (int)integer;
     }
-
-    /* Adding null character size due to require_null_terminated. */
-    buffer_length = strlen(value) + sizeof("");
-
-    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    item->internalflags |= cJSON_FlagInt64;
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Integer fast path: an optional minus and at most 19 digits that fit into 64 bits, converted without strtod */
+static cJSON_bool parse_int64(const unsigned char * const input, const size_t length, cJSON_int64 * const integer)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
-    cJSON *item = NULL;
+    cjson_uint64 magnitude = 0;
+    const cJSON_bool negative = (length > 0) && (input[0] == '-');
+    size_t i = negative ? 1 : 0;
 
-    /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
-
-    if (value == NULL || 0 == buffer_length)
+    if ((length == i) || ((length - i) > 19))
     {
-        goto fail;
+        return false;
     }
-
-    buffer.content = (const unsigned char*)value;
-    buffer.length = buffer_length;
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
-
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    for (; i < length; i++)
     {
-        goto fail;
+        if ((input[i] < '0') || (input[i] > '9'))
+        {
+            return false;
+        }
+        magnitude = (magnitude * 10) + (cjson_uint64)(input[i] - '0');
     }
 
-    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    if (magnitude > ((cjson_uint64)CJSON_INT64_MAX + (negative ? 1 : 0)))
     {
-        /* parse failure. ep is set. */
-        goto fail;
+        return false;
     }
-
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    if (negative && (magnitude > 0))
     {
-        buffer_skip_whitespace(&buffer);
-        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
-        {
-            goto fail;
-        }
+        /* -2^63 can't be negated as a positive cJSON_int64 */
+        *integer = -(cJSON_int64)(magnitude - 1) - 1;
     }
-    if (return_parse_end)
+    else
     {
-        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+        *integer = (cJSON_int64)magnitude;
     }
 
-    return item;
+    return true;
+}
 
-fail:
-    if (item != NULL)
+/* Parse the input text to generate a number, and populate the result into item. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    unsigned char *after_end = NULL;
+    unsigned char *number_c_string;
+    unsigned char number_buffer[64]; /* numbers are short, avoid the allocation for them */
+    unsigned char decimal_point = get_decimal_point();
+    size_t i = 0;
+    size_t number_string_length = 0;
+    cJSON_bool has_decimal_point = false;
+    cJSON_int64 integer = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
-        cJSON_Delete(item);
+        return false;
     }
 
-    if (value != NULL)
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    for (i = 0; can_access_at_index(input_buffer, i); i++)
     {
-        error local_error;
-        local_error.json = (const unsigned char*)value;
-        local_error.position = 0;
-
-        if (buffer.offset < buffer.length)
-        {
-            local_error.position = buffer.offset;
-        }
-        else if (buffer.length > 0)
+        switch (buffer_at_offset(input_buffer)[i])
         {
-            local_error.position = buffer.length - 1;
-        }
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+                number_string_length++;
+                break;
 
-        if (return_parse_end != NULL)
-        {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
-        }
+            case '.':
+                number_string_length++;
+                has_decimal_point = true;
+                break;
 
-        global_error = local_error;
+            default:
+                goto loop_end;
+        }
     }
-
-    return NULL;
-}
-
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
-{
-    return cJSON_ParseWithOpts(value, 0, 0);
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
-{
-    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
-}
-
-#define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
-
-static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
-{
-    static const size_t default_buffer_size = 256;
-    printbuffer buffer[1];
-    unsigned char *printed = NULL;
-
-    memset(buffer, 0, sizeof(buffer));
-
-    /* create buffer */
-    buffer->buffer = (unsigned char*) hooks->allocate(default_buffer_size);
-    buffer->length = default_buffer_size;
-    buffer->format = format;
-    buffer->hooks = *hooks;
-    if (buffer->buffer == NULL)
+loop_end:
+    if (!has_decimal_point && parse_int64(buffer_at_offset(input_buffer), number_string_length, &integer))
     {
-        goto fail;
+        set_int64(item, integer);
+        if ((integer == 0) && (buffer_at_offset(input_buffer)[0] == '-'))
+        {
+            /* -0 like strtod */
+            item->valuedouble = -item->valuedouble;
+        }
+        item->type = cJSON_Number;
+        input_buffer->offset += number_string_length;
+        return true;
     }
 
-    /* print the value */
-    if (!print_value(item, buffer))
+    number_c_string = number_buffer;
+    if (number_string_length >= sizeof(number_buffer))
     {
-        goto fail;
+        /* malloc for temporary buffer, add 1 for '\0' */
+        number_c_string = (unsigned char *) input_buffer->hooks.allocate(number_string_length + 1);
+        if (number_c_string == NULL)
+        {
+            return false; /* allocation failure */
+        }
+        if (input_buffer->pooled)
+        {
+            count_string_allocation();
+        }
     }
-    update_offset(buffer);
 
-    /* check if reallocate is available */
-    if (hooks->reallocate != NULL)
+    memcpy(number_c_string, buffer_at_offset(input_buffer), number_string_length);
+    number_c_string[number_string_length] = '\0';
+
+    if (has_decimal_point)
     {
-        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->offset + 1);
-        if (printed == NULL) {
-            goto fail;
+        for (i = 0; i < number_string_length; i++)
+        {
+            if (number_c_string[i] == '.')
+            {
+                /* replace '.' with the decimal point of the current locale (for strtod) */
+                number_c_string[i] = decimal_point;
+            }
         }
-        buffer->buffer = NULL;
     }
-    else /* otherwise copy the JSON over to a new buffer */
+
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
     {
-        printed = (unsigned char*) hooks->allocate(buffer->offset + 1);
-        if (printed == NULL)
+        /* free the temporary buffer */
+        if (number_c_string != number_buffer)
         {
-            goto fail;
+            input_buffer->hooks.deallocate(number_c_string);
         }
-        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
-        printed[buffer->offset] = '\0'; /* just to be sure */
-
-        /* free the buffer */
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
+        return false; /* parse_error */
     }
 
-    return printed;
+    item->valuedouble = number;
+    item->valueint64 = double_to_int64(number);
+    item->internalflags &= ~cJSON_FlagInt64;
 
-fail:
-    if (buffer->buffer != NULL)
-    {
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
+    {
+        item->valueint = INT_MAX;
     }
-
-    if (printed != NULL)
+    else if (number <= (double)INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
     {
-        hooks->deallocate(printed);
-        printed = NULL;
+        item->valueint = (int)number;
     }
 
-    return NULL;
+    item->type = cJSON_Number;
+
+    input_buffer->offset += (size_t)(after_end - number_c_string);
+    /* free the temporary buffer */
+    if (number_c_string != number_buffer)
+    {
+        input_buffer->hooks.deallocate(number_c_string);
+    }
+    return true;
 }
 
-/* Render a cJSON item/entity/structure to text. */
-CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
 {
-    return (char*)print(item, true, &global_hooks);
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+    object->valueint64 = double_to_int64(number);
+    object->internalflags &= ~cJSON_FlagInt64;
+
+    return object->valuedouble = number;
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+CJSON_PUBLIC(cJSON_int64) cJSON_SetInt64Value(cJSON *object, cJSON_int64 number)
 {
-    return (char*)print(item, false, &global_hooks);
+    if (object != NULL)
+    {
+        set_int64(object, number);
+    }
+
+    return number;
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
+/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
+CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
-
-    if (prebuffer < 0)
+    char *copy = NULL;
+    size_t v1_len;
+    size_t v2_len;
+    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
+    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
     {
         return NULL;
     }
-
-    p.buffer = (unsigned char*)global_hooks.allocate((size_t)prebuffer);
-    if (!p.buffer)
+    /* return NULL if the object is corrupted or valuestring is NULL */
+    if (object->valuestring == NULL || valuestring == NULL)
     {
         return NULL;
     }
 
-    p.length = (size_t)prebuffer;
-    p.offset = 0;
-    p.noalloc = false;
-    p.format = fmt;
-    p.hooks = global_hooks;
+    v1_len = strlen(valuestring);
+    v2_len = strlen(object->valuestring);
 
-    if (!print_value(item, &p))
+    if (v1_len <= v2_len)
+    {
+        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
+        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
+        {
+            return NULL;
+        }
+        strcpy(object->valuestring, valuestring);
+        return object->valuestring;
+    }
+    if (object->internalflags & cJSON_FlagArena)
+    {
+        /* a copy from the hooks wouldn't be released with the arena */
+        return NULL;
+    }
+    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
+    if (copy == NULL)
     {
-        global_hooks.deallocate(p.buffer);
-        p.buffer = NULL;
         return NULL;
     }
+    if (object->valuestring != NULL)
+    {
+        cJSON_free(object->valuestring);
+    }
+    object->valuestring = copy;
 
-    return (char*)p.buffer;
+    return copy;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
+typedef struct
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t depth; /* current nesting depth (for formatted printing) */
+    cJSON_bool noalloc;
+    cJSON_bool format; /* is this print a formatted print */
+    internal_hooks hooks;
+} printbuffer;
 
-    if ((length < 0) || (buffer == NULL))
+/* realloc printbuffer if necessary to have at least "needed" bytes more */
+static unsigned char* ensure(printbuffer * const p, size_t needed)
+{
+    unsigned char *newbuffer = NULL;
+    size_t newsize = 0;
+
+    if ((p == NULL) || (p->buffer == NULL))
     {
-        return false;
+        return NULL;
     }
 
-    p.buffer = (unsigned char*)buffer;
-    p.length = (size_t)length;
-    p.offset = 0;
-    p.noalloc = true;
-    p.format = format;
-    p.hooks = global_hooks;
+    if ((p->length > 0) && (p->offset > p->length))
+    {
+        /* make sure that offset is valid */
+        return NULL;
+    }
 
-    return print_value(item, &p);
-}
+    if (needed > INT_MAX)
+    {
+        /* sizes bigger than INT_MAX are currently not supported */
+        return NULL;
+    }
 
-/* Parser core - when encountering text, process appropriately. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
-{
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    needed += p->offset;
+    if (needed <= p->length)
     {
-        return false; /* no input */
+        return p->buffer + p->offset;
     }
 
-    /* parse the different types of values */
-    /* null */
-    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+    if (p->noalloc) {
+        return NULL;
+    }
+
+    /* calculate new buffer size */
+    if (needed > (INT_MAX / 2))
     {
-        item->type = cJSON_NULL;
-        input_buffer->offset += 4;
-        return true;
+        /* overflow of int, use INT_MAX if possible */
+        if (needed <= INT_MAX)
+        {
+            newsize = INT_MAX;
+        }
+        else
+        {
+            return NULL;
+        }
     }
-    /* false */
-    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    else
     {
-        item->type = cJSON_False;
-        input_buffer->offset += 5;
-        return true;
+        newsize = needed * 2;
     }
-    /* true */
-    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+
+    if (p->hooks.reallocate != NULL)
     {
-        item->type = cJSON_True;
-        item->valueint = 1;
-        input_buffer->offset += 4;
-        return true;
+        /* reallocate with realloc if available */
+        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
+        if (newbuffer == NULL)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
     }
-    /* string */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+    else
     {
-        return parse_string(item, input_buffer);
+        /* otherwise reallocate manually */
+        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
+        if (!newbuffer)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+
+        memcpy(newbuffer, p->buffer, p->offset);
+        p->hooks.deallocate(p->buffer);
     }
-    /* number */
-    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
+    p->length = newsize;
+    p->buffer = newbuffer;
+
+    return newbuffer + p->offset;
+}
+
+/* calculate the new length of the string in a printbuffer and update the offset */
+static void update_offset(printbuffer * const buffer)
+{
+    const unsigned char *buffer_pointer = NULL;
+    if ((buffer == NULL) || (buffer->buffer == NULL))
     {
-        return parse_number(item, input_buffer);
+        return;
     }
-    /* array */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    buffer_pointer = buffer->buffer + buffer->offset;
+
+    buffer->offset += strlen((const char*)buffer_pointer);
+}
+
+/* securely comparison of floating-point variables */
+static cJSON_bool compare_double(double a, double b)
+{
+    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+}
+
+/* "Do it yourself" floating point number f * 2^e used by Grisu2,
+ * see "Printing Floating-Point Numbers Quickly and Accurately with Integers" by Florian Loitsch */
+typedef struct
+{
+    cjson_uint64 f;
+    int e;
+} diy_fp;
+
+#define DOUBLE_SIGNIFICAND_SIZE 52
+#define DOUBLE_EXPONENT_BIAS (0x3FF + DOUBLE_SIGNIFICAND_SIZE)
+#define DOUBLE_HIDDEN_BIT CJSON_UINT64_C(0x00100000, 0x00000000)
+#define DOUBLE_SIGNIFICAND_MASK CJSON_UINT64_C(0x000FFFFF, 0xFFFFFFFF)
+#define DOUBLE_EXPONENT_MASK CJSON_UINT64_C(0x7FF00000, 0x00000000)
+
+/* normalized powers of ten 10^-348, 10^-340, ..., 10^340 */
+static const cjson_uint64 cached_powers_f[] =
+{
+    CJSON_UINT64_C(0xfa8fd5a0, 0x081c0288), CJSON_UINT64_C(0xbaaee17f, 0xa23ebf76), CJSON_UINT64_C(0x8b16fb20, 0x3055ac76),
+    CJSON_UINT64_C(0xcf42894a, 0x5dce35ea), CJSON_UINT64_C(0x9a6bb0aa, 0x55653b2d), CJSON_UINT64_C(0xe61acf03, 0x3d1a45df),
+    CJSON_UINT64_C(0xab70fe17, 0xc79ac6ca), CJSON_UINT64_C(0xff77b1fc, 0xbebcdc4f), CJSON_UINT64_C(0xbe5691ef, 0x416bd60c),
+    CJSON_UINT64_C(0x8dd01fad, 0x907ffc3c), CJSON_UINT64_C(0xd3515c28, 0x31559a83), CJSON_UINT64_C(0x9d71ac8f, 0xada6c9b5),
+    CJSON_UINT64_C(0xea9c2277, 0x23ee8bcb), CJSON_UINT64_C(0xaecc4991, 0x4078536d), CJSON_UINT64_C(0x823c1279, 0x5db6ce57),
+    CJSON_UINT64_C(0xc2109436, 0x4dfb5637), CJSON_UINT64_C(0x9096ea6f, 0x3848984f), CJSON_UINT64_C(0xd77485cb, 0x25823ac7),
+    CJSON_UINT64_C(0xa086cfcd, 0x97bf97f4), CJSON_UINT64_C(0xef340a98, 0x172aace5), CJSON_UINT64_C(0xb23867fb, 0x2a35b28e),
+    CJSON_UINT64_C(0x84c8d4df, 0xd2c63f3b), CJSON_UINT64_C(0xc5dd4427, 0x1ad3cdba), CJSON_UINT64_C(0x936b9fce, 0xbb25c996),
+    CJSON_UINT64_C(0xdbac6c24, 0x7d62a584), CJSON_UINT64_C(0xa3ab6658, 0x0d5fdaf6), CJSON_UINT64_C(0xf3e2f893, 0xdec3f126),
+    CJSON_UINT64_C(0xb5b5ada8, 0xaaff80b8), CJSON_UINT64_C(0x87625f05, 0x6c7c4a8b), CJSON_UINT64_C(0xc9bcff60, 0x34c13053),
+    CJSON_UINT64_C(0x964e858c, 0x91ba2655), CJSON_UINT64_C(0xdff97724, 0x70297ebd), CJSON_UINT64_C(0xa6dfbd9f, 0xb8e5b88f),
+    CJSON_UINT64_C(0xf8a95fcf, 0x88747d94), CJSON_UINT64_C(0xb9447093, 0x8fa89bcf), CJSON_UINT64_C(0x8a08f0f8, 0xbf0f156b),
+    CJSON_UINT64_C(0xcdb02555, 0x653131b6), CJSON_UINT64_C(0x993fe2c6, 0xd07b7fac), CJSON_UINT64_C(0xe45c10c4, 0x2a2b3b06),
+    CJSON_UINT64_C(0xaa242499, 0x697392d3), CJSON_UINT64_C(0xfd87b5f2, 0x8300ca0e), CJSON_UINT64_C(0xbce50864, 0x92111aeb),
+    CJSON_UINT64_C(0x8cbccc09, 0x6f5088cc), CJSON_UINT64_C(0xd1b71758, 0xe219652c), CJSON_UINT64_C(0x9c400000, 0x00000000),
+    CJSON_UINT64_C(0xe8d4a510, 0x00000000), CJSON_UINT64_C(0xad78ebc5, 0xac620000), CJSON_UINT64_C(0x813f3978, 0xf8940984),
+    CJSON_UINT64_C(0xc097ce7b, 0xc90715b3), CJSON_UINT64_C(0x8f7e32ce, 0x7bea5c70), CJSON_UINT64_C(0xd5d238a4, 0xabe98068),
+    CJSON_UINT64_C(0x9f4f2726, 0x179a2245), CJSON_UINT64_C(0xed63a231, 0xd4c4fb27), CJSON_UINT64_C(0xb0de6538, 0x8cc8ada8),
+    CJSON_UINT64_C(0x83c7088e, 0x1aab65db), CJSON_UINT64_C(0xc45d1df9, 0x42711d9a), CJSON_UINT64_C(0x924d692c, 0xa61be758),
+    CJSON_UINT64_C(0xda01ee64, 0x1a708dea), CJSON_UINT64_C(0xa26da399, 0x9aef774a), CJSON_UINT64_C(0xf209787b, 0xb47d6b85),
+    CJSON_UINT64_C(0xb454e4a1, 0x79dd1877), CJSON_UINT64_C(0x865b8692, 0x5b9bc5c2), CJSON_UINT64_C(0xc83553c5, 0xc8965d3d),
+    CJSON_UINT64_C(0x952ab45c, 0xfa97a0b3), CJSON_UINT64_C(0xde469fbd, 0x99a05fe3), CJSON_UINT64_C(0xa59bc234, 0xdb398c25),
+    CJSON_UINT64_C(0xf6c69a72, 0xa3989f5c), CJSON_UINT64_C(0xb7dcbf53, 0x54e9bece), CJSON_UINT64_C(0x88fcf317, 0xf22241e2),
+    CJSON_UINT64_C(0xcc20ce9b, 0xd35c78a5), CJSON_UINT64_C(0x98165af3, 0x7b2153df), CJSON_UINT64_C(0xe2a0b5dc, 0x971f303a),
+    CJSON_UINT64_C(0xa8d9d153, 0x5ce3b396), CJSON_UINT64_C(0xfb9b7cd9, 0xa4a7443c), CJSON_UINT64_C(0xbb764c4c, 0xa7a44410),
+    CJSON_UINT64_C(0x8bab8eef, 0xb6409c1a), CJSON_UINT64_C(0xd01fef10, 0xa657842c), CJSON_UINT64_C(0x9b10a4e5, 0xe9913129),
+    CJSON_UINT64_C(0xe7109bfb, 0xa19c0c9d), CJSON_UINT64_C(0xac2820d9, 0x623bf429), CJSON_UINT64_C(0x80444b5e, 0x7aa7cf85),
+    CJSON_UINT64_C(0xbf21e440, 0x03acdd2d), CJSON_UINT64_C(0x8e679c2f, 0x5e44ff8f), CJSON_UINT64_C(0xd433179d, 0x9c8cb841),
+    CJSON_UINT64_C(0x9e19db92, 0xb4e31ba9), CJSON_UINT64_C(0xeb96bf6e, 0xbadf77d9), CJSON_UINT64_C(0xaf87023b, 0x9bf0ee6b)
+};
+static const short cached_powers_e[] =
+{
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const cjson_uint64 powers_of_ten[] =
+{
+    CJSON_UINT64_C(0, 1), CJSON_UINT64_C(0, 10), CJSON_UINT64_C(0, 100), CJSON_UINT64_C(0, 1000),
+    CJSON_UINT64_C(0, 10000), CJSON_UINT64_C(0, 100000), CJSON_UINT64_C(0, 1000000), CJSON_UINT64_C(0, 10000000),
+    CJSON_UINT64_C(0, 100000000), CJSON_UINT64_C(0, 1000000000), CJSON_UINT64_C(0x00000002, 0x540be400),
+    CJSON_UINT64_C(0x00000017, 0x4876e800), CJSON_UINT64_C(0x000000e8, 0xd4a51000), CJSON_UINT64_C(0x00000918, 0x4e72a000),
+    CJSON_UINT64_C(0x00005af3, 0x107a4000), CJSON_UINT64_C(0x00038d7e, 0xa4c68000), CJSON_UINT64_C(0x002386f2, 0x6fc10000),
+    CJSON_UINT64_C(0x01634578, 0x5d8a0000), CJSON_UINT64_C(0x0de0b6b3, 0xa7640000), CJSON_UINT64_C(0x8ac72304, 0x89e80000)
+};
+
+static diy_fp diy_fp_from_double(double number)
+{
+    diy_fp result;
+    cjson_uint64 bits = 0;
+    int biased_exponent = 0;
+    cjson_uint64 significand = 0;
+
+    memcpy(&bits, &number, sizeof(bits));
+    biased_exponent = (int)((bits & DOUBLE_EXPONENT_MASK) >> DOUBLE_SIGNIFICAND_SIZE);
+    significand = bits & DOUBLE_SIGNIFICAND_MASK;
+    if (biased_exponent != 0)
     {
-        return parse_array(item, input_buffer);
+        result.f = significand + DOUBLE_HIDDEN_BIT;
+        result.e = biased_exponent - DOUBLE_EXPONENT_BIAS;
     }
-    /* object */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    else
     {
-        return parse_object(item, input_buffer);
+        /* subnormal */
+        result.f = significand;
+        result.e = 1 - DOUBLE_EXPONENT_BIAS;
     }
 
-    return false;
+    return result;
 }
 
-/* Render a value to text. */
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+static diy_fp diy_fp_multiply(const diy_fp x, const diy_fp y)
 {
-    unsigned char *output = NULL;
+    const cjson_uint64 mask = CJSON_UINT64_C(0, 0xFFFFFFFF);
+    const cjson_uint64 a = x.f >> 32;
+    const cjson_uint64 b = x.f & mask;
+    const cjson_uint64 c = y.f >> 32;
+    const cjson_uint64 d = y.f & mask;
+    const cjson_uint64 ac = a * c;
+    const cjson_uint64 bc = b * c;
+    const cjson_uint64 ad = a * d;
+    const cjson_uint64 bd = b * d;
+    cjson_uint64 middle = (bd >> 32) + (ad & mask) + (bc & mask);
+    diy_fp result;
+
+    /* round the lower half */
+    middle += CJSON_UINT64_C(0, 0x80000000);
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+
+    return result;
+}
 
-    if ((item == NULL) || (output_buffer == NULL))
+static diy_fp diy_fp_normalize(diy_fp number)
+{
+    while ((number.f & CJSON_UINT64_C(0x80000000, 0x00000000)) == 0)
     {
-        return false;
+        number.f <<= 1;
+        number.e--;
     }
 
-    switch ((item->type) & 0xFF)
+    return number;
+}
+
+/* get the boundaries m- and m+ halfway to the neighbouring doubles, with the exponent of m+ */
+static void normalized_boundaries(const diy_fp value, diy_fp * const minus, diy_fp * const plus)
+{
+    diy_fp upper;
+    diy_fp lower;
+
+    upper.f = (value.f << 1) + 1;
+    upper.e = value.e - 1;
+    while ((upper.f & (DOUBLE_HIDDEN_BIT << 1)) == 0)
     {
-        case cJSON_NULL:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "null");
-            return true;
+        upper.f <<= 1;
+        upper.e--;
+    }
+    upper.f <<= 64 - DOUBLE_SIGNIFICAND_SIZE - 2;
+    upper.e -= 64 - DOUBLE_SIGNIFICAND_SIZE - 2;
 
-        case cJSON_False:
-            output = ensure(output_buffer, 6);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "false");
-            return true;
+    /* the gap below a power of two is only half as big */
+    if (value.f == DOUBLE_HIDDEN_BIT)
+    {
+        lower.f = (value.f << 2) - 1;
+        lower.e = value.e - 2;
+    }
+    else
+    {
+        lower.f = (value.f << 1) - 1;
+        lower.e = value.e - 1;
+    }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
 
-        case cJSON_True:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "true");
-            return true;
+    *minus = lower;
+    *plus = upper;
+}
 
-        case cJSON_Number:
-            return print_number(item, output_buffer);
+/* get a cached power of ten c = 10^-k so that c * 2^exponent has a binary exponent in [-60, -32] */
+static diy_fp get_cached_power(const int exponent, int * const k)
+{
+    const double estimate = (-61 - exponent) * 0.30102999566398114 + 347;
+    int rounded = (int)estimate;
+    unsigned int index = 0;
+    diy_fp result;
 
-        case cJSON_Raw:
+    if (estimate - rounded > 0.0)
+    {
+        rounded++;
+    }
+    index = (unsigned int)((rounded >> 3) + 1);
+    *k = -(-348 + (int)(index << 3));
+
+    result.f = cached_powers_f[index];
+    result.e = cached_powers_e[index];
+
+    return result;
+}
+
+/* move the last digit towards the exact value while staying within the safe interval */
+static void grisu_round(unsigned char * const digits, const int length, const cjson_uint64 delta, cjson_uint64 rest, const cjson_uint64 ten_kappa, const cjson_uint64 distance)
+{
+    while ((rest < distance) && ((delta - rest) >= ten_kappa)
+           && (((rest + ten_kappa) < distance) || ((distance - rest) > (rest + ten_kappa - distance))))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* generate the shortest digits of a number in the interval (upper - delta, upper), scaled by 10^k */
+static int generate_digits(const diy_fp value, const diy_fp upper, cjson_uint64 delta, unsigned char * const digits, int * const k)
+{
+    const int shift = -upper.e;
+    const cjson_uint64 one = CJSON_UINT64_C(0, 1) << shift;
+    const cjson_uint64 distance = upper.f - value.f;
+    unsigned int integral = (unsigned int)(upper.f >> shift);
+    cjson_uint64 fractional = upper.f & (one - 1);
+    int kappa = 0;
+    int length = 0;
+
+    while ((kappa < 10) && (integral >= powers_of_ten[kappa]))
+    {
+        kappa++;
+    }
+
+    while (kappa > 0)
+    {
+        const unsigned int divisor = (unsigned int)powers_of_ten[kappa - 1];
+        const unsigned int digit = integral / divisor;
+        cjson_uint64 rest = 0;
+
+        integral %= divisor;
+        if ((digit != 0) || (length != 0))
         {
-            size_t raw_length = 0;
-            if (item->valuestring == NULL)
-            {
-                return false;
-            }
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        kappa--;
 
-            raw_length = strlen(item->valuestring) + sizeof("");
-            output = ensure(output_buffer, raw_length);
-            if (output == NULL)
-            {
-                return false;
-            }
-            memcpy(output, item->valuestring, raw_length);
-            return true;
+        rest = (((cjson_uint64)integral) << shift) + fractional;
+        if (rest <= delta)
+        {
+            *k += kappa;
+            grisu_round(digits, length, delta, rest, powers_of_ten[kappa] << shift, distance);
+            return length;
         }
+    }
 
-        case cJSON_String:
-            return print_string(item, output_buffer);
+    for (;;)
+    {
+        unsigned int digit = 0;
 
-        case cJSON_Array:
-            return print_array(item, output_buffer);
+        fractional *= 10;
+        delta *= 10;
+        digit = (unsigned int)(fractional >> shift);
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        fractional &= one - 1;
+        kappa--;
 
-        case cJSON_Object:
-            return print_object(item, output_buffer);
+        if (fractional < delta)
+        {
+            *k += kappa;
+            grisu_round(digits, length, delta, fractional, one, (-kappa < 20) ? distance * powers_of_ten[-kappa] : 0);
+            return length;
+        }
+    }
+}
 
-        default:
-            return false;
+/* Grisu2: the shortest digits (in almost all cases) that read back as the same positive double.
+ * The value is digits * 10^k, returns the number of digits (at most 17). */
+static int grisu2(const double number, unsigned char * const digits, int * const k)
+{
+    const diy_fp value = diy_fp_from_double(number);
+    diy_fp minus;
+    diy_fp plus;
+    diy_fp cached_power;
+    diy_fp scaled;
+
+    normalized_boundaries(value, &minus, &plus);
+    cached_power = get_cached_power(plus.e, k);
+    scaled = diy_fp_multiply(diy_fp_normalize(value), cached_power);
+    plus = diy_fp_multiply(plus, cached_power);
+    minus = diy_fp_multiply(minus, cached_power);
+
+    /* stay clear of the boundaries to make up for the imprecision of the multiplication */
+    plus.f--;
+    minus.f++;
+
+    return generate_digits(scaled, plus, plus.f - minus.f, digits, k);
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* print an int two digits at a time, returns the number of characters */
+static int print_int(unsigned char * const output, const int integer)
+{
+    unsigned char reversed[10];
+    unsigned int magnitude = (unsigned int)integer;
+    int length = 0;
+    int i = 0;
+
+    if (integer < 0)
+    {
+        magnitude = 0U - magnitude;
+        output[i++] = '-';
+    }
+
+    while (magnitude >= 100)
+    {
+        const unsigned int pair = (magnitude % 100) * 2;
+        magnitude /= 100;
+        reversed[length++] = (unsigned char)digit_pairs[pair + 1];
+        reversed[length++] = (unsigned char)digit_pairs[pair];
+    }
+    if (magnitude >= 10)
+    {
+        reversed[length++] = (unsigned char)digit_pairs[magnitude * 2 + 1];
+        reversed[length++] = (unsigned char)digit_pairs[magnitude * 2];
+    }
+    else
+    {
+        reversed[length++] = (unsigned char)('0' + magnitude);
+    }
+
+    while (length > 0)
+    {
+        output[i++] = reversed[--length];
     }
+
+    return i;
 }
 
-/* Build an array from input text. */
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
+/* print_int for 64 bit integers */
+static int print_int64(unsigned char * const output, const cJSON_int64 integer)
 {
-    cJSON *head = NULL; /* head of the linked list */
-    cJSON *current_item = NULL;
+    unsigned char reversed[20];
+    cjson_uint64 magnitude = (cjson_uint64)integer;
+    unsigned int low = 0;
+    int length = 0;
+    int i = 0;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if (integer < 0)
     {
-        return false; /* to deeply nested */
+        magnitude = 0U - magnitude;
+        output[i++] = '-';
     }
-    input_buffer->depth++;
 
-    if (buffer_at_offset(input_buffer)[0] != '[')
+    /* 64 bit divisions only until the rest fits into 32 bits */
+    while (magnitude > UINT_MAX)
     {
-        /* not an array */
-        goto fail;
+        const unsigned int pair = (unsigned int)(magnitude % 100) * 2;
+        magnitude /= 100;
+        reversed[length++] = (unsigned char)digit_pairs[pair + 1];
+        reversed[length++] = (unsigned char)digit_pairs[pair];
+    }
+    low = (unsigned int)magnitude;
+    while (low >= 100)
+    {
+        const unsigned int pair = (low % 100) * 2;
+        low /= 100;
+        reversed[length++] = (unsigned char)digit_pairs[pair + 1];
+        reversed[length++] = (unsigned char)digit_pairs[pair];
+    }
+    if (low >= 10)
+    {
+        reversed[length++] = (unsigned char)digit_pairs[low * 2 + 1];
+        reversed[length++] = (unsigned char)digit_pairs[low * 2];
+    }
+    else
+    {
+        reversed[length++] = (unsigned char)('0' + low);
     }
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+    while (length > 0)
     {
-        /* empty array */
-        goto success;
+        output[i++] = reversed[--length];
     }
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
+    return i;
+}
+
+/* print a finite non-zero double with the shortest digits that round-trip, returns the number of characters.
+ * The layout follows printf's %g, with the precision the old %1.15g/%1.17g pass would have ended up with. */
+static int print_double(unsigned char * const output, double number)
+{
+    unsigned char digits[18];
+    int k = 0;
+    int length = 0;
+    int exponent = 0;
+    int precision = 0;
+    int i = 0;
+    int j = 0;
+
+    if (number < 0)
     {
-        input_buffer->offset--;
-        goto fail;
+        output[i++] = '-';
+        number = -number;
     }
 
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
+    length = grisu2(number, digits, &k);
+    /* decimal exponent of the first digit */
+    exponent = length + k - 1;
+    precision = (length <= 15) ? 15 : 17;
+
+    if ((exponent < -4) || (exponent >= precision))
     {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
+        /* d.ddde+xx */
+        output[i++] = digits[0];
+        if (length > 1)
         {
-            goto fail; /* allocation failure */
+            output[i++] = '.';
+            for (j = 1; j < length; j++)
+            {
+                output[i++] = digits[j];
+            }
         }
-
-        /* attach next item to list */
-        if (head == NULL)
+        output[i++] = 'e';
+        if (exponent < 0)
         {
-            /* start the linked list */
-            current_item = head = new_item;
+            output[i++] = '-';
+            exponent = -exponent;
         }
         else
         {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
+            output[i++] = '+';
         }
-
-        /* parse next value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
+        if (exponent >= 100)
         {
-            goto fail; /* failed to parse value */
+            output[i++] = (unsigned char)('0' + exponent / 100);
+            exponent %= 100;
         }
-        buffer_skip_whitespace(input_buffer);
+        output[i++] = (unsigned char)digit_pairs[exponent * 2];
+        output[i++] = (unsigned char)digit_pairs[exponent * 2 + 1];
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
-
-    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
+    else if (k >= 0)
     {
-        goto fail; /* expected end of array */
+        /* integral, pad with zeros */
+        for (j = 0; j < length; j++)
+        {
+            output[i++] = digits[j];
+        }
+        for (j = 0; j < k; j++)
+        {
+            output[i++] = '0';
+        }
+    }
+    else if (exponent >= 0)
+    {
+        for (j = 0; j < length; j++)
+        {
+            if (j == exponent + 1)
+            {
+                output[i++] = '.';
+            }
+            output[i++] = digits[j];
+        }
+    }
+    else
+    {
+        output[i++] = '0';
+        output[i++] = '.';
+        for (j = -1; j > exponent; j--)
+        {
+            output[i++] = '0';
+        }
+        for (j = 0; j < length; j++)
+        {
+            output[i++] = digits[j];
+        }
     }
 
-success:
-    input_buffer->depth--;
+    return i;
+}
 
-    if (head != NULL) {
-        head->prev = current_item;
-    }
+/* Render the number of an item into number_buffer (at least 26 bytes), returns the number of characters */
+static int format_number(const cJSON * const item, unsigned char * const number_buffer)
+{
+    double d = item->valuedouble;
 
-    item->type = cJSON_Array;
-    item->child = head;
+    if (cJSON_IsInt64(item))
+    {
+        return print_int64(number_buffer, item->valueint64);
+    }
 
-    input_buffer->offset++;
+    /* This checks for NaN and Infinity */
+    if (isnan(d) || isinf(d))
+    {
+        memcpy(number_buffer, "null", sizeof("null") - 1);
+        return sizeof("null") - 1;
+    }
+    if (d == (double)item->valueint)
+    {
+        return print_int(number_buffer, item->valueint);
+    }
 
-    return true;
+    return print_double(number_buffer, d);
+}
 
-fail:
-    if (head != NULL)
+/* Like format_number, for a plain double */
+static int format_double(const double d, unsigned char * const number_buffer)
+{
+    if (isnan(d) || isinf(d))
+    {
+        memcpy(number_buffer, "null", sizeof("null") - 1);
+        return sizeof("null") - 1;
+    }
+    if ((d >= INT_MIN) && (d <= INT_MAX) && (d == (double)(int)d))
     {
-        cJSON_Delete(head);
+        return print_int(number_buffer, (int)d);
     }
 
-    return false;
+    return print_double(number_buffer, d);
 }
 
-/* Render an array to text */
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer)
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
 {
     unsigned char *output_pointer = NULL;
-    size_t length = 0;
-    cJSON *current_element = item->child;
+    int length = 0;
+    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
 
     if (output_buffer == NULL)
     {
         return false;
     }
 
-    /* Compose the output array. */
-    /* opening square bracket */
-    output_pointer = ensure(output_buffer, 1);
+    length = format_number(item, number_buffer);
+
+    /* reserve appropriate space in the output */
+    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
     if (output_pointer == NULL)
     {
         return false;
     }
 
-    *output_pointer = '[';
-    output_buffer->offset++;
-    output_buffer->depth++;
+    memcpy(output_pointer, number_buffer, (size_t)length);
+    output_pointer[length] = '\0';
 
-    while (current_element != NULL)
+    output_buffer->offset += (size_t)length;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    unsigned int h = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 4; i++)
     {
-        if (!print_value(current_element, output_buffer))
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9'))
         {
-            return false;
+            h += (unsigned int) input[i] - '0';
         }
-        update_offset(output_buffer);
-        if (current_element->next)
+        else if ((input[i] >= 'A') && (input[i] <= 'F'))
         {
-            length = (size_t) (output_buffer->format ? 2 : 1);
-            output_pointer = ensure(output_buffer, length + 1);
-            if (output_pointer == NULL)
-            {
-                return false;
-            }
-            *output_pointer++ = ',';
-            if(output_buffer->format)
-            {
-                *output_pointer++ = ' ';
-            }
-            *output_pointer = '\0';
-            output_buffer->offset += length;
+            h += (unsigned int) 10 + input[i] - 'A';
+        }
+        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        {
+            h += (unsigned int) 10 + input[i] - 'a';
+        }
+        else /* invalid */
+        {
+            return 0;
+        }
+
+        if (i < 3)
+        {
+            /* shift left to make place for the next nibble */
+            h = h << 4;
         }
-        current_element = current_element->next;
     }
 
-    output_pointer = ensure(output_buffer, 2);
+    return h;
+}
+
+/* converts a UTF-16 literal to UTF-8
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+{
+    long unsigned int codepoint = 0;
+    unsigned int first_code = 0;
+    const unsigned char *first_sequence = input_pointer;
+    unsigned char utf8_length = 0;
+    unsigned char utf8_position = 0;
+    unsigned char sequence_length = 0;
+    unsigned char first_byte_mark = 0;
+
+    if ((input_end - first_sequence) < 6)
+    {
+        /* input ends unexpectedly */
+        goto fail;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = parse_hex4(first_sequence + 2);
+
+    /* check that the code is valid */
+    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    {
+        goto fail;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    {
+        const unsigned char *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+        sequence_length = 12; /* \uXXXX\uXXXX */
+
+        if ((input_end - second_sequence) < 6)
+        {
+            /* input ends unexpectedly */
+            goto fail;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        {
+            /* missing second half of the surrogate pair */
+            goto fail;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = parse_hex4(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        {
+            /* invalid second half of the surrogate pair */
+            goto fail;
+        }
+
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    }
+    else
+    {
+        sequence_length = 6; /* \uXXXX */
+        codepoint = first_code;
+    }
+
+    /* encode as UTF-8
+     * takes at maximum 4 bytes to encode:
+     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if (codepoint < 0x80)
+    {
+        /* normal ascii, encoding 0xxxxxxx */
+        utf8_length = 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        /* two bytes, encoding 110xxxxx 10xxxxxx */
+        utf8_length = 2;
+        first_byte_mark = 0xC0; /* 11000000 */
+    }
+    else if (codepoint < 0x10000)
+    {
+        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 3;
+        first_byte_mark = 0xE0; /* 11100000 */
+    }
+    else if (codepoint <= 0x10FFFF)
+    {
+        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 4;
+        first_byte_mark = 0xF0; /* 11110000 */
+    }
+    else
+    {
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+fail:
+    return 0;
+}
+
+/* Unescape the contents of a string literal (without quotes) into output, which needs room for at
+ * least as many bytes as the input. Returns the end of the output or NULL for invalid escape sequences,
+ * in which case *input is left at the invalid sequence. */
+static unsigned char *unescape_string(const unsigned char **input, const unsigned char * const input_end, unsigned char *output_pointer)
+{
+    const unsigned char *input_pointer = *input;
+
+    while (input_pointer < input_end)
+    {
+        if (*input_pointer != '\\')
+        {
+            *output_pointer++ = *input_pointer++;
+        }
+        /* escape sequence */
+        else
+        {
+            unsigned char sequence_length = 2;
+            if ((input_end - input_pointer) < 2)
+            {
+                *input = input_pointer;
+                return NULL;
+            }
+
+            switch (input_pointer[1])
+            {
+                case 'b':
+                    *output_pointer++ = '\b';
+                    break;
+                case 'f':
+                    *output_pointer++ = '\f';
+                    break;
+                case 'n':
+                    *output_pointer++ = '\n';
+                    break;
+                case 'r':
+                    *output_pointer++ = '\r';
+                    break;
+                case 't':
+                    *output_pointer++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *output_pointer++ = input_pointer[1];
+                    break;
+
+                /* UTF-16 literal */
+                case 'u':
+                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
+                    if (sequence_length == 0)
+                    {
+                        /* failed to convert UTF16-literal to UTF-8 */
+                        *input = input_pointer;
+                        return NULL;
+                    }
+                    break;
+
+                default:
+                    *input = input_pointer;
+                    return NULL;
+            }
+            input_pointer += sequence_length;
+        }
+    }
+
+    *input = input_pointer;
+    return output_pointer;
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+    unsigned char *output_pointer = NULL;
+    unsigned char *output = NULL;
+
+    /* not a string */
+    if (buffer_at_offset(input_buffer)[0] != '\"')
+    {
+        goto fail;
+    }
+
+    {
+        /* calculate approximate size of the output (overestimate) */
+        size_t allocation_length = 0;
+        size_t skipped_bytes = 0;
+        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        {
+            /* is escape sequence */
+            if (input_end[0] == '\\')
+            {
+                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
+                {
+                    /* prevent buffer overflow when last input character is a backslash */
+                    goto fail;
+                }
+                skipped_bytes++;
+                input_end++;
+            }
+            input_end++;
+        }
+        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+        {
+            goto fail; /* string ended unexpectedly */
+        }
+
+        /* This is at most how much we need for the output, the opening quote makes room for the terminator */
+        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+        output = parse_allocate_string(input_buffer, item, allocation_length);
+        if (output == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+    }
+
+    /* loop through the string literal */
+    output_pointer = unescape_string(&input_pointer, input_end, output);
     if (output_pointer == NULL)
     {
-        return false;
+        goto fail;
+    }
+
+    /* zero terminate the output */
+    *output_pointer = '\0';
+
+    item->type = cJSON_String;
+    item->valuestring = (char*)output;
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if ((output != NULL) && (input_buffer->arena == NULL))
+    {
+        input_buffer->hooks.deallocate(output);
+        output = NULL;
+    }
+
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
+}
+
+#define CJSON_SWAR_ONES CJSON_UINT64_C(0x01010101, 0x01010101)
+#define CJSON_SWAR_HIGHS CJSON_UINT64_C(0x80808080, 0x80808080)
+
+/* check 8 characters at once for a control character, '"' or '\\' */
+static cJSON_bool block_needs_escaping(const unsigned char * const block)
+{
+    cjson_uint64 word = 0;
+    cjson_uint64 quotes = 0;
+    cjson_uint64 backslashes = 0;
+
+    memcpy(&word, block, sizeof(word));
+    quotes = word ^ (CJSON_SWAR_ONES * '\"');
+    backslashes = word ^ (CJSON_SWAR_ONES * '\\');
+
+    /* a byte is zero / below 0x20 exactly if subtracting from it borrows into a high bit that wasn't set */
+    return ((((quotes - CJSON_SWAR_ONES) & ~quotes)
+             | ((backslashes - CJSON_SWAR_ONES) & ~backslashes)
+             | ((word - (CJSON_SWAR_ONES * 0x20)) & ~word))
+            & CJSON_SWAR_HIGHS) != 0;
+}
+
+/* length of the run of characters at the start of input that can be copied as they are */
+static size_t clean_run_length(const unsigned char * const input, const size_t length)
+{
+    size_t i = 0;
+
+    while (((i + sizeof(cjson_uint64)) <= length) && !block_needs_escaping(input + i))
+    {
+        i += sizeof(cjson_uint64);
+    }
+    while ((i < length) && (input[i] > 31) && (input[i] != '\"') && (input[i] != '\\'))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/* write the escape sequence for a character that needs one, returns its length */
+static size_t escape_character(const unsigned char character, unsigned char * const output)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    output[0] = '\\';
+    switch (character)
+    {
+        case '\\':
+        case '\"':
+            output[1] = character;
+            return 2;
+        case '\b':
+            output[1] = 'b';
+            return 2;
+        case '\f':
+            output[1] = 'f';
+            return 2;
+        case '\n':
+            output[1] = 'n';
+            return 2;
+        case '\r':
+            output[1] = 'r';
+            return 2;
+        case '\t':
+            output[1] = 't';
+            return 2;
+        default:
+            /* escape and print as unicode codepoint */
+            output[1] = 'u';
+            output[2] = '0';
+            output[3] = '0';
+            output[4] = (unsigned char)hex_digits[character >> 4];
+            output[5] = (unsigned char)hex_digits[character & 0x0F];
+            return 6;
+    }
+}
+
+/* Count the characters that escaping input adds, *length is set to the length of input itself */
+static size_t count_escape_characters(const unsigned char * const input, size_t * const length)
+{
+    const size_t input_length = strlen((const char*)input);
+    unsigned char escape_sequence[6];
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+    size_t i = 0;
+
+    while (i < input_length)
+    {
+        i += clean_run_length(input + i, input_length - i);
+        if (i < input_length)
+        {
+            escape_characters += escape_character(input[i], escape_sequence) - 1;
+            i++;
+        }
+    }
+    *length = input_length;
+
+    return escape_characters;
+}
+
+/* Render the cstring provided to an escaped version that can be printed.
+ * The escaped length is measured first so that the output is reserved once, then runs of characters
+ * that don't need escaping are found 8 at a time and copied in one go. */
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    unsigned char *output = NULL;
+    size_t input_length = 0;
+    size_t escape_characters = 0;
+    size_t i = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\""));
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+
+        return true;
+    }
+
+    escape_characters = count_escape_characters(input, &input_length);
+    output = ensure(output_buffer, input_length + escape_characters + sizeof("\"\""));
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    *output++ = '\"';
+    while (i < input_length)
+    {
+        size_t length = clean_run_length(input + i, input_length - i);
+
+        memcpy(output, input + i, length);
+        output += length;
+        i += length;
+        if (i < input_length)
+        {
+            /* character needs to be escaped */
+            output += escape_character(input[i], output);
+            i++;
+        }
+    }
+    output[0] = '\"';
+    output[1] = '\0';
+    output_buffer->offset += input_length + escape_characters + 2;
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+{
+    return print_string_ptr((unsigned char*)item->valuestring, p);
+}
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool lazy_expand(const cJSON * const item);
+
+/* Utility to jump whitespace and cr/lf */
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return buffer;
+    }
+
+    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    {
+       buffer->offset++;
+    }
+
+    if (buffer->offset == buffer->length)
+    {
+        buffer->offset--;
+    }
+
+    return buffer;
+}
+
+/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
+static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    {
+        return NULL;
+    }
+
+    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    {
+        buffer->offset += 3;
+    }
+
+    return buffer;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    size_t buffer_length;
+
+    if (NULL == value)
+    {
+        return NULL;
+    }
+
+    /* Adding null character size due to require_null_terminated. */
+    buffer_length = strlen(value) + sizeof("");
+
+    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+}
+
+/* Parse an object - create a new root, and populate. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+
+    if (value == NULL || 0 == buffer_length)
+    {
+        goto fail;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = global_hooks;
+
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL) /* memory fail */
+    {
+        goto fail;
+    }
+
+    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        {
+            goto fail;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        cJSON_Delete(item);
+    }
+
+    if (value != NULL)
+    {
+        error local_error;
+        local_error.json = (const unsigned char*)value;
+        local_error.position = 0;
+
+        if (buffer.offset < buffer.length)
+        {
+            local_error.position = buffer.offset;
+        }
+        else if (buffer.length > 0)
+        {
+            local_error.position = buffer.length - 1;
+        }
+
+        if (return_parse_end != NULL)
+        {
+            *return_parse_end = (const char*)local_error.json + local_error.position;
+        }
+
+        global_error = local_error;
+    }
+
+    return NULL;
+}
+
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
+
+/* Parse buffer into the items and strings of tree, which is used up. Returns NULL on failure with the offset of the
+ * error in buffer. */
+static cJSON *parse_recycled(parse_buffer * const buffer, cJSON * const tree)
+{
+    parse_recycler recycler = { NULL, NULL, NULL };
+    cJSON *item = NULL;
+
+    buffer->recycler = &recycler;
+    recycler.items = recycle_tree(tree);
+    item = parse_new_item(buffer);
+    if ((item == NULL) || (buffer->length == 0) || !parse_value(item, buffer_skip_whitespace(skip_utf8_bom(buffer))))
+    {
+        delete_item(item, &buffer->hooks);
+        item = NULL;
+    }
+
+    /* the old tree had more than the new one */
+    recycler_release_strings(&recycler, &buffer->hooks);
+    delete_item(recycler.items, &buffer->hooks);
+    buffer->recycler = NULL;
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInto(cJSON *tree, const char *value, size_t buffer_length)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+
+    if ((tree == NULL) || (tree->internalflags & cJSON_FlagArena))
+    {
+        /* nothing to reuse, an arena tree is released with its arena */
+        return cJSON_ParseWithLength(value, buffer_length);
+    }
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = (value != NULL) ? buffer_length : 0;
+    buffer.hooks = global_hooks;
+
+    item = parse_recycled(&buffer, tree);
+    if ((item == NULL) && (value != NULL))
+    {
+        global_error.json = (const unsigned char*)value;
+        if (buffer.offset < buffer.length)
+        {
+            global_error.position = buffer.offset;
+        }
+        else if (buffer.length > 0)
+        {
+            global_error.position = buffer.length - 1;
+        }
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseLazy(const char *value, size_t buffer_length)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, true, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+
+    if ((value == NULL) || (buffer_length == 0))
+    {
+        return NULL;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.hooks = global_hooks;
+
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL)
+    {
+        return NULL;
+    }
+    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        cJSON_Delete(item);
+        return NULL;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(size_t) cJSON_ParseMany(const char *buffer, size_t length, cJSON_ParseManyCallback callback, void *user)
+{
+    size_t offset = 0;
+
+    if ((buffer == NULL) || (callback == NULL))
+    {
+        return 0;
+    }
+
+    while (offset < length)
+    {
+        const char *line = buffer + offset;
+        const char *newline = (const char*)memchr(line, '\n', length - offset);
+        const char *end = NULL;
+        size_t line_length = 0;
+        cJSON *item = NULL;
+
+        if (newline == NULL)
+        {
+            /* the last line isn't complete yet */
+            break;
+        }
+        line_length = (size_t)(newline - line);
+        offset += line_length + 1;
+
+        /* skip blank lines */
+        end = line;
+        while ((end < newline) && ((*end == ' ') || (*end == '\t') || (*end == '\r')))
+        {
+            end++;
+        }
+        if (end == newline)
+        {
+            continue;
+        }
+
+        item = cJSON_ParseWithLengthOpts(line, line_length, &end, false);
+        if (item != NULL)
+        {
+            /* nothing but whitespace may follow the document on its line */
+            while ((end < newline) && ((*end == ' ') || (*end == '\t') || (*end == '\r')))
+            {
+                end++;
+            }
+            if (end != newline)
+            {
+                cJSON_Delete(item);
+                item = NULL;
+                /* report the garbage like any other error */
+                global_error.json = (const unsigned char*)line;
+                global_error.position = (size_t)(end - line);
+            }
+        }
+
+        if (!callback(item, line, line_length, user))
+        {
+            break;
+        }
+    }
+
+    return offset;
+}
+
+/* hooks of a parse context, missing functions fall back to malloc/free like in cJSON_InitHooks */
+static internal_hooks context_hooks(const cJSON_ParseContext * const context)
+{
+    internal_hooks hooks = { internal_malloc, internal_free, NULL };
+
+    if (context->hooks.malloc_fn != NULL)
+    {
+        hooks.allocate = context->hooks.malloc_fn;
+    }
+    if (context->hooks.free_fn != NULL)
+    {
+        hooks.deallocate = context->hooks.free_fn;
+    }
+
+    return hooks;
+}
+
+CJSON_PUBLIC(void) cJSON_InitParseContext(cJSON_ParseContext *context)
+{
+    if (context == NULL)
+    {
+        return;
+    }
+
+    memset(context, '\0', sizeof(cJSON_ParseContext));
+    context->max_depth = CJSON_NESTING_LIMIT;
+}
+
+/* Parse with the options of context, into the items and strings of tree if it isn't NULL */
+static cJSON *parse_with_context(cJSON_ParseContext * const context, cJSON * const tree, const char * const value, const size_t buffer_length)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, false, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+    size_t end = 0;
+
+    if (context == NULL)
+    {
+        return NULL;
+    }
+    context->position = 0;
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = (value != NULL) ? buffer_length : 0;
+    buffer.hooks = context_hooks(context);
+    buffer.arena = context->arena;
+    if (context->max_depth < CJSON_NESTING_LIMIT)
+    {
+        buffer.max_depth = context->max_depth;
+    }
+
+    if ((tree != NULL) && !(tree->internalflags & cJSON_FlagArena) && (buffer.arena == NULL))
+    {
+        item = parse_recycled(&buffer, tree);
+        if (item == NULL)
+        {
+            goto fail;
+        }
+    }
+    else
+    {
+        /* nothing to reuse for an arena, an arena tree is released with its arena */
+        delete_item(tree, &buffer.hooks);
+        if (buffer.length == 0)
+        {
+            return NULL;
+        }
+
+        item = parse_new_item(&buffer);
+        if (item == NULL)
+        {
+            goto fail;
+        }
+
+        if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+        {
+            goto fail;
+        }
+    }
+
+    end = buffer.offset;
+
+    if (context->reject_trailing)
+    {
+        /* a null terminator ends the input */
+        while ((buffer.offset < buffer.length) && (buffer_at_offset(&buffer)[0] != '\0'))
+        {
+            if (buffer_at_offset(&buffer)[0] > 32)
+            {
+                goto fail;
+            }
+            buffer.offset++;
+        }
+    }
+    context->position = end;
+
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        delete_item(item, &buffer.hooks);
+    }
+
+    if (buffer.offset < buffer.length)
+    {
+        context->position = buffer.offset;
+    }
+    else if (buffer.length > 0)
+    {
+        context->position = buffer.length - 1;
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithContext(cJSON_ParseContext *context, const char *value, size_t buffer_length)
+{
+    return parse_with_context(context, NULL, value, buffer_length);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseIntoWithContext(cJSON_ParseContext *context, cJSON *tree, const char *value, size_t buffer_length)
+{
+    return parse_with_context(context, tree, value, buffer_length);
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteWithContext(const cJSON_ParseContext *context, cJSON *item)
+{
+    internal_hooks hooks;
+
+    if (context == NULL)
+    {
+        return;
+    }
+
+    hooks = context_hooks(context);
+    delete_item(item, &hooks);
+}
+
+/* Incremental parser for newline delimited JSON */
+typedef enum
+{
+    stream_value,        /* expecting a value */
+    stream_array_start,  /* after '[', expecting a value or ']' */
+    stream_object_start, /* after '{', expecting a key or '}' */
+    stream_key,          /* after ',' in an object, expecting a key */
+    stream_colon,        /* after a key, expecting ':' */
+    stream_after_value,  /* after a value in an array or object, expecting ',' or the closing bracket */
+    stream_string,       /* inside a string */
+    stream_number,       /* inside a number */
+    stream_literal,      /* inside true, false or null */
+    stream_done,         /* the document is complete, expecting the end of the line */
+    stream_skip_line     /* the line is invalid, skipping to its end */
+} stream_state;
+
+typedef struct
+{
+    cJSON *container;
+    cJSON *last_child;
+} stream_frame;
+
+struct cJSON_Stream
+{
+    internal_hooks hooks;
+    stream_state state;
+    cJSON *root;
+    /* open arrays and objects, innermost last */
+    stream_frame *frames;
+    size_t depth;
+    size_t frames_capacity;
+    /* key of the object member whose value is being parsed */
+    char *key;
+    /* text of the string or number being parsed, it may span several chunks */
+    unsigned char *token;
+    size_t token_length;
+    size_t token_capacity;
+    cJSON_bool string_is_key;
+    cJSON_bool escaped;
+    const char *literal;
+    size_t literal_position;
+    int literal_type;
+    size_t line_position; /* bytes of the current line fed so far */
+    size_t error_position;
+};
+
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(void)
+{
+    cJSON_Stream *stream = (cJSON_Stream*)global_hooks.allocate(sizeof(cJSON_Stream));
+    if (stream == NULL)
+    {
+        return NULL;
+    }
+
+    memset(stream, '\0', sizeof(cJSON_Stream));
+    stream->hooks = global_hooks;
+    stream->state = stream_value;
+
+    return stream;
+}
+
+/* throw away the partially parsed document and start over with the next line */
+static void stream_reset(cJSON_Stream * const stream)
+{
+    if (stream->root != NULL)
+    {
+        cJSON_Delete(stream->root);
+        stream->root = NULL;
+    }
+    if (stream->key != NULL)
+    {
+        stream->hooks.deallocate(stream->key);
+        stream->key = NULL;
+    }
+    stream->depth = 0;
+    stream->token_length = 0;
+    stream->state = stream_value;
+    stream->line_position = 0;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream)
+{
+    if (stream == NULL)
+    {
+        return;
+    }
+
+    stream_reset(stream);
+    if (stream->frames != NULL)
+    {
+        stream->hooks.deallocate(stream->frames);
+    }
+    if (stream->token != NULL)
+    {
+        stream->hooks.deallocate(stream->token);
+    }
+    stream->hooks.deallocate(stream);
+}
+
+CJSON_PUBLIC(size_t) cJSON_StreamErrorPosition(const cJSON_Stream *stream)
+{
+    if (stream == NULL)
+    {
+        return 0;
+    }
+
+    return stream->error_position;
+}
+
+/* append to the token that is being collected, growing its buffer if necessary */
+static cJSON_bool stream_append(cJSON_Stream * const stream, const unsigned char *data, size_t length)
+{
+    if ((stream->token_length + length) >= stream->token_capacity)
+    {
+        unsigned char *new_token = NULL;
+        size_t new_capacity = (stream->token_capacity > 0) ? stream->token_capacity : 64;
+        while (new_capacity <= (stream->token_length + length))
+        {
+            new_capacity *= 2;
+        }
+
+        new_token = (unsigned char*)stream->hooks.allocate(new_capacity);
+        if (new_token == NULL)
+        {
+            return false;
+        }
+        if (stream->token != NULL)
+        {
+            memcpy(new_token, stream->token, stream->token_length);
+            stream->hooks.deallocate(stream->token);
+        }
+        stream->token = new_token;
+        stream->token_capacity = new_capacity;
+    }
+
+    memcpy(stream->token + stream->token_length, data, length);
+    stream->token_length += length;
+
+    return true;
+}
+
+/* add a completed value to the open array/object or make it the root */
+static void stream_add_value(cJSON_Stream * const stream, cJSON * const item)
+{
+    stream_frame *frame = NULL;
+
+    if (stream->depth == 0)
+    {
+        stream->root = item;
+        stream->state = stream_done;
+        return;
+    }
+
+    frame = &stream->frames[stream->depth - 1];
+    if ((frame->container->type & 0xFF) == cJSON_Object)
+    {
+        item->string = stream->key;
+        stream->key = NULL;
+    }
+
+    if (frame->last_child == NULL)
+    {
+        frame->container->child = item;
+    }
+    else
+    {
+        frame->last_child->next = item;
+        item->prev = frame->last_child;
+    }
+    frame->last_child = item;
+    frame->container->childcount++;
+
+    stream->state = stream_after_value;
+}
+
+static cJSON_bool stream_open_container(cJSON_Stream * const stream, int type)
+{
+    cJSON *item = NULL;
+
+    if (stream->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* to deeply nested */
+    }
+
+    if (stream->depth == stream->frames_capacity)
+    {
+        size_t new_capacity = (stream->frames_capacity > 0) ? (stream->frames_capacity * 2) : 16;
+        stream_frame *new_frames = (stream_frame*)stream->hooks.allocate(new_capacity * sizeof(stream_frame));
+        if (new_frames == NULL)
+        {
+            return false;
+        }
+        if (stream->frames != NULL)
+        {
+            memcpy(new_frames, stream->frames, stream->depth * sizeof(stream_frame));
+            stream->hooks.deallocate(stream->frames);
+        }
+        stream->frames = new_frames;
+        stream->frames_capacity = new_capacity;
+    }
+
+    item = cJSON_New_Item(&stream->hooks);
+    if (item == NULL)
+    {
+        return false;
+    }
+    item->type = type;
+    stream_add_value(stream, item);
+
+    stream->frames[stream->depth].container = item;
+    stream->frames[stream->depth].last_child = NULL;
+    stream->depth++;
+    stream->state = (type == cJSON_Object) ? stream_object_start : stream_array_start;
+
+    return true;
+}
+
+static cJSON_bool stream_close_container(cJSON_Stream * const stream, int type)
+{
+    stream_frame *frame = &stream->frames[stream->depth - 1];
+
+    if ((frame->container->type & 0xFF) != type)
+    {
+        return false;
+    }
+
+    if (frame->container->child != NULL)
+    {
+        frame->container->child->prev = frame->last_child;
+    }
+    stream->depth--;
+    stream->state = (stream->depth == 0) ? stream_done : stream_after_value;
+
+    return true;
+}
+
+/* turn the collected string or number into a value, reusing the regular parser */
+static cJSON_bool stream_finish_token(cJSON_Stream * const stream)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+    cJSON_bool is_string = (stream->state == stream_string);
+
+    buffer.content = stream->token;
+    buffer.length = stream->token_length;
+    buffer.hooks = stream->hooks;
+
+    if (is_string && stream->string_is_key)
+    {
+        cJSON key;
+        memset(&key, '\0', sizeof(key));
+        if (!parse_string(&key, &buffer))
+        {
+            return false;
+        }
+        stream->key = key.valuestring;
+        stream->token_length = 0;
+        stream->state = stream_colon;
+        return true;
+    }
+
+    item = cJSON_New_Item(&stream->hooks);
+    if (item == NULL)
+    {
+        return false;
+    }
+    if (!(is_string ? parse_string(item, &buffer) : parse_number(item, &buffer)) || (buffer.offset != buffer.length))
+    {
+        cJSON_Delete(item);
+        return false;
+    }
+    stream->token_length = 0;
+    stream_add_value(stream, item);
+
+    return true;
+}
+
+static cJSON_bool stream_start_string(cJSON_Stream * const stream, cJSON_bool is_key)
+{
+    stream->string_is_key = is_key;
+    stream->escaped = false;
+    stream->state = stream_string;
+    stream->token_length = 0;
+
+    return stream_append(stream, (const unsigned char*)"\"", 1);
+}
+
+/* Start parsing a value with its first character, returns false if no value can start with it */
+static cJSON_bool stream_start_value(cJSON_Stream * const stream, unsigned char character)
+{
+    switch (character)
+    {
+        case '\"':
+            return stream_start_string(stream, false);
+
+        case '{':
+            return stream_open_container(stream, cJSON_Object);
+
+        case '[':
+            return stream_open_container(stream, cJSON_Array);
+
+        case 't':
+            stream->literal = "true";
+            stream->literal_type = cJSON_True;
+            break;
+
+        case 'f':
+            stream->literal = "false";
+            stream->literal_type = cJSON_False;
+            break;
+
+        case 'n':
+            stream->literal = "null";
+            stream->literal_type = cJSON_NULL;
+            break;
+
+        default:
+            if ((character == '-') || ((character >= '0') && (character <= '9')))
+            {
+                stream->state = stream_number;
+                stream->token_length = 0;
+                return stream_append(stream, &character, 1);
+            }
+            return false;
+    }
+
+    stream->literal_position = 1;
+    stream->state = stream_literal;
+
+    return true;
+}
+
+static cJSON_bool is_number_character(unsigned char character)
+{
+    return ((character >= '0') && (character <= '9')) || (character == '+') || (character == '-')
+        || (character == 'e') || (character == 'E') || (character == '.');
+}
+
+CJSON_PUBLIC(int) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length, size_t *consumed, cJSON **document)
+{
+    const unsigned char *input = (const unsigned char*)chunk;
+    size_t position = 0;
+
+    if (consumed != NULL)
+    {
+        *consumed = 0;
+    }
+    if (document != NULL)
+    {
+        *document = NULL;
+    }
+    if ((stream == NULL) || ((chunk == NULL) && (length > 0)) || (consumed == NULL) || (document == NULL))
+    {
+        return cJSON_StreamInvalid;
+    }
+
+    while (position < length)
+    {
+        unsigned char character = input[position];
+        cJSON_bool valid = true;
+        cJSON_bool advance = true;
+
+        if ((stream->state == stream_string) && !stream->escaped && (character != '\"') && (character != '\\') && (character != '\n'))
+        {
+            /* strings are the bulk of the input, copy runs of plain characters at once */
+            size_t run = position + 1;
+            while ((run < length) && (input[run] != '\"') && (input[run] != '\\') && (input[run] != '\n'))
+            {
+                run++;
+            }
+            valid = stream_append(stream, input + position, run - position);
+            if (valid)
+            {
+                stream->line_position += run - position;
+                position = run;
+                continue;
+            }
+            advance = false;
+        }
+        else if (character == '\n')
+        {
+            if (stream->state == stream_number)
+            {
+                /* the end of the line ends the number, then handle the newline again */
+                valid = stream_finish_token(stream);
+                advance = false;
+            }
+            else if ((stream->state == stream_done) || (stream->state == stream_skip_line))
+            {
+                cJSON_bool complete = (stream->state == stream_done);
+                *consumed = position + 1;
+                if (complete)
+                {
+                    *document = stream->root;
+                    stream->root = NULL;
+                }
+                stream_reset(stream);
+                return complete ? cJSON_StreamDocument : cJSON_StreamInvalid;
+            }
+            else if ((stream->state == stream_value) && (stream->depth == 0))
+            {
+                /* empty line */
+                stream->line_position = 0;
+                position++;
+                continue;
+            }
+            else
+            {
+                /* the line ended in the middle of the document */
+                stream->error_position = stream->line_position;
+                stream_reset(stream);
+                *consumed = position + 1;
+                return cJSON_StreamInvalid;
+            }
+        }
+        else
+        {
+            switch (stream->state)
+            {
+                case stream_string:
+                    if (stream->escaped)
+                    {
+                        stream->escaped = false;
+                        valid = stream_append(stream, &character, 1);
+                    }
+                    else if (character == '\\')
+                    {
+                        stream->escaped = true;
+                        valid = stream_append(stream, &character, 1);
+                    }
+                    else
+                    {
+                        valid = stream_append(stream, &character, 1) && stream_finish_token(stream);
+                    }
+                    break;
+
+                case stream_number:
+                    if (is_number_character(character))
+                    {
+                        valid = stream_append(stream, &character, 1);
+                        break;
+                    }
+                    /* the number ended, handle this character again in the new state */
+                    valid = stream_finish_token(stream);
+                    advance = false;
+                    break;
+
+                case stream_literal:
+                    if (character != (unsigned char)stream->literal[stream->literal_position])
+                    {
+                        valid = false;
+                        break;
+                    }
+                    stream->literal_position++;
+                    if (stream->literal[stream->literal_position] == '\0')
+                    {
+                        cJSON *item = cJSON_New_Item(&stream->hooks);
+                        if (item == NULL)
+                        {
+                            valid = false;
+                            break;
+                        }
+                        item->type = stream->literal_type;
+                        if (item->type == cJSON_True)
+                        {
+                            item->valueint = 1;
+                        }
+                        stream_add_value(stream, item);
+                    }
+                    break;
+
+                case stream_skip_line:
+                    break;
+
+                default:
+                    if (character <= 32)
+                    {
+                        /* whitespace */
+                        break;
+                    }
+
+                    switch (stream->state)
+                    {
+                        case stream_value:
+                            valid = stream_start_value(stream, character);
+                            break;
+
+                        case stream_array_start:
+                            valid = (character == ']') ? stream_close_container(stream, cJSON_Array) : stream_start_value(stream, character);
+                            break;
+
+                        case stream_object_start:
+                            valid = (character == '}') ? stream_close_container(stream, cJSON_Object) : ((character == '\"') && stream_start_string(stream, true));
+                            break;
+
+                        case stream_key:
+                            valid = (character == '\"') && stream_start_string(stream, true);
+                            break;
+
+                        case stream_colon:
+                            valid = (character == ':');
+                            stream->state = stream_value;
+                            break;
+
+                        case stream_after_value:
+                            if (character == ',')
+                            {
+                                stream->state = ((stream->frames[stream->depth - 1].container->type & 0xFF) == cJSON_Object) ? stream_key : stream_value;
+                            }
+                            else
+                            {
+                                valid = stream_close_container(stream, (character == '}') ? cJSON_Object : ((character == ']') ? cJSON_Array : cJSON_Invalid));
+                            }
+                            break;
+
+                        default:
+                            /* garbage after the document */
+                            valid = false;
+                            break;
+                    }
+                    break;
+            }
+        }
+
+        if (!valid)
+        {
+            /* drop what has been parsed of this line and skip the rest of it */
+            size_t line_position = stream->line_position;
+            stream_reset(stream);
+            stream->error_position = line_position;
+            stream->line_position = line_position;
+            stream->state = stream_skip_line;
+            advance = (character != '\n');
+        }
+
+        if (advance)
+        {
+            position++;
+            stream->line_position++;
+        }
+    }
+
+    *consumed = position;
+
+    return cJSON_StreamNeedMore;
+}
+
+/* Pull tokenizer */
+#define reader_value 0           /* expecting a value */
+#define reader_value_or_end 1    /* after '[', expecting a value or ']' */
+#define reader_key_or_end 2      /* after '{', expecting a key or '}' */
+#define reader_key 3             /* after ',' in an object, expecting a key */
+#define reader_after_value 4     /* expecting ',' or the end of the array/object */
+#define reader_done 5            /* the document is complete */
+#define reader_failed 6
+
+#define reader_in_object(reader) (((reader)->containers[((reader)->depth - 1) / 8] >> (((reader)->depth - 1) % 8)) & 1)
+
+CJSON_PUBLIC(void) cJSON_InitReader(cJSON_Reader *reader, const char *json, size_t length)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    memset(reader, '\0', sizeof(cJSON_Reader));
+    reader->content = (const unsigned char*)json;
+    reader->length = (json != NULL) ? length : 0;
+    reader->state = reader_value;
+}
+
+CJSON_PUBLIC(void) cJSON_InitSegmentReader(cJSON_Reader *reader, const cJSON_Segment *segments, size_t count)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    memset(reader, '\0', sizeof(cJSON_Reader));
+    reader->state = reader_value;
+    if ((segments == NULL) || (count == 0))
+    {
+        return;
+    }
+
+    reader->segments = segments;
+    reader->segment_count = count;
+    reader->content = (const unsigned char*)segments[0].data;
+    reader->length = (segments[0].data != NULL) ? segments[0].length : 0;
+    reader->segment = 1;
+}
+
+CJSON_PUBLIC(void) cJSON_ReaderRelease(cJSON_Reader *reader)
+{
+    if ((reader == NULL) || (reader->scratch == NULL))
+    {
+        return;
+    }
+
+    if (reader->content == reader->scratch)
+    {
+        reader->content = NULL;
+        reader->length = 0;
+        reader->offset = 0;
+    }
+    global_hooks.deallocate(reader->scratch);
+    reader->scratch = NULL;
+    reader->scratch_size = 0;
+}
+
+/* Bytes of segmented input that follow content */
+static cJSON_bool reader_has_more(const cJSON_Reader * const reader)
+{
+    size_t segment = reader->segment;
+    size_t offset = reader->segment_offset;
+
+    for (; segment < reader->segment_count; segment++, offset = 0)
+    {
+        if ((reader->segments[segment].data != NULL) && (reader->segments[segment].length > offset))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Continue with the rest of the next segment once content has been read up to its end */
+static cJSON_bool reader_next_segment(cJSON_Reader * const reader)
+{
+    const cJSON_Segment *segment = NULL;
+
+    if (!reader_has_more(reader))
+    {
+        return false;
+    }
+
+    while ((reader->segments[reader->segment].data == NULL) || (reader->segments[reader->segment].length <= reader->segment_offset))
+    {
+        reader->segment++;
+        reader->segment_offset = 0;
+    }
+
+    segment = &reader->segments[reader->segment];
+    reader->position += reader->length;
+    reader->content = (const unsigned char*)segment->data + reader->segment_offset;
+    reader->length = segment->length - reader->segment_offset;
+    reader->offset = 0;
+    reader->segment++;
+    reader->segment_offset = 0;
+
+    return true;
+}
+
+/* Make content the text from start up to its end followed by up to more bytes of the segments after it,
+ * copied together into the scratch buffer. Used when a token doesn't end in content. */
+static cJSON_bool reader_stitch(cJSON_Reader * const reader, const size_t start, size_t more)
+{
+    size_t kept = reader->length - start;
+    size_t available = 0;
+    size_t segment = 0;
+    size_t offset = 0;
+    unsigned char *scratch = reader->scratch;
+
+    for (segment = reader->segment, offset = reader->segment_offset; segment < reader->segment_count; segment++, offset = 0)
+    {
+        if (reader->segments[segment].data != NULL)
+        {
+            available += reader->segments[segment].length - offset;
+        }
+    }
+    if (available == 0)
+    {
+        return false;
+    }
+    if (more > available)
+    {
+        more = available;
+    }
+
+    if ((kept + more) > reader->scratch_size)
+    {
+        scratch = (unsigned char*)global_hooks.allocate(kept + more);
+        if (scratch == NULL)
+        {
+            return false;
+        }
+        memcpy(scratch, reader->content + start, kept);
+        if (reader->scratch != NULL)
+        {
+            global_hooks.deallocate(reader->scratch);
+        }
+        reader->scratch = scratch;
+        reader->scratch_size = kept + more;
+    }
+    else
+    {
+        /* the text that is kept may already be in the scratch buffer */
+        memmove(scratch, reader->content + start, kept);
+    }
+
+    reader->position += start;
+    reader->content = scratch;
+    reader->length = kept;
+    reader->offset = 0;
+    while (more > 0)
+    {
+        const cJSON_Segment *next = &reader->segments[reader->segment];
+        size_t length = 0;
+
+        if ((next->data == NULL) || (next->length <= reader->segment_offset))
+        {
+            reader->segment++;
+            reader->segment_offset = 0;
+            continue;
+        }
+        length = next->length - reader->segment_offset;
+        if (length > more)
+        {
+            length = more;
+        }
+        memcpy(scratch + reader->length, next->data + reader->segment_offset, length);
+        reader->length += length;
+        reader->segment_offset += length;
+        more -= length;
+    }
+
+    return true;
+}
+
+static int reader_fail(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    reader->state = reader_failed;
+    reader->error_position = reader->position + reader->offset;
+    token->type = cJSON_TokenError;
+    token->text = (const char*)(reader->content + reader->offset);
+    token->length = 0;
+
+    return cJSON_TokenError;
+}
+
+/* Find the end of the string literal starting at the quote at reader->offset and check its escape sequences */
+static cJSON_bool reader_scan_string(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    const unsigned char *input = reader->content;
+    size_t position = reader->offset + 1;
+
+    token->escaped = false;
+    while ((position < reader->length) && (input[position] != '\"'))
+    {
+        if (input[position] == '\\')
+        {
+            token->escaped = true;
+            if ((position + 1) >= reader->length)
+            {
+                reader->offset = position;
+                return false;
+            }
+            switch (input[position + 1])
+            {
+                case '\"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    position += 2;
+                    continue;
+
+                case 'u':
+                {
+                    size_t i = 0;
+                    for (i = 2; i < 6; i++)
+                    {
+                        if (((position + i) >= reader->length) || !isxdigit(input[position + i]))
+                        {
+                            reader->offset = position;
+                            return false;
+                        }
+                    }
+                    position += 6;
+                    continue;
+                }
+
+                default:
+                    reader->offset = position;
+                    return false;
+            }
+        }
+        position++;
+    }
+
+    if (position >= reader->length)
+    {
+        /* string ended unexpectedly */
+        reader->offset = position - 1;
+        return false;
+    }
+
+    token->text = (const char*)(input + reader->offset + 1);
+    token->length = position - reader->offset - 1;
+    reader->offset = position + 1;
+
+    return true;
+}
+
+/* JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+static cJSON_bool reader_scan_number(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    const unsigned char *input = reader->content;
+    size_t position = reader->offset;
+
+#define reader_is_digit(index) (((index) < reader->length) && (input[index] >= '0') && (input[index] <= '9'))
+    if ((position < reader->length) && (input[position] == '-'))
+    {
+        position++;
+    }
+    if (!reader_is_digit(position))
+    {
+        reader->offset = position;
+        return false;
+    }
+    if (input[position] == '0')
+    {
+        position++;
+    }
+    else
+    {
+        while (reader_is_digit(position))
+        {
+            position++;
+        }
+    }
+    if ((position < reader->length) && (input[position] == '.'))
+    {
+        position++;
+        if (!reader_is_digit(position))
+        {
+            reader->offset = position;
+            return false;
+        }
+        while (reader_is_digit(position))
+        {
+            position++;
+        }
+    }
+    if ((position < reader->length) && ((input[position] == 'e') || (input[position] == 'E')))
+    {
+        position++;
+        if ((position < reader->length) && ((input[position] == '+') || (input[position] == '-')))
+        {
+            position++;
+        }
+        if (!reader_is_digit(position))
+        {
+            reader->offset = position;
+            return false;
+        }
+        while (reader_is_digit(position))
+        {
+            position++;
+        }
+    }
+#undef reader_is_digit
+
+    token->text = (const char*)(input + reader->offset);
+    token->length = position - reader->offset;
+    token->escaped = false;
+    reader->offset = position;
+
+    return true;
+}
+
+static void reader_skip_whitespace(cJSON_Reader * const reader)
+{
+    while ((reader->offset < reader->length) && (reader->content[reader->offset] <= 32) && (reader->content[reader->offset] != '\0'))
+    {
+        reader->offset++;
+    }
+}
+
+/* Read a value token, the reader is positioned at its first character */
+static int reader_value_token(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    const unsigned char *input = reader->content + reader->offset;
+    size_t available = reader->length - reader->offset;
+
+    token->text = (const char*)input;
+    token->escaped = false;
+
+    switch (*input)
+    {
+        case '{':
+        case '[':
+            if (reader->depth >= CJSON_NESTING_LIMIT)
+            {
+                return reader_fail(reader, token); /* to deeply nested */
+            }
+            if (*input == '{')
+            {
+                reader->containers[reader->depth / 8] = (unsigned char)(reader->containers[reader->depth / 8] | (1 << (reader->depth % 8)));
+                reader->state = reader_key_or_end;
+                token->type = cJSON_TokenObjectStart;
+            }
+            else
+            {
+                reader->containers[reader->depth / 8] = (unsigned char)(reader->containers[reader->depth / 8] & ~(1 << (reader->depth % 8)));
+                reader->state = reader_value_or_end;
+                token->type = cJSON_TokenArrayStart;
+            }
+            reader->depth++;
+            reader->offset++;
+            token->length = 1;
+            return token->type;
+
+        case '\"':
+            if (!reader_scan_string(reader, token))
+            {
+                return reader_fail(reader, token);
+            }
+            token->type = cJSON_TokenString;
+            break;
+
+        case 't':
+            if ((available < 4) || (strncmp((const char*)input, "true", 4) != 0))
+            {
+                return reader_fail(reader, token);
+            }
+            token->type = cJSON_TokenTrue;
+            token->length = 4;
+            reader->offset += 4;
+            break;
+
+        case 'f':
+            if ((available < 5) || (strncmp((const char*)input, "false", 5) != 0))
+            {
+                return reader_fail(reader, token);
+            }
+            token->type = cJSON_TokenFalse;
+            token->length = 5;
+            reader->offset += 5;
+            break;
+
+        case 'n':
+            if ((available < 4) || (strncmp((const char*)input, "null", 4) != 0))
+            {
+                return reader_fail(reader, token);
+            }
+            token->type = cJSON_TokenNull;
+            token->length = 4;
+            reader->offset += 4;
+            break;
+
+        default:
+            if (!reader_scan_number(reader, token))
+            {
+                return reader_fail(reader, token);
+            }
+            token->type = cJSON_TokenNumber;
+            break;
+    }
+
+    reader->state = (reader->depth == 0) ? reader_done : reader_after_value;
+
+    return token->type;
+}
+
+static int reader_key_token(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    if (reader->content[reader->offset] != '\"')
+    {
+        return reader_fail(reader, token);
+    }
+    if (!reader_scan_string(reader, token))
+    {
+        return reader_fail(reader, token);
+    }
+
+    reader_skip_whitespace(reader);
+    if ((reader->offset >= reader->length) || (reader->content[reader->offset] != ':'))
+    {
+        return reader_fail(reader, token);
+    }
+    reader->offset++;
+    reader->state = reader_value;
+
+    token->type = cJSON_TokenKey;
+    return cJSON_TokenKey;
+}
+
+static int reader_end_token(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    unsigned char character = reader->content[reader->offset];
+
+    if (((character == '}') && !reader_in_object(reader)) || ((character == ']') && reader_in_object(reader)) || ((character != '}') && (character != ']')))
+    {
+        return reader_fail(reader, token);
+    }
+
+    token->type = (character == '}') ? cJSON_TokenObjectEnd : cJSON_TokenArrayEnd;
+    token->text = (const char*)(reader->content + reader->offset);
+    token->length = 1;
+    token->escaped = false;
+    reader->offset++;
+    reader->depth--;
+    reader->state = (reader->depth == 0) ? reader_done : reader_after_value;
+
+    return token->type;
+}
+
+static int reader_next(cJSON_Reader * const reader, cJSON_Token * const token)
+{
+    if ((reader->content == NULL) || (reader->state == reader_failed))
+    {
+        return reader_fail(reader, token);
+    }
+
+    reader_skip_whitespace(reader);
+    if ((reader->offset >= reader->length) || (reader->content[reader->offset] == '\0'))
+    {
+        if (reader->state != reader_done)
+        {
+            /* input ended in the middle of the document */
+            return reader_fail(reader, token);
+        }
+
+        token->type = cJSON_TokenEnd;
+        token->text = (const char*)(reader->content + reader->offset);
+        token->length = 0;
+        return cJSON_TokenEnd;
+    }
+
+    switch (reader->state)
+    {
+        case reader_value:
+            return reader_value_token(reader, token);
+
+        case reader_value_or_end:
+            if (reader->content[reader->offset] == ']')
+            {
+                return reader_end_token(reader, token);
+            }
+            return reader_value_token(reader, token);
+
+        case reader_key_or_end:
+            if (reader->content[reader->offset] == '}')
+            {
+                return reader_end_token(reader, token);
+            }
+            return reader_key_token(reader, token);
+
+        case reader_key:
+            return reader_key_token(reader, token);
+
+        case reader_after_value:
+            if (reader->content[reader->offset] != ',')
+            {
+                return reader_end_token(reader, token);
+            }
+            reader->offset++;
+            reader_skip_whitespace(reader);
+            if (reader->offset >= reader->length)
+            {
+                return reader_fail(reader, token);
+            }
+            if (reader_in_object(reader))
+            {
+                return reader_key_token(reader, token);
+            }
+            return reader_value_token(reader, token);
+
+        default:
+            /* garbage after the document */
+            return reader_fail(reader, token);
+    }
+}
+
+CJSON_PUBLIC(int) cJSON_ReaderNext(cJSON_Reader *reader, cJSON_Token *token)
+{
+    size_t offset = 0;
+    size_t more = CJSON_READER_STITCH_SIZE;
+    int state = 0;
+    int type = 0;
+
+    if ((reader == NULL) || (token == NULL))
+    {
+        return cJSON_TokenError;
+    }
+    if (reader->segments == NULL)
+    {
+        return reader_next(reader, token);
+    }
+
+    for (;;)
+    {
+        /* between tokens the next segment can simply be switched to */
+        reader_skip_whitespace(reader);
+        while ((reader->offset >= reader->length) && (reader->state != reader_failed) && reader_next_segment(reader))
+        {
+            reader_skip_whitespace(reader);
+        }
+
+        offset = reader->offset;
+        state = reader->state;
+        type = reader_next(reader, token);
+        /* A token that runs into the end of content may continue in the next segment. All the ways that fails
+         * report an error within the last few bytes (at most "\\uXXXX"), and a number may just look complete. */
+        if (((type == cJSON_TokenError) && (state != reader_failed) && ((reader->error_position - reader->position + 6) >= reader->length))
+            || ((type == cJSON_TokenNumber) && (reader->offset == reader->length)))
+        {
+            if (reader_has_more(reader))
+            {
+                reader->offset = offset;
+                reader->state = state;
+                if (reader_stitch(reader, offset, more))
+                {
+                    more *= 2;
+                    continue;
+                }
+                /* out of memory */
+                return reader_fail(reader, token);
+            }
+        }
+
+        return type;
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_ReaderSkip(cJSON_Reader *reader)
+{
+    cJSON_Token token;
+    size_t depth = 0;
+
+    if (reader == NULL)
+    {
+        return false;
+    }
+
+    depth = reader->depth;
+    do
+    {
+        switch (cJSON_ReaderNext(reader, &token))
+        {
+            case cJSON_TokenError:
+            case cJSON_TokenEnd:
+                return false;
+
+            case cJSON_TokenObjectEnd:
+            case cJSON_TokenArrayEnd:
+                if (reader->depth < depth)
+                {
+                    /* there was no value left in the current array/object */
+                    return true;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+    while (reader->depth > depth);
+
+    return true;
+}
+
+/* Get the next unescaped byte(s) of a string token, returns how many were written to output */
+static size_t next_unescaped(const unsigned char **input, const unsigned char * const input_end, unsigned char output[4])
+{
+    const unsigned char *sequence_end = *input + 1;
+    unsigned char *output_end = NULL;
+
+    if (**input != '\\')
+    {
+        output[0] = *(*input)++;
+        return 1;
+    }
+
+    /* escape sequence, a surrogate pair may take two of them */
+    sequence_end = *input + 2;
+    if (((*input)[1] == 'u') && ((input_end - *input) >= 6))
+    {
+        sequence_end = *input + 6;
+        if (((input_end - *input) >= 12) && ((*input)[6] == '\\') && ((*input)[7] == 'u'))
+        {
+            sequence_end = *input + 12;
+        }
+    }
+    if (sequence_end > input_end)
+    {
+        sequence_end = input_end;
+    }
+
+    output_end = unescape_string(input, sequence_end, output);
+    if (output_end == NULL)
+    {
+        return 0;
+    }
+
+    return (size_t)(output_end - output);
+}
+
+/* compare a string or key token with length bytes of string */
+static cJSON_bool token_equals(const cJSON_Token * const token, const char * const string, const size_t length)
+{
+    const unsigned char *input = NULL;
+    const unsigned char *input_end = NULL;
+    const unsigned char *compare = (const unsigned char*)string;
+    const unsigned char *compare_end = compare + length;
+
+    if (!token->escaped)
+    {
+        return (token->length == length) && (memcmp(token->text, string, length) == 0);
+    }
+
+    input = (const unsigned char*)token->text;
+    input_end = input + token->length;
+    while (input < input_end)
+    {
+        unsigned char decoded[4];
+        size_t decoded_length = next_unescaped(&input, input_end, decoded);
+        if ((decoded_length == 0) || (decoded_length > (size_t)(compare_end - compare)))
+        {
+            return false;
+        }
+        if (memcmp(compare, decoded, decoded_length) != 0)
+        {
+            return false;
+        }
+        compare += decoded_length;
+    }
+
+    return compare == compare_end;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenEquals(const cJSON_Token *token, const char *string)
+{
+    if ((token == NULL) || (string == NULL) || (token->text == NULL))
+    {
+        return false;
+    }
+
+    return token_equals(token, string, strlen(string));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenToNumber(const cJSON_Token *token, double *number)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON item;
+
+    if ((token == NULL) || (number == NULL) || (token->type != cJSON_TokenNumber))
+    {
+        return false;
+    }
+
+    memset(&item, '\0', sizeof(item));
+    buffer.content = (const unsigned char*)token->text;
+    buffer.length = token->length;
+    buffer.hooks = global_hooks;
+    if (!parse_number(&item, &buffer))
+    {
+        return false;
+    }
+
+    *number = item.valuedouble;
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenToInt64(const cJSON_Token *token, cJSON_int64 *number)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON item;
+
+    if ((token == NULL) || (number == NULL) || (token->type != cJSON_TokenNumber))
+    {
+        return false;
+    }
+
+    memset(&item, '\0', sizeof(item));
+    buffer.content = (const unsigned char*)token->text;
+    buffer.length = token->length;
+    buffer.hooks = global_hooks;
+    if (!parse_number(&item, &buffer))
+    {
+        return false;
+    }
+
+    *number = cJSON_GetInt64Value(&item);
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenCopyString(const cJSON_Token *token, char *buffer, size_t size)
+{
+    const unsigned char *input = NULL;
+    const unsigned char *input_end = NULL;
+    unsigned char *output = (unsigned char*)buffer;
+
+    if ((token == NULL) || (buffer == NULL) || (size == 0) || (token->text == NULL))
+    {
+        return false;
+    }
+
+    input = (const unsigned char*)token->text;
+    input_end = input + token->length;
+    if (token->length < size)
+    {
+        /* the unescaped string is never longer than the escaped one */
+        output = unescape_string(&input, input_end, output);
+        if (output == NULL)
+        {
+            buffer[0] = '\0';
+            return false;
+        }
+        *output = '\0';
+        return true;
+    }
+
+    while (input < input_end)
+    {
+        unsigned char decoded[4];
+        size_t decoded_length = next_unescaped(&input, input_end, decoded);
+        if ((decoded_length == 0) || ((size_t)(output - (unsigned char*)buffer) + decoded_length >= size))
+        {
+            buffer[0] = '\0';
+            return false;
+        }
+        memcpy(output, decoded, decoded_length);
+        output += decoded_length;
+    }
+    *output = '\0';
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseTokens(const char *json, size_t length, cJSON_TokenCallback callback, void *user_data)
+{
+    cJSON_Reader reader;
+    cJSON_Token token;
+
+    if (callback == NULL)
+    {
+        return false;
+    }
+
+    cJSON_InitReader(&reader, json, length);
+    for (;;)
+    {
+        switch (cJSON_ReaderNext(&reader, &token))
+        {
+            case cJSON_TokenError:
+                return false;
+
+            case cJSON_TokenEnd:
+                return true;
+
+            default:
+                if (!callback(&token, reader.depth, user_data))
+                {
+                    /* the consumer has what it needs */
+                    return true;
+                }
+                break;
+        }
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Validate(const char *json, size_t length, size_t *error_offset)
+{
+    cJSON_Reader reader;
+    cJSON_Token token;
+    int type = 0;
+
+    cJSON_InitReader(&reader, json, length);
+    do
+    {
+        type = cJSON_ReaderNext(&reader, &token);
+    } while ((type != cJSON_TokenEnd) && (type != cJSON_TokenError));
+
+    /* the reader stops at a null byte, but all length bytes belong to the document */
+    if ((type == cJSON_TokenEnd) && (reader.offset < length))
+    {
+        type = reader_fail(&reader, &token);
+    }
+
+    if (error_offset != NULL)
+    {
+        *error_offset = (type == cJSON_TokenError) ? reader.error_position : 0;
+    }
+
+    return type == cJSON_TokenEnd;
+}
+
+/* Skip what is left of a value after its first token */
+static cJSON_bool reader_finish_value(cJSON_Reader * const reader, const size_t depth)
+{
+    while (reader->depth > depth)
+    {
+        if (!cJSON_ReaderSkip(reader))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Get segment number level of a path like "a.b.c", NULL if the path is shorter */
+static const char *path_segment(const char *path, size_t level, size_t * const length)
+{
+    const char *end = NULL;
+
+    while (level > 0)
+    {
+        path = strchr(path, '.');
+        if (path == NULL)
+        {
+            return NULL;
+        }
+        path++;
+        level--;
+    }
+
+    end = strchr(path, '.');
+    *length = (end != NULL) ? (size_t)(end - path) : strlen(path);
+
+    return path;
+}
+
+/* copy a string token into memory from the hooks */
+static char *decode_string(const cJSON_Token * const token)
+{
+    /* the unescaped string is never longer than the escaped one */
+    char *string = (char*)global_hooks.allocate(token->length + sizeof(""));
+    if (string == NULL)
+    {
+        return NULL;
+    }
+    if (!cJSON_TokenCopyString(token, string, token->length + sizeof("")))
+    {
+        global_hooks.deallocate(string);
+        return NULL;
+    }
+
+    return string;
+}
+
+static void free_string_array(char **strings, const int count)
+{
+    int i = 0;
+
+    if (strings == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < count; i++)
+    {
+        global_hooks.deallocate(strings[i]);
+    }
+    global_hooks.deallocate(strings);
+}
+
+/* Decode the array whose '[' was just read, strings are kept and everything else is skipped */
+static cJSON_bool decode_string_array(cJSON_Reader * const reader, const cJSON_Field * const field, unsigned char * const target)
+{
+    cJSON_Token token;
+    char **strings = NULL;
+    size_t capacity = 0;
+    int count = 0;
+    int type = 0;
+    const size_t depth = reader->depth;
+
+    while ((type = cJSON_ReaderNext(reader, &token)) != cJSON_TokenArrayEnd)
+    {
+        char *string = NULL;
+
+        if (type == cJSON_TokenError)
+        {
+            goto fail;
+        }
+        if (type != cJSON_TokenString)
+        {
+            if (!reader_finish_value(reader, depth))
+            {
+                goto fail;
+            }
+            continue;
+        }
+
+        if ((size_t)count == capacity)
+        {
+            size_t new_capacity = (capacity == 0) ? 4 : capacity * 2;
+            char **new_strings = NULL;
+            if (new_capacity > (size_t)INT_MAX)
+            {
+                goto fail;
+            }
+            new_strings = (char**)global_hooks.allocate(new_capacity * sizeof(char*));
+            if (new_strings == NULL)
+            {
+                goto fail;
+            }
+            if (strings != NULL)
+            {
+                memcpy(new_strings, strings, (size_t)count * sizeof(char*));
+                global_hooks.deallocate(strings);
+            }
+            strings = new_strings;
+            capacity = new_capacity;
+        }
+
+        string = decode_string(&token);
+        if (string == NULL)
+        {
+            goto fail;
+        }
+        strings[count++] = string;
+    }
+
+    /* a repeated key replaces the earlier value */
+    free_string_array(*(char***)(target + field->offset), *(int*)(target + field->count_offset));
+    *(char***)(target + field->offset) = strings;
+    *(int*)(target + field->count_offset) = count;
+
+    return true;
+
+fail:
+    free_string_array(strings, count);
+
+    return false;
+}
+
+static cJSON_bool decode_object(cJSON_Reader * const reader, const cJSON_Field * const fields, unsigned char * const target, const unsigned long active, const size_t level, unsigned long * const found);
+
+/* Decode the next value into a field, a value of another type leaves the field alone */
+static cJSON_bool decode_field(cJSON_Reader * const reader, const cJSON_Field * const field, unsigned char * const target, cJSON_bool * const stored)
+{
+    cJSON_Token token;
+    const size_t depth = reader->depth;
+    double number = 0;
+    int type = cJSON_ReaderNext(reader, &token);
+
+    *stored = false;
+    switch (type)
+    {
+        case cJSON_TokenError:
+            return false;
+
+        case cJSON_TokenNumber:
+            if (field->type == cJSON_FieldInt64)
+            {
+                if (!cJSON_TokenToInt64(&token, (cJSON_int64*)(target + field->offset)))
+                {
+                    return false;
+                }
+                *stored = true;
+                return true;
+            }
+            if (!cJSON_TokenToNumber(&token, &number))
+            {
+                return false;
+            }
+            if (field->type == cJSON_FieldInt)
+            {
+                /* saturate like valueint */
+                if (number >= INT_MAX)
+                {
+                    *(int*)(target + field->offset) = INT_MAX;
+                }
+                else if (number <= (double)INT_MIN)
+                {
+                    *(int*)(target + field->offset) = INT_MIN;
+                }
+                else
+                {
+                    *(int*)(target + field->offset) = (int)number;
+                }
+                *stored = true;
+            }
+            else if (field->type == cJSON_FieldDouble)
+            {
+                *(double*)(target + field->offset) = number;
+                *stored = true;
+            }
+            return true;
+
+        case cJSON_TokenTrue:
+        case cJSON_TokenFalse:
+            if (field->type == cJSON_FieldBool)
+            {
+                *(cJSON_bool*)(target + field->offset) = (type == cJSON_TokenTrue);
+                *stored = true;
+            }
+            return true;
+
+        case cJSON_TokenString:
+            if (field->type == cJSON_FieldString)
+            {
+                char *string = decode_string(&token);
+                if (string == NULL)
+                {
+                    return false;
+                }
+                if (*(char**)(target + field->offset) != NULL)
+                {
+                    global_hooks.deallocate(*(char**)(target + field->offset));
+                }
+                *(char**)(target + field->offset) = string;
+                *stored = true;
+            }
+            return true;
+
+        case cJSON_TokenArrayStart:
+            if (field->type == cJSON_FieldStringArray)
+            {
+                *stored = decode_string_array(reader, field, target);
+                return *stored;
+            }
+            return reader_finish_value(reader, depth);
+
+        case cJSON_TokenObjectStart:
+            if ((field->type == cJSON_FieldObject) && (field->fields != NULL))
+            {
+                unsigned long nested_found = 0;
+                *stored = true;
+                return decode_object(reader, field->fields, target + field->offset, ~0UL, 0, &nested_found);
+            }
+            return reader_finish_value(reader, depth);
+
+        default:
+            return true;
+    }
+}
+
+/* Decode the members of the object whose '{' was just read into the active fields,
+ * level is the number of path segments that lead to this object */
+static cJSON_bool decode_object(cJSON_Reader * const reader, const cJSON_Field * const fields, unsigned char * const target, const unsigned long active, const size_t level, unsigned long * const found)
+{
+    cJSON_Token token;
+    int type = 0;
+
+    while ((type = cJSON_ReaderNext(reader, &token)) == cJSON_TokenKey)
+    {
+        const cJSON_Field *field = NULL;
+        unsigned long field_bit = 0;
+        unsigned long nested = 0;
+        unsigned long bit = 1;
+        size_t i = 0;
+
+        for (i = 0; fields[i].path != NULL; (void)i++, bit <<= 1)
+        {
+            size_t segment_length = 0;
+            const char *segment = NULL;
+
+            if ((active & bit) == 0)
+            {
+                continue;
+            }
+            segment = path_segment(fields[i].path, level, &segment_length);
+            if ((segment == NULL) || !token_equals(&token, segment, segment_length))
+            {
+                continue;
+            }
+
+            if (segment[segment_length] == '\0')
+            {
+                if (field == NULL)
+                {
+                    field = &fields[i];
+                    field_bit = bit;
+                }
+            }
+            else
+            {
+                nested |= bit;
+            }
+        }
+
+        if (field != NULL)
+        {
+            cJSON_bool stored = false;
+            if (!decode_field(reader, field, target, &stored))
+            {
+                return false;
+            }
+            if (stored)
+            {
+                *found |= field_bit;
+            }
+        }
+        else if (nested != 0)
+        {
+            const size_t depth = reader->depth;
+            type = cJSON_ReaderNext(reader, &token);
+            if (type == cJSON_TokenError)
+            {
+                return false;
+            }
+            if (type == cJSON_TokenObjectStart)
+            {
+                if (!decode_object(reader, fields, target, nested, level + 1, found))
+                {
+                    return false;
+                }
+            }
+            else if (!reader_finish_value(reader, depth))
+            {
+                return false;
+            }
+        }
+        else if (!cJSON_ReaderSkip(reader))
+        {
+            return false;
+        }
+    }
+
+    return type == cJSON_TokenObjectEnd;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_DecodeObject(cJSON_Reader *reader, const cJSON_Field *fields, void *target, unsigned long *found)
+{
+    cJSON_Token token;
+    unsigned long found_fields = 0;
+    size_t field_count = 0;
+    size_t depth = 0;
+    cJSON_bool success = false;
+
+    if (found != NULL)
+    {
+        *found = 0;
+    }
+    if ((reader == NULL) || (fields == NULL) || (target == NULL))
+    {
+        return false;
+    }
+
+    while (fields[field_count].path != NULL)
+    {
+        field_count++;
+    }
+    if (field_count > CJSON_DECODE_MAX_FIELDS)
+    {
+        return false;
+    }
+
+    depth = reader->depth;
+    switch (cJSON_ReaderNext(reader, &token))
+    {
+        case cJSON_TokenError:
+        case cJSON_TokenEnd:
+            return false;
+
+        case cJSON_TokenObjectStart:
+            success = decode_object(reader, fields, (unsigned char*)target, ~0UL, 0, &found_fields);
+            break;
+
+        default:
+            /* not an object, nothing to decode */
+            success = reader_finish_value(reader, depth);
+            break;
+    }
+
+    if (found != NULL)
+    {
+        *found = found_fields;
+    }
+
+    return success;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Decode(const char *json, size_t length, const cJSON_Field *fields, void *target, unsigned long *found)
+{
+    cJSON_Reader reader;
+
+    cJSON_InitReader(&reader, json, length);
+    return cJSON_DecodeObject(&reader, fields, target, found);
+}
+
+CJSON_PUBLIC(void) cJSON_FreeDecoded(const cJSON_Field *fields, void *target)
+{
+    unsigned char *base = (unsigned char*)target;
+    size_t i = 0;
+
+    if ((fields == NULL) || (target == NULL))
+    {
+        return;
+    }
+
+    for (i = 0; fields[i].path != NULL; i++)
+    {
+        switch (fields[i].type)
+        {
+            case cJSON_FieldString:
+                if (*(char**)(base + fields[i].offset) != NULL)
+                {
+                    global_hooks.deallocate(*(char**)(base + fields[i].offset));
+                }
+                *(char**)(base + fields[i].offset) = NULL;
+                break;
+
+            case cJSON_FieldStringArray:
+                free_string_array(*(char***)(base + fields[i].offset), *(int*)(base + fields[i].count_offset));
+                *(char***)(base + fields[i].offset) = NULL;
+                *(int*)(base + fields[i].count_offset) = 0;
+                break;
+
+            case cJSON_FieldObject:
+                cJSON_FreeDecoded(fields[i].fields, base + fields[i].offset);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/* Compiled queries are a trie of pointer segments, so documents are walked once for all of them */
+typedef struct query_node
+{
+    struct query_node *child;
+    struct query_node *next;
+    /* unescaped member name, also matches the array element it is the index of */
+    char *segment;
+    size_t segment_length;
+    cJSON_bool is_index;
+    size_t index;
+    /* position + 1 of the pointer that ends here, 0 if none does */
+    size_t result;
+} query_node;
+
+struct cJSON_Query
+{
+    internal_hooks hooks;
+    query_node *root;
+    size_t count;
+};
+
+typedef struct
+{
+    cJSON_Reader reader;
+    cJSON **results;
+    /* pointers that didn't match yet */
+    size_t remaining;
+} query_run;
+
+static void free_query_nodes(query_node *node, const internal_hooks * const hooks)
+{
+    while (node != NULL)
+    {
+        query_node *next = node->next;
+        free_query_nodes(node->child, hooks);
+        if (node->segment != NULL)
+        {
+            hooks->deallocate(node->segment);
+        }
+        hooks->deallocate(node);
+        node = next;
+    }
+}
+
+static query_node *create_query_node(const internal_hooks * const hooks)
+{
+    query_node *node = (query_node*)hooks->allocate(sizeof(query_node));
+    if (node != NULL)
+    {
+        memset(node, '\0', sizeof(query_node));
+    }
+
+    return node;
+}
+
+/* Find or add the child of parent for the pointer segment at *pointer and move past it */
+static query_node *query_child(const internal_hooks * const hooks, query_node * const parent, const char ** const pointer)
+{
+    const char *raw = *pointer;
+    const size_t raw_length = strcspn(raw, "/");
+    query_node *child = NULL;
+    char *segment = NULL;
+    size_t length = 0;
+    size_t i = 0;
+
+    /* unescaping only ever makes it shorter */
+    segment = (char*)hooks->allocate(raw_length + sizeof(""));
+    if (segment == NULL)
+    {
+        return NULL;
+    }
+    for (i = 0; i < raw_length; i++)
+    {
+        if (raw[i] != '~')
+        {
+            segment[length++] = raw[i];
+            continue;
+        }
+        if ((i + 1) == raw_length)
+        {
+            goto fail;
+        }
+        i++;
+        if (raw[i] == '0')
+        {
+            segment[length++] = '~';
+        }
+        else if (raw[i] == '1')
+        {
+            segment[length++] = '/';
+        }
+        else
+        {
+            goto fail;
+        }
+    }
+    segment[length] = '\0';
+    *pointer = raw + raw_length;
+
+    for (child = parent->child; child != NULL; child = child->next)
+    {
+        if ((child->segment_length == length) && (memcmp(child->segment, segment, length) == 0))
+        {
+            hooks->deallocate(segment);
+            return child;
+        }
+    }
+
+    child = create_query_node(hooks);
+    if (child == NULL)
+    {
+        goto fail;
+    }
+    child->segment = segment;
+    child->segment_length = length;
+
+    /* array indices are decimal without leading zeros */
+    child->is_index = (length > 0) && ((length == 1) || (segment[0] != '0'));
+    for (i = 0; child->is_index && (i < length); i++)
+    {
+        if ((segment[i] < '0') || (segment[i] > '9') || (child->index > (((size_t)-1) - 9) / 10))
+        {
+            child->is_index = false;
+        }
+        else
+        {
+            child->index = (child->index * 10) + (size_t)(segment[i] - '0');
+        }
+    }
+
+    child->next = parent->child;
+    parent->child = child;
+
+    return child;
+
+fail:
+    hooks->deallocate(segment);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON_Query *) cJSON_CompileQueries(const char * const *pointers, size_t count)
+{
+    cJSON_Query *query = NULL;
+    size_t i = 0;
+
+    if ((pointers == NULL) && (count > 0))
+    {
+        return NULL;
+    }
+
+    query = (cJSON_Query*)global_hooks.allocate(sizeof(cJSON_Query));
+    if (query == NULL)
+    {
+        return NULL;
+    }
+    memset(query, '\0', sizeof(cJSON_Query));
+    query->hooks = global_hooks;
+    query->count = count;
+
+    query->root = create_query_node(&query->hooks);
+    if (query->root == NULL)
+    {
+        goto fail;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        const char *pointer = pointers[i];
+        query_node *node = query->root;
+
+        /* "" is the whole document, everything else starts with '/' */
+        if ((pointer == NULL) || ((*pointer != '\0') && (*pointer != '/')))
+        {
+            goto fail;
+        }
+        while (*pointer == '/')
+        {
+            pointer++;
+            node = query_child(&query->hooks, node, &pointer);
+            if (node == NULL)
+            {
+                goto fail;
+            }
+        }
+        if (node->result != 0)
+        {
+            goto fail;
+        }
+        node->result = i + 1;
+    }
+
+    return query;
+
+fail:
+    cJSON_DeleteQuery(query);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteQuery(cJSON_Query *query)
+{
+    if (query == NULL)
+    {
+        return;
+    }
+
+    free_query_nodes(query->root, &query->hooks);
+    query->hooks.deallocate(query);
+}
+
+/* Parse the text of a matched value into a tree */
+static cJSON_bool query_capture(query_run * const run, const query_node * const node, const char * const start, const char * const end)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    cJSON *item = NULL;
+
+    /* of repeated keys the first one counts, like in cJSON_GetObjectItem */
+    if (run->results[node->result - 1] != NULL)
+    {
+        return true;
+    }
+
+    buffer.content = (const unsigned char*)start;
+    buffer.length = (size_t)(end - start);
+    buffer.hooks = global_hooks;
+
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL)
+    {
+        return false;
+    }
+    if (!parse_value(item, &buffer))
+    {
+        cJSON_Delete(item);
+        return false;
+    }
+
+    run->results[node->result - 1] = item;
+    run->remaining--;
+
+    return true;
+}
+
+/* Walk the value that starts with token, node is where it is in the trie */
+static cJSON_bool query_value(query_run * const run, const query_node * const node, const cJSON_Token * const token)
+{
+    cJSON_Reader * const reader = &run->reader;
+    const char *start = token->text;
+    const char *end = token->text + token->length;
+    const size_t depth = reader->depth;
+    const query_node *child = NULL;
+    cJSON_Token next;
+    size_t index = 0;
+    int type = 0;
+
+    if (token->type == cJSON_TokenString)
+    {
+        /* include the quotes */
+        start--;
+        end++;
+    }
+    else if ((token->type == cJSON_TokenObjectStart) || (token->type == cJSON_TokenArrayStart))
+    {
+        if (node->child == NULL)
+        {
+            /* no pointer goes further down */
+            if (!reader_finish_value(reader, depth - 1))
+            {
+                return false;
+            }
+        }
+        else if (token->type == cJSON_TokenObjectStart)
+        {
+            while ((type = cJSON_ReaderNext(reader, &next)) == cJSON_TokenKey)
+            {
+                for (child = node->child; child != NULL; child = child->next)
+                {
+                    if (token_equals(&next, child->segment, child->segment_length))
+                    {
+                        break;
+                    }
+                }
+
+                if (cJSON_ReaderNext(reader, &next) == cJSON_TokenError)
+                {
+                    return false;
+                }
+                if ((child != NULL) ? !query_value(run, child, &next) : !reader_finish_value(reader, depth))
+                {
+                    return false;
+                }
+                if (run->remaining == 0)
+                {
+                    return true;
+                }
+            }
+            if (type != cJSON_TokenObjectEnd)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            for (index = 0; (type = cJSON_ReaderNext(reader, &next)) != cJSON_TokenArrayEnd; index++)
+            {
+                if (type == cJSON_TokenError)
+                {
+                    return false;
+                }
+
+                for (child = node->child; child != NULL; child = child->next)
+                {
+                    if (child->is_index && (child->index == index))
+                    {
+                        break;
+                    }
+                }
+
+                if ((child != NULL) ? !query_value(run, child, &next) : !reader_finish_value(reader, depth))
+                {
+                    return false;
+                }
+                if (run->remaining == 0)
+                {
+                    return true;
+                }
+            }
+        }
+        end = (const char*)(reader->content + reader->offset);
+    }
+
+    if (node->result == 0)
+    {
+        return true;
+    }
+
+    return query_capture(run, node, start, end);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_RunQueries(const cJSON_Query *query, const char *json, size_t length, cJSON **results)
+{
+    query_run run;
+    cJSON_Token token;
+    size_t i = 0;
+
+    if ((query == NULL) || ((results == NULL) && (query->count > 0)))
+    {
+        return false;
+    }
+    for (i = 0; i < query->count; i++)
+    {
+        results[i] = NULL;
+    }
+    if (json == NULL)
+    {
+        return false;
+    }
+
+    cJSON_InitReader(&run.reader, json, length);
+    run.results = results;
+    run.remaining = query->count;
+
+    switch (cJSON_ReaderNext(&run.reader, &token))
+    {
+        case cJSON_TokenError:
+        case cJSON_TokenEnd:
+            break;
+
+        default:
+            if (query_value(&run, query->root, &token))
+            {
+                return true;
+            }
+            break;
+    }
+
+    for (i = 0; i < query->count; i++)
+    {
+        cJSON_Delete(results[i]);
+        results[i] = NULL;
+    }
+
+    return false;
+}
+
+static cJSON_bool measure_value(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length);
+
+/* length of a string once escaped and quoted */
+static size_t measure_string(const unsigned char * const input)
+{
+    size_t length = 0;
+
+    if (input == NULL)
+    {
+        return sizeof("\"\"") - 1;
+    }
+
+    return count_escape_characters(input, &length) + length + sizeof("\"\"") - 1;
+}
+
+static cJSON_bool measure_array(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    const cJSON *current_element = NULL;
+
+    if (!lazy_expand(item))
+    {
+        return false;
+    }
+
+    *length += sizeof("[]") - 1;
+    for (current_element = item->child; current_element != NULL; current_element = current_element->next)
+    {
+        if (!measure_value(current_element, format, depth + 1, length))
+        {
+            return false;
+        }
+        if (current_element->next != NULL)
+        {
+            *length += format ? 2 : 1; /* ", " */
+        }
+    }
+
+    return true;
+}
+
+static cJSON_bool measure_object(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    const cJSON *current_item = NULL;
+
+    if (!lazy_expand(item))
+    {
+        return false;
+    }
+
+    *length += format ? 2 : 1; /* fmt: {\n */
+    for (current_item = item->child; current_item != NULL; current_item = current_item->next)
+    {
+        if (format)
+        {
+            *length += depth + 1; /* indentation */
+        }
+        *length += measure_string((const unsigned char*)current_item->string);
+        *length += format ? 2 : 1; /* ":\t" */
+        if (!measure_value(current_item, format, depth + 1, length))
+        {
+            return false;
+        }
+        *length += (size_t)(format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0); /* ",\n" */
+    }
+
+    if (format)
+    {
+        *length += depth;
+    }
+    *length += 1; /* } */
+
+    return true;
+}
+
+/* Add the exact number of characters print_value produces for item at the given depth to length.
+ * Returns 0 if it can't be printed. */
+static cJSON_bool measure_value(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    unsigned char number_buffer[26];
+
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            *length += sizeof("null") - 1;
+            return true;
+
+        case cJSON_False:
+            *length += sizeof("false") - 1;
+            return true;
+
+        case cJSON_True:
+            *length += sizeof("true") - 1;
+            return true;
+
+        case cJSON_Number:
+            *length += (size_t)format_number(item, number_buffer);
+            return true;
+
+        case cJSON_Raw:
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+            /* may well be empty */
+            *length += strlen(item->valuestring);
+            return true;
+
+        case cJSON_String:
+            *length += measure_string((const unsigned char*)item->valuestring);
+            return true;
+
+        case cJSON_Array:
+            return measure_array(item, format, depth, length);
+
+        case cJSON_Object:
+            return measure_object(item, format, depth, length);
+
+        default:
+            return false;
+    }
+}
+
+static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
+{
+    printbuffer buffer[1];
+    size_t length = 0;
+
+    memset(buffer, 0, sizeof(buffer));
+
+    /* size the output up front so it is allocated once and never moved */
+    if (!measure_value(item, format, 0, &length))
+    {
+        return NULL;
+    }
+
+    buffer->buffer = (unsigned char*) hooks->allocate(length + sizeof(""));
+    buffer->length = length + sizeof("");
+    buffer->noalloc = true;
+    buffer->format = format;
+    buffer->hooks = *hooks;
+    if (buffer->buffer == NULL)
+    {
+        return NULL;
+    }
+
+    if (!print_value(item, buffer))
+    {
+        hooks->deallocate(buffer->buffer);
+        return NULL;
+    }
+
+    return buffer->buffer;
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format)
+{
+    size_t length = 0;
+
+    if (!measure_value(item, format, 0, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+struct cJSON_Printer
+{
+    internal_hooks hooks;
+    unsigned char *buffer;
+    size_t capacity;
+};
+
+CJSON_PUBLIC(cJSON_Printer *) cJSON_CreatePrinter(void)
+{
+    cJSON_Printer *printer = (cJSON_Printer*)global_hooks.allocate(sizeof(cJSON_Printer));
+    if (printer == NULL)
+    {
+        return NULL;
+    }
+    memset(printer, '\0', sizeof(cJSON_Printer));
+    printer->hooks = global_hooks;
+
+    return printer;
+}
+
+CJSON_PUBLIC(void) cJSON_DeletePrinter(cJSON_Printer *printer)
+{
+    if (printer == NULL)
+    {
+        return;
+    }
+
+    if (printer->buffer != NULL)
+    {
+        printer->hooks.deallocate(printer->buffer);
+    }
+    printer->hooks.deallocate(printer);
+}
+
+CJSON_PUBLIC(const char *) cJSON_PrinterPrint(cJSON_Printer *printer, const cJSON *item, cJSON_bool format, size_t *length)
+{
+    printbuffer buffer = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    size_t needed = 0;
+
+    if (printer == NULL)
+    {
+        return NULL;
+    }
+
+    if (!measure_value(item, format, 0, &needed))
+    {
+        return NULL;
+    }
+    needed += sizeof("");
+
+    /* the old content doesn't matter, so don't reallocate it */
+    if (needed > printer->capacity)
+    {
+        size_t capacity = printer->capacity * 2;
+        if (capacity < needed)
+        {
+            capacity = needed;
+        }
+        if (printer->buffer != NULL)
+        {
+            printer->hooks.deallocate(printer->buffer);
+        }
+        printer->capacity = 0;
+        printer->buffer = (unsigned char*)printer->hooks.allocate(capacity);
+        if (printer->buffer == NULL)
+        {
+            return NULL;
+        }
+        printer->capacity = capacity;
+    }
+
+    buffer.buffer = printer->buffer;
+    buffer.length = printer->capacity;
+    buffer.noalloc = true;
+    buffer.format = format;
+    buffer.hooks = printer->hooks;
+    if (!print_value(item, &buffer))
+    {
+        return NULL;
+    }
+
+    if (length != NULL)
+    {
+        *length = needed - sizeof("");
+    }
+
+    return (const char*)printer->buffer;
+}
+
+/* Render a cJSON item/entity/structure to text. */
+CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+{
+    return (char*)print(item, true, &global_hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+{
+    return (char*)print(item, false, &global_hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+
+    if (prebuffer < 0)
+    {
+        return NULL;
+    }
+
+    p.buffer = (unsigned char*)global_hooks.allocate((size_t)prebuffer);
+    if (!p.buffer)
+    {
+        return NULL;
+    }
+
+    p.length = (size_t)prebuffer;
+    p.offset = 0;
+    p.noalloc = false;
+    p.format = fmt;
+    p.hooks = global_hooks;
+
+    if (!print_value(item, &p))
+    {
+        global_hooks.deallocate(p.buffer);
+        p.buffer = NULL;
+        return NULL;
+    }
+
+    return (char*)p.buffer;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+
+    if ((length < 0) || (buffer == NULL))
+    {
+        return false;
+    }
+
+    p.buffer = (unsigned char*)buffer;
+    p.length = (size_t)length;
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+
+    return print_value(item, &p);
+}
+
+/* CBOR major types, RFC 8949 section 3.1 */
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_TAG 6
+#define CBOR_SIMPLE 7
+/* additional information of an indefinite length, which a break ends */
+#define CBOR_INDEFINITE 31
+#define CBOR_BREAK 0xFF
+
+#define CBOR_FALSE 20
+#define CBOR_TRUE 21
+#define CBOR_NULL 22
+#define CBOR_UNDEFINED 23
+#define CBOR_HALF 25
+#define CBOR_SINGLE 26
+#define CBOR_DOUBLE 27
+
+/* Append bytes, the printbuffer stays null terminated like it does for JSON text */
+static cJSON_bool cbor_put(printbuffer * const buffer, const unsigned char * const bytes, const size_t length)
+{
+    unsigned char *output = ensure(buffer, length + sizeof(""));
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    if (length > 0)
+    {
+        memcpy(output, bytes, length);
+    }
+    output[length] = '\0';
+    buffer->offset += length;
+
+    return true;
+}
+
+/* initial byte and argument in their shortest form */
+static cJSON_bool cbor_put_head(printbuffer * const buffer, const int major, const cjson_uint64 argument)
+{
+    unsigned char head[9];
+    size_t bytes = 0;
+    size_t i = 0;
+
+    if (argument < 24)
+    {
+        head[0] = (unsigned char)((major << 5) | (int)argument);
+        return cbor_put(buffer, head, 1);
+    }
+
+    if (argument <= 0xFF)
+    {
+        bytes = 1;
+    }
+    else if (argument <= 0xFFFF)
+    {
+        bytes = 2;
+    }
+    else if (argument <= CJSON_UINT64_C(0, 0xFFFFFFFF))
+    {
+        bytes = 4;
+    }
+    else
+    {
+        bytes = 8;
+    }
+    /* 24, 25, 26 or 27 for 1, 2, 4 or 8 bytes */
+    head[0] = (unsigned char)((major << 5) | (24 + (bytes == 1 ? 0 : (bytes == 2 ? 1 : (bytes == 4 ? 2 : 3)))));
+    for (i = 0; i < bytes; i++)
+    {
+        head[bytes - i] = (unsigned char)(argument >> (8 * i));
+    }
+
+    return cbor_put(buffer, head, bytes + 1);
+}
+
+static cJSON_bool cbor_put_int64(printbuffer * const buffer, const cJSON_int64 integer)
+{
+    if (integer < 0)
+    {
+        /* -1 - integer can't overflow, unlike -integer */
+        return cbor_put_head(buffer, CBOR_NEGATIVE, (cjson_uint64)(-1 - integer));
+    }
+
+    return cbor_put_head(buffer, CBOR_UNSIGNED, (cjson_uint64)integer);
+}
+
+static cJSON_bool cbor_put_text(printbuffer * const buffer, const char * const text)
+{
+    const size_t length = (text == NULL) ? 0 : strlen(text);
+
+    if (!cbor_put_head(buffer, CBOR_TEXT, (cjson_uint64)length))
+    {
+        return false;
+    }
+
+    return cbor_put(buffer, (const unsigned char*)text, length);
+}
+
+/* Integral numbers become integers, the rest float32 if that is exact and float64 otherwise */
+static cJSON_bool cbor_put_double(printbuffer * const buffer, const double number)
+{
+    unsigned char output[9];
+    cjson_uint64 bits = 0;
+    int exponent = 0;
+    size_t i = 0;
+
+    memcpy(&bits, &number, sizeof(bits));
+    if ((number >= -9007199254740992.0) && (number <= 9007199254740992.0) && (floor(number) == number)
+            && !((number == 0) && (bits >> 63)))
+    {
+        return cbor_put_int64(buffer, (cJSON_int64)number);
+    }
+
+    exponent = (int)((bits & DOUBLE_EXPONENT_MASK) >> DOUBLE_SIGNIFICAND_SIZE);
+    if (((bits & CJSON_UINT64_C(0, 0x1FFFFFFF)) == 0)
+            && ((exponent == 0x7FF) || ((exponent == 0) && ((bits & DOUBLE_SIGNIFICAND_MASK) == 0))
+                || ((exponent >= (0x3FF - 126)) && (exponent <= (0x3FF + 127)))))
+    {
+        /* the float32 keeps the sign, the top 23 bits of the significand and the rebiased exponent */
+        unsigned long single = (unsigned long)((bits >> 32) & 0x80000000UL) | (unsigned long)((bits & DOUBLE_SIGNIFICAND_MASK) >> 29);
+        if (exponent == 0x7FF)
+        {
+            single |= 0x7F800000UL;
+        }
+        else if (exponent != 0)
+        {
+            single |= (unsigned long)(exponent - 0x3FF + 127) << 23;
+        }
+        output[0] = (unsigned char)((CBOR_SIMPLE << 5) | CBOR_SINGLE);
+        for (i = 0; i < 4; i++)
+        {
+            output[4 - i] = (unsigned char)(single >> (8 * i));
+        }
+        return cbor_put(buffer, output, 5);
+    }
+
+    output[0] = (unsigned char)((CBOR_SIMPLE << 5) | CBOR_DOUBLE);
+    for (i = 0; i < 8; i++)
+    {
+        output[8 - i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    return cbor_put(buffer, output, 9);
+}
+
+static cJSON_bool cbor_encode_value(const cJSON * const item, printbuffer * const buffer)
+{
+    unsigned char simple = 0;
+    const cJSON *child = NULL;
+
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+            simple = (unsigned char)((CBOR_SIMPLE << 5) | CBOR_FALSE);
+            return cbor_put(buffer, &simple, 1);
+
+        case cJSON_True:
+            simple = (unsigned char)((CBOR_SIMPLE << 5) | CBOR_TRUE);
+            return cbor_put(buffer, &simple, 1);
+
+        case cJSON_NULL:
+            simple = (unsigned char)((CBOR_SIMPLE << 5) | CBOR_NULL);
+            return cbor_put(buffer, &simple, 1);
+
+        case cJSON_Number:
+            if (cJSON_IsInt64(item))
+            {
+                return cbor_put_int64(buffer, item->valueint64);
+            }
+            return cbor_put_double(buffer, item->valuedouble);
+
+        case cJSON_String:
+            return cbor_put_text(buffer, item->valuestring);
+
+        case cJSON_Array:
+        case cJSON_Object:
+            if ((buffer->depth >= CJSON_NESTING_LIMIT) || !lazy_expand(item)
+                    || !cbor_put_head(buffer, ((item->type & 0xFF) == cJSON_Array) ? CBOR_ARRAY : CBOR_MAP, (cjson_uint64)child_count(item)))
+            {
+                return false;
+            }
+            buffer->depth++;
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if (((item->type & 0xFF) == cJSON_Object) && ((child->string == NULL) || !cbor_put_text(buffer, child->string)))
+                {
+                    return false;
+                }
+                if (!cbor_encode_value(child, buffer))
+                {
+                    return false;
+                }
+            }
+            buffer->depth--;
+            return true;
+
+        default:
+            /* raw JSON has no CBOR equivalent */
+            return false;
+    }
+}
+
+/* the length of a frame as 4 bytes in front of it */
+static cJSON_bool cbor_put_frame_length(unsigned char * const header, const size_t length)
+{
+    size_t i = 0;
+
+    if ((cjson_uint64)length > CJSON_UINT64_C(0, 0xFFFFFFFF))
+    {
+        return false;
+    }
+    for (i = 0; i < CJSON_CBOR_FRAME_HEADER; i++)
+    {
+        header[CJSON_CBOR_FRAME_HEADER - 1 - i] = (unsigned char)((cjson_uint64)length >> (8 * i));
+    }
+
+    return true;
+}
+
+#define writer_is_object(writer) (((writer)->containers[((writer)->depth - 1) / 8] >> (((writer)->depth - 1) % 8)) & 1)
+
+CJSON_PUBLIC(void) cJSON_InitWriter(cJSON_Writer *writer, char *buffer, size_t length, cJSON_bool format)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    memset(writer, '\0', sizeof(cJSON_Writer));
+    writer->format = format;
+    if (buffer == NULL)
+    {
+        /* allocated on the first write */
+        writer->growable = true;
+        return;
+    }
+
+    writer->buffer = buffer;
+    writer->length = length;
+    if (length > 0)
+    {
+        buffer[0] = '\0';
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_InitCBORWriter(cJSON_Writer *writer, char *buffer, size_t length, cJSON_bool framed)
+{
+    cJSON_InitWriter(writer, buffer, length, false);
+    if (writer != NULL)
+    {
+        writer->cbor = true;
+        writer->framed = framed;
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_ResetWriter(cJSON_Writer *writer)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    writer->offset = 0;
+    writer->depth = 0;
+    writer->has_values = false;
+    writer->after_key = false;
+    writer->failed = false;
+    if ((writer->buffer != NULL) && (writer->length > 0))
+    {
+        writer->buffer[0] = '\0';
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_FreeWriter(cJSON_Writer *writer)
+{
+    if ((writer == NULL) || !writer->growable)
+    {
+        return;
+    }
+
+    if (writer->buffer != NULL)
+    {
+        global_hooks.deallocate(writer->buffer);
+    }
+    writer->buffer = NULL;
+    writer->length = 0;
+    cJSON_ResetWriter(writer);
+}
+
+static cJSON_bool writer_end(cJSON_Writer * const writer, printbuffer * const buffer, const cJSON_bool success);
+
+/* Set up a printbuffer over the writer's buffer, so the printing code can write into it */
+static cJSON_bool writer_begin(cJSON_Writer * const writer, printbuffer * const buffer)
+{
+    static const size_t default_buffer_size = 256;
+
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+
+    if (writer->buffer == NULL)
+    {
+        if (!writer->growable)
+        {
+            writer->failed = true;
+            return false;
+        }
+        writer->buffer = (char*)global_hooks.allocate(default_buffer_size);
+        if (writer->buffer == NULL)
+        {
+            writer->failed = true;
+            return false;
+        }
+        writer->length = default_buffer_size;
+        writer->buffer[0] = '\0';
+    }
+
+    memset(buffer, 0, sizeof(printbuffer));
+    buffer->buffer = (unsigned char*)writer->buffer;
+    buffer->length = writer->length;
+    buffer->offset = writer->offset;
+    buffer->depth = writer->depth;
+    buffer->noalloc = !writer->growable;
+    buffer->format = writer->format;
+    buffer->hooks = global_hooks;
+
+    if (writer->framed && (buffer->offset == 0))
+    {
+        /* room for the frame length, filled in by cJSON_WriterOutput */
+        unsigned char *header = ensure(buffer, CJSON_CBOR_FRAME_HEADER + sizeof(""));
+        if (header == NULL)
+        {
+            return writer_end(writer, buffer, false);
+        }
+        memset(header, '\0', CJSON_CBOR_FRAME_HEADER + sizeof(""));
+        buffer->offset = CJSON_CBOR_FRAME_HEADER;
+    }
+
+    return true;
+}
+
+/* Take over what was written into the printbuffer, a failed write can't be undone */
+static cJSON_bool writer_end(cJSON_Writer * const writer, printbuffer * const buffer, const cJSON_bool success)
+{
+    /* ensure frees the buffer when growing it fails */
+    writer->buffer = (char*)buffer->buffer;
+    writer->length = buffer->length;
+    if (!success || (buffer->buffer == NULL))
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    update_offset(buffer);
+    writer->offset = buffer->offset;
+
+    return true;
+}
+
+/* Write what has to come before a value and check that a value can go here */
+static cJSON_bool writer_separate_value(cJSON_Writer * const writer, printbuffer * const buffer)
+{
+    unsigned char *output = NULL;
+
+    if (writer->depth == 0)
+    {
+        /* only one document at a time */
+        return !writer->has_values;
+    }
+
+    if (writer_is_object(writer))
+    {
+        /* the separator was written with the key */
+        if (!writer->after_key)
+        {
+            return false;
+        }
+        writer->after_key = false;
+        return true;
+    }
+
+    /* CBOR needs no separators */
+    if (writer->has_values && !writer->cbor)
+    {
+        output = ensure(buffer, writer->format ? sizeof(", ") : sizeof(","));
+        if (output == NULL)
+        {
+            return false;
+        }
+        *output++ = ',';
+        if (writer->format)
+        {
+            *output++ = ' ';
+        }
+        *output = '\0';
+    }
+
+    return true;
+}
+
+/* Write a value of literal text, which the caller checked to be valid JSON */
+static cJSON_bool writer_literal(cJSON_Writer * const writer, const char * const text, const size_t length)
+{
+    printbuffer buffer;
+    unsigned char *output = NULL;
+    cJSON_bool success = false;
+
+    if (!writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if (writer->cbor)
+    {
+        /* CBOR has no text form to copy */
+        return writer_end(writer, &buffer, false);
+    }
+
+    if (writer_separate_value(writer, &buffer))
+    {
+        update_offset(&buffer);
+        output = ensure(&buffer, length + sizeof(""));
+        if (output != NULL)
+        {
+            memcpy(output, text, length);
+            output[length] = '\0';
+            success = true;
+        }
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+    writer->has_values = true;
+
+    return true;
+}
+
+static cJSON_bool writer_open(cJSON_Writer * const writer, const cJSON_bool object)
+{
+    printbuffer buffer;
+    unsigned char *output = NULL;
+    cJSON_bool success = false;
+
+    if (!writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if ((writer->depth < CJSON_NESTING_LIMIT) && writer_separate_value(writer, &buffer))
+    {
+        update_offset(&buffer);
+        if (writer->cbor)
+        {
+            /* the writer doesn't know the number of elements ahead */
+            const unsigned char head = (unsigned char)(((object ? CBOR_MAP : CBOR_ARRAY) << 5) | CBOR_INDEFINITE);
+            success = cbor_put(&buffer, &head, 1);
+        }
+        else if ((output = ensure(&buffer, (object && writer->format) ? sizeof("{\n") : sizeof("{"))) != NULL)
+        {
+            *output++ = object ? '{' : '[';
+            if (object && writer->format)
+            {
+                *output++ = '\n';
+            }
+            *output = '\0';
+            success = true;
+        }
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+
+    if (object)
+    {
+        writer->containers[writer->depth / 8] |= (unsigned char)(1 << (writer->depth % 8));
+    }
+    else
+    {
+        writer->containers[writer->depth / 8] &= (unsigned char)~(1 << (writer->depth % 8));
+    }
+    writer->depth++;
+    writer->has_values = false;
+
+    return true;
+}
+
+static cJSON_bool writer_close(cJSON_Writer * const writer, const cJSON_bool object)
+{
+    printbuffer buffer;
+    unsigned char *output = NULL;
+    size_t needed = sizeof("}");
+    cJSON_bool success = false;
+
+    if (!writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if ((writer->depth > 0) && ((cJSON_bool)writer_is_object(writer) == object) && !writer->after_key && writer->cbor)
+    {
+        const unsigned char stop = CBOR_BREAK;
+        success = cbor_put(&buffer, &stop, 1);
+    }
+    else if ((writer->depth > 0) && ((cJSON_bool)writer_is_object(writer) == object) && !writer->after_key)
+    {
+        if (object && writer->format)
+        {
+            needed += (writer->has_values ? 1 : 0) + (writer->depth - 1);
+        }
+        output = ensure(&buffer, needed);
+        if (output != NULL)
+        {
+            if (object && writer->format)
+            {
+                size_t i;
+                if (writer->has_values)
+                {
+                    *output++ = '\n';
+                }
+                for (i = 0; i < (writer->depth - 1); i++)
+                {
+                    *output++ = '\t';
+                }
+            }
+            *output++ = object ? '}' : ']';
+            *output = '\0';
+            success = true;
+        }
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+
+    writer->depth--;
+    /* the closed array/object is a value of its parent */
+    writer->has_values = true;
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteObjectStart(cJSON_Writer *writer)
+{
+    return writer_open(writer, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteObjectEnd(cJSON_Writer *writer)
+{
+    return writer_close(writer, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteArrayStart(cJSON_Writer *writer)
+{
+    return writer_open(writer, false);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteArrayEnd(cJSON_Writer *writer)
+{
+    return writer_close(writer, false);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteKey(cJSON_Writer *writer, const char *key)
+{
+    printbuffer buffer;
+    unsigned char *output = NULL;
+    cJSON_bool success = false;
+
+    if ((key == NULL) || !writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if ((writer->depth > 0) && writer_is_object(writer) && !writer->after_key && writer->cbor)
+    {
+        success = cbor_put_text(&buffer, key);
+    }
+    else if ((writer->depth > 0) && writer_is_object(writer) && !writer->after_key)
+    {
+        size_t needed = (size_t)(writer->has_values ? 1 : 0);
+        if (writer->format)
+        {
+            needed += (size_t)(writer->has_values ? 1 : 0) + writer->depth;
+        }
+        output = ensure(&buffer, needed + sizeof(""));
+        if (output != NULL)
+        {
+            size_t i;
+            if (writer->has_values)
+            {
+                *output++ = ',';
+                if (writer->format)
+                {
+                    *output++ = '\n';
+                }
+            }
+            if (writer->format)
+            {
+                for (i = 0; i < writer->depth; i++)
+                {
+                    *output++ = '\t';
+                }
+            }
+            *output = '\0';
+            update_offset(&buffer);
+
+            success = print_string_ptr((const unsigned char*)key, &buffer);
+            if (success)
+            {
+                update_offset(&buffer);
+                output = ensure(&buffer, writer->format ? sizeof(":\t") : sizeof(":"));
+                success = (output != NULL);
+            }
+            if (success)
+            {
+                *output++ = ':';
+                if (writer->format)
+                {
+                    *output++ = '\t';
+                }
+                *output = '\0';
+            }
+        }
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+    writer->after_key = true;
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteString(cJSON_Writer *writer, const char *string)
+{
+    printbuffer buffer;
+    cJSON_bool success = false;
+
+    if (!writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if (writer_separate_value(writer, &buffer))
+    {
+        update_offset(&buffer);
+        success = writer->cbor ? cbor_put_text(&buffer, string) : print_string_ptr((const unsigned char*)string, &buffer);
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+    writer->has_values = true;
+
+    return true;
+}
+
+/* On a CBOR writer scalars are encoded like the equivalent item */
+static cJSON_bool writer_cbor_scalar(cJSON_Writer * const writer, const int type, const double number, const cJSON_int64 * const integer)
+{
+    cJSON item;
+
+    memset(&item, '\0', sizeof(item));
+    item.type = type;
+    if (integer != NULL)
+    {
+        set_int64(&item, *integer);
+    }
+    else if (type == cJSON_Number)
+    {
+        cJSON_SetNumberHelper(&item, number);
+    }
+
+    return cJSON_WriteItem(writer, &item);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNumber(cJSON_Writer *writer, double number)
+{
+    unsigned char number_buffer[26];
+    int length = 0;
+
+    if ((writer != NULL) && writer->cbor)
+    {
+        return writer_cbor_scalar(writer, cJSON_Number, number, NULL);
+    }
+
+    length = format_double(number, number_buffer);
+    return writer_literal(writer, (const char*)number_buffer, (size_t)length);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteInt64(cJSON_Writer *writer, cJSON_int64 number)
+{
+    unsigned char number_buffer[26];
+    int length = 0;
+
+    if ((writer != NULL) && writer->cbor)
+    {
+        return writer_cbor_scalar(writer, cJSON_Number, 0, &number);
+    }
+
+    length = print_int64(number_buffer, number);
+    return writer_literal(writer, (const char*)number_buffer, (size_t)length);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteBool(cJSON_Writer *writer, cJSON_bool boolean)
+{
+    if ((writer != NULL) && writer->cbor)
+    {
+        return writer_cbor_scalar(writer, boolean ? cJSON_True : cJSON_False, 0, NULL);
+    }
+
+    if (boolean)
+    {
+        return writer_literal(writer, "true", sizeof("true") - 1);
+    }
+
+    return writer_literal(writer, "false", sizeof("false") - 1);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNull(cJSON_Writer *writer)
+{
+    if ((writer != NULL) && writer->cbor)
+    {
+        return writer_cbor_scalar(writer, cJSON_NULL, 0, NULL);
+    }
+
+    return writer_literal(writer, "null", sizeof("null") - 1);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteRaw(cJSON_Writer *writer, const char *json)
+{
+    if (json == NULL)
+    {
+        if (writer != NULL)
+        {
+            writer->failed = true;
+        }
+        return false;
+    }
+
+    return writer_literal(writer, json, strlen(json));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteItem(cJSON_Writer *writer, const cJSON *item)
+{
+    printbuffer buffer;
+    cJSON_bool success = false;
+
+    if (!writer_begin(writer, &buffer))
+    {
+        return false;
+    }
+
+    if (writer_separate_value(writer, &buffer))
+    {
+        update_offset(&buffer);
+        success = writer->cbor ? cbor_encode_value(item, &buffer) : print_value(item, &buffer);
+    }
+    if (!writer_end(writer, &buffer, success))
+    {
+        return false;
+    }
+    writer->has_values = true;
+
+    return true;
+}
+
+CJSON_PUBLIC(const char *) cJSON_WriterOutput(const cJSON_Writer *writer, size_t *length)
+{
+    if ((writer == NULL) || writer->failed || (writer->depth != 0) || !writer->has_values)
+    {
+        return NULL;
+    }
+
+    /* only known once the document is complete, the buffer itself isn't const */
+    if (writer->framed && !cbor_put_frame_length((unsigned char*)writer->buffer, writer->offset - CJSON_CBOR_FRAME_HEADER))
+    {
+        return NULL;
+    }
+
+    if (length != NULL)
+    {
+        *length = writer->offset;
+    }
+
+    return writer->buffer;
+}
+
+/* Offset of the quote that closes the string opened at offset, or length if it isn't closed.
+ * A quote after an odd number of backslashes is escaped. */
+static size_t skip_string_text(const unsigned char * const content, const size_t length, size_t offset)
+{
+    size_t backslashes = 0;
+
+    do
+    {
+        const unsigned char *quote = (const unsigned char*)memchr(content + offset + 1, '\"', length - offset - 1);
+        if (quote == NULL)
+        {
+            return length;
+        }
+        offset = (size_t)(quote - content);
+        for (backslashes = 0; content[offset - 1 - backslashes] == '\\'; backslashes++)
+        {
+        }
+    }
+    while ((backslashes % 2) == 1);
+
+    return offset;
+}
+
+/* Skip an array/object by counting brackets outside of strings and remember where its text is. The text is
+ * checked when the array/object is parsed, only the nesting depth is checked here. */
+static cJSON_bool parse_lazy(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char * const content = input_buffer->content;
+    const size_t start = input_buffer->offset;
+    size_t offset = start;
+    size_t depth = 0;
+
+    while (offset < input_buffer->length)
+    {
+        switch (content[offset])
+        {
+            case '\"':
+                offset = skip_string_text(content, input_buffer->length, offset);
+                break;
+
+            case '[':
+            case '{':
+                depth++;
+                if ((input_buffer->depth + depth) > input_buffer->max_depth)
+                {
+                    input_buffer->offset = offset;
+                    return false;
+                }
+                break;
+
+            case ']':
+            case '}':
+                depth--;
+                if (depth == 0)
+                {
+                    offset++;
+                    item->type = (content[start] == '[') ? cJSON_Array : cJSON_Object;
+                    item->valuestring = (char*)cast_away_const(content + start);
+                    item->valueint64 = (cJSON_int64)(offset - start);
+                    item->internalflags |= cJSON_FlagLazy;
+                    input_buffer->offset = offset;
+                    return true;
+                }
+                break;
+
+            default:
+                break;
+        }
+        offset++;
+    }
+
+    /* not closed before the end */
+    input_buffer->offset = input_buffer->length;
+    return false;
+}
+
+/* Parallel parse: a structural pass finds the biggest array of the document and splits its elements into chunks
+ * of about the same size, which are parsed on their own threads and linked together afterwards. */
+typedef struct parallel_plan
+{
+    /* offsets of the array's '[' and ']' */
+    size_t start;
+    size_t end;
+    /* offsets of the commas that end the chunks but the last one */
+    size_t boundaries[CJSON_PARALLEL_MAX_THREADS - 1];
+    size_t chunks;
+} parallel_plan;
+
+typedef struct
+{
+    parse_buffer buffer;
+    /* offset of the ',' or ']' after the chunk's last element */
+    size_t end;
+    cJSON *head;
+    cJSON *tail;
+    int count;
+    cJSON_bool success;
+} parallel_chunk;
+
+/* Find the biggest array and where to split it. Only strings and brackets are looked at, the parse checks the rest.
+ * Returns false if there is no array worth parsing in parallel. */
+static cJSON_bool plan_parallel_parse(const parse_buffer * const buffer, parallel_plan * const plan, size_t chunks)
+{
+    const unsigned char * const content = buffer->content;
+    size_t *open = NULL;
+    size_t depth = 0;
+    size_t offset = 0;
+    size_t target = 0;
+
+    open = (size_t*)buffer->hooks.allocate((buffer->max_depth + 1) * sizeof(size_t));
+    if (open == NULL)
+    {
+        return false;
+    }
+
+    plan->start = 0;
+    plan->end = 0;
+    for (offset = 0; offset < buffer->length; offset++)
+    {
+        switch (content[offset])
+        {
+            case '\"':
+                offset = skip_string_text(content, buffer->length, offset);
+                break;
+
+            case '[':
+            case '{':
+                if (depth > buffer->max_depth)
+                {
+                    /* the parse rejects this anyway */
+                    buffer->hooks.deallocate(open);
+                    return false;
+                }
+                open[depth++] = offset;
+                break;
+
+            case ']':
+            case '}':
+                if (depth == 0)
+                {
+                    buffer->hooks.deallocate(open);
+                    return false;
+                }
+                depth--;
+                if ((content[open[depth]] == '[') && ((offset - open[depth]) > (plan->end - plan->start)))
+                {
+                    plan->start = open[depth];
+                    plan->end = offset;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+    buffer->hooks.deallocate(open);
+
+    if ((plan->end - plan->start) < CJSON_PARALLEL_THRESHOLD)
+    {
+        return false;
+    }
+
+    /* split at the first comma between elements after every chunk's share of the bytes */
+    plan->chunks = 1;
+    target = plan->start + (plan->end - plan->start) / chunks;
+    depth = 0;
+    for (offset = plan->start + 1; (offset < plan->end) && (plan->chunks < chunks); offset++)
+    {
+        switch (content[offset])
+        {
+            case '\"':
+                offset = skip_string_text(content, buffer->length, offset);
+                break;
+
+            case '[':
+            case '{':
+                depth++;
+                break;
+
+            case ']':
+            case '}':
+                depth--;
+                break;
+
+            case ',':
+                if ((depth == 0) && (offset >= target))
+                {
+                    plan->boundaries[plan->chunks - 1] = offset;
+                    plan->chunks++;
+                    target = plan->start + (plan->end - plan->start) * plan->chunks / chunks;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return plan->chunks > 1;
+}
+
+/* Parse the comma separated elements of a chunk into a list of their own */
+static void parse_chunk(parallel_chunk * const chunk)
+{
+    parse_buffer * const buffer = &chunk->buffer;
+
+    while (true)
+    {
+        cJSON *new_item = parse_new_item(buffer);
+        if (new_item == NULL)
+        {
+            return;
+        }
+        if (chunk->head == NULL)
+        {
+            chunk->head = new_item;
+        }
+        else
+        {
+            chunk->tail->next = new_item;
+            new_item->prev = chunk->tail;
+        }
+        chunk->tail = new_item;
+        chunk->count++;
+
+        buffer_skip_whitespace(buffer);
+        if (!parse_value(new_item, buffer))
+        {
+            return;
+        }
+        buffer_skip_whitespace(buffer);
+        if (buffer->offset == chunk->end)
+        {
+            chunk->success = true;
+            return;
+        }
+        if (cannot_access_at_index(buffer, 0) || (buffer_at_offset(buffer)[0] != ','))
+        {
+            return;
+        }
+        buffer->offset++;
+    }
+}
+
+#ifdef ENABLE_THREADS
+static void *parse_chunk_thread(void *chunk)
+{
+    parse_chunk((parallel_chunk*)chunk);
+    return NULL;
+}
+#endif
+
+static cJSON_bool parse_array_parallel(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const parallel_plan * const plan = input_buffer->parallel;
+    parallel_chunk chunks[CJSON_PARALLEL_MAX_THREADS];
+#ifdef ENABLE_THREADS
+    pthread_t threads[CJSON_PARALLEL_MAX_THREADS];
+    cJSON_bool started[CJSON_PARALLEL_MAX_THREADS];
+#endif
+    cJSON_bool success = true;
+    size_t i = 0;
+
+    if (input_buffer->depth >= input_buffer->max_depth)
+    {
+        return false; /* to deeply nested */
+    }
+
+    for (i = 0; i < plan->chunks; i++)
+    {
+        memset(&chunks[i], '\0', sizeof(parallel_chunk));
+        chunks[i].buffer = *input_buffer;
+        chunks[i].buffer.offset = ((i == 0) ? plan->start : plan->boundaries[i - 1]) + 1;
+        chunks[i].buffer.depth = input_buffer->depth + 1;
+        /* the node pool isn't thread safe */
+        chunks[i].buffer.pooled = false;
+        chunks[i].buffer.parallel = NULL;
+        chunks[i].end = (i == (plan->chunks - 1)) ? plan->end : plan->boundaries[i];
+    }
+
+#ifdef ENABLE_THREADS
+    for (i = 1; i < plan->chunks; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, parse_chunk_thread, &chunks[i]) == 0);
+    }
+#endif
+    parse_chunk(&chunks[0]);
+    for (i = 1; i < plan->chunks; i++)
+    {
+#ifdef ENABLE_THREADS
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+            continue;
+        }
+#endif
+        parse_chunk(&chunks[i]);
+    }
+
+    for (i = 0; i < plan->chunks; i++)
+    {
+        if (!chunks[i].success && success)
+        {
+            success = false;
+            input_buffer->offset = chunks[i].buffer.offset;
+        }
+    }
+    if (!success)
+    {
+        for (i = 0; i < plan->chunks; i++)
+        {
+            delete_item(chunks[i].head, &input_buffer->hooks);
+        }
+        return false;
+    }
+
+    /* link the chunks into one list */
+    item->type = cJSON_Array;
+    item->child = chunks[0].head;
+    item->childcount = chunks[0].count;
+    for (i = 1; i < plan->chunks; i++)
+    {
+        chunks[i - 1].tail->next = chunks[i].head;
+        chunks[i].head->prev = chunks[i - 1].tail;
+        item->childcount += chunks[i].count;
+    }
+    item->child->prev = chunks[plan->chunks - 1].tail;
+    input_buffer->offset = plan->end + 1;
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseParallel(const char *value, size_t buffer_length, unsigned int threads)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, false, NULL, NULL, { 0, 0, 0 } };
+    parallel_plan plan;
+    cJSON *item = NULL;
+
+#ifndef ENABLE_THREADS
+    /* nothing to gain without threads */
+    threads = 1;
+#endif
+    if ((value == NULL) || (buffer_length < CJSON_PARALLEL_THRESHOLD) || (threads < 2))
+    {
+        return cJSON_ParseWithLength(value, buffer_length);
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.hooks = global_hooks;
+    if (!plan_parallel_parse(&buffer, &plan, (threads < CJSON_PARALLEL_MAX_THREADS) ? threads : CJSON_PARALLEL_MAX_THREADS))
+    {
+        return cJSON_ParseWithLength(value, buffer_length);
+    }
+    buffer.parallel = &plan;
+
+    item = cJSON_New_Item(&global_hooks);
+    if ((item == NULL) || !parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        cJSON_Delete(item);
+        /* parse again for the error position */
+        return cJSON_ParseWithLength(value, buffer_length);
+    }
+
+    return item;
+}
+
+/* Parser core - when encountering text, process appropriately. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
+{
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false; /* no input */
+    }
+
+    /* parse the different types of values */
+    /* null */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+    {
+        item->type = cJSON_NULL;
+        input_buffer->offset += 4;
+        return true;
+    }
+    /* false */
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    {
+        item->type = cJSON_False;
+        input_buffer->offset += 5;
+        return true;
+    }
+    /* true */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+    {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        input_buffer->offset += 4;
+        return true;
+    }
+    /* string */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+    {
+        return parse_string(item, input_buffer);
+    }
+    /* number */
+    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
+    {
+        return parse_number(item, input_buffer);
+    }
+    /* nested array/object of a lazy parse */
+    if (input_buffer->lazy && (input_buffer->depth > 0) && can_access_at_index(input_buffer, 0)
+            && ((buffer_at_offset(input_buffer)[0] == '[') || (buffer_at_offset(input_buffer)[0] == '{')))
+    {
+        return parse_lazy(item, input_buffer);
+    }
+    /* array */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    {
+        if ((input_buffer->parallel != NULL) && (input_buffer->offset == input_buffer->parallel->start))
+        {
+            return parse_array_parallel(item, input_buffer);
+        }
+        return parse_array(item, input_buffer);
+    }
+    /* object */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    {
+        return parse_object(item, input_buffer);
+    }
+
+    return false;
+}
+
+/* Parse the text of a lazy array/object into its children, whose arrays/objects are lazy in turn.
+ * The tree doesn't change if that fails. */
+static cJSON_bool lazy_expand(const cJSON * const item)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, CJSON_NESTING_LIMIT, true, NULL, true, NULL, NULL, { 0, 0, 0 } };
+    /* parsing doesn't change what the item stands for */
+    cJSON * const container = (cJSON*)cast_away_const(item);
+    cJSON_bool parsed = false;
+
+    if ((item == NULL) || !(item->internalflags & cJSON_FlagLazy))
+    {
+        return true;
+    }
+
+    buffer.content = (const unsigned char*)item->valuestring;
+    buffer.length = (size_t)item->valueint64;
+    buffer.hooks = global_hooks;
+
+    container->valuestring = NULL;
+    container->valueint64 = 0;
+    container->internalflags &= ~cJSON_FlagLazy;
+    parsed = ((container->type & 0xFF) == cJSON_Array) ? parse_array(container, &buffer) : parse_object(container, &buffer);
+    if (!parsed)
+    {
+        container->valuestring = (char*)cast_away_const(buffer.content);
+        container->valueint64 = (cJSON_int64)buffer.length;
+        container->internalflags |= cJSON_FlagLazy;
+    }
+
+    return parsed;
+}
+
+/* Render a value to text. */
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output = NULL;
+
+    if ((item == NULL) || (output_buffer == NULL))
+    {
+        return false;
+    }
+
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "null");
+            return true;
+
+        case cJSON_False:
+            output = ensure(output_buffer, 6);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "false");
+            return true;
+
+        case cJSON_True:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "true");
+            return true;
+
+        case cJSON_Number:
+            return print_number(item, output_buffer);
+
+        case cJSON_Raw:
+        {
+            size_t raw_length = 0;
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+
+            raw_length = strlen(item->valuestring) + sizeof("");
+            output = ensure(output_buffer, raw_length);
+            if (output == NULL)
+            {
+                return false;
+            }
+            memcpy(output, item->valuestring, raw_length);
+            return true;
+        }
+
+        case cJSON_String:
+            return print_string(item, output_buffer);
+
+        case cJSON_Array:
+            return print_array(item, output_buffer);
+
+        case cJSON_Object:
+            return print_object(item, output_buffer);
+
+        default:
+            return false;
+    }
+}
+
+/* Build an array from input text. */
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
+{
+    cJSON *head = NULL; /* head of the linked list */
+    cJSON *current_item = NULL;
+    int count = 0;
+
+    if (input_buffer->depth >= input_buffer->max_depth)
+    {
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if (buffer_at_offset(input_buffer)[0] != '[')
+    {
+        /* not an array */
+        goto fail;
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+    {
+        /* empty array */
+        goto success;
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        input_buffer->offset--;
+        goto fail;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        /* allocate next item */
+        cJSON *new_item = parse_new_item(input_buffer);
+        if (new_item == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+
+        /* attach next item to list */
+        if (head == NULL)
+        {
+            /* start the linked list */
+            current_item = head = new_item;
+        }
+        else
+        {
+            /* add to the end and advance */
+            current_item->next = new_item;
+            new_item->prev = current_item;
+            current_item = new_item;
+        }
+        count++;
+
+        /* parse next value */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse value */
+        }
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
+    {
+        goto fail; /* expected end of array */
+    }
+
+success:
+    input_buffer->depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Array;
+    item->child = head;
+    item->childcount = count;
+
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if (head != NULL)
+    {
+        delete_item(head, &input_buffer->hooks);
+    }
+
+    return false;
+}
+
+/* Render an array to text */
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+    cJSON *current_element = NULL;
+
+    if ((output_buffer == NULL) || !lazy_expand(item))
+    {
+        return false;
+    }
+    current_element = item->child;
+
+    /* Compose the output array. */
+    /* opening square bracket */
+    output_pointer = ensure(output_buffer, 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    *output_pointer = '[';
+    output_buffer->offset++;
+    output_buffer->depth++;
+
+    while (current_element != NULL)
+    {
+        if (!print_value(current_element, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+        if (current_element->next)
+        {
+            length = (size_t) (output_buffer->format ? 2 : 1);
+            output_pointer = ensure(output_buffer, length + 1);
+            if (output_pointer == NULL)
+            {
+                return false;
+            }
+            *output_pointer++ = ',';
+            if(output_buffer->format)
+            {
+                *output_pointer++ = ' ';
+            }
+            *output_pointer = '\0';
+            output_buffer->offset += length;
+        }
+        current_element = current_element->next;
+    }
+
+    output_pointer = ensure(output_buffer, 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    *output_pointer++ = ']';
+    *output_pointer = '\0';
+    output_buffer->depth--;
+
+    return true;
+}
+
+/* Build an object from the text. */
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer)
+{
+    cJSON *head = NULL; /* linked list head */
+    cJSON *current_item = NULL;
+    int count = 0;
+
+    if (input_buffer->depth >= input_buffer->max_depth)
+    {
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{'))
+    {
+        goto fail; /* not an object */
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
+    {
+        goto success; /* empty object */
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        input_buffer->offset--;
+        goto fail;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        /* allocate next item */
+        cJSON *new_item = parse_new_item(input_buffer);
+        if (new_item == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+
+        /* attach next item to list */
+        if (head == NULL)
+        {
+            /* start the linked list */
+            current_item = head = new_item;
+        }
+        else
+        {
+            /* add to the end and advance */
+            current_item->next = new_item;
+            new_item->prev = current_item;
+            current_item = new_item;
+        }
+        count++;
+
+        if (cannot_access_at_index(input_buffer, 1))
+        {
+            goto fail; /* nothing comes after the comma */
+        }
+
+        /* parse the name of the child */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_string(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse name */
+        }
+        buffer_skip_whitespace(input_buffer);
+
+        /* swap valuestring and string, because we parsed the name */
+        current_item->string = current_item->valuestring;
+        current_item->valuestring = NULL;
+
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+        {
+            goto fail; /* invalid object */
+        }
+
+        /* parse the value */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse value */
+        }
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+    {
+        goto fail; /* expected end of object */
+    }
+
+success:
+    input_buffer->depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Object;
+    item->child = head;
+    item->childcount = count;
+
+    input_buffer->offset++;
+    return true;
+
+fail:
+    if (head != NULL)
+    {
+        delete_item(head, &input_buffer->hooks);
+    }
+
+    return false;
+}
+
+/* Render an object to text. */
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+    cJSON *current_item = NULL;
+
+    if ((output_buffer == NULL) || !lazy_expand(item))
+    {
+        return false;
+    }
+    current_item = item->child;
+
+    /* Compose the output: */
+    length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
+    output_pointer = ensure(output_buffer, length + 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    *output_pointer++ = '{';
+    output_buffer->depth++;
+    if (output_buffer->format)
+    {
+        *output_pointer++ = '\n';
+    }
+    output_buffer->offset += length;
+
+    while (current_item)
+    {
+        if (output_buffer->format)
+        {
+            size_t i;
+            output_pointer = ensure(output_buffer, output_buffer->depth);
+            if (output_pointer == NULL)
+            {
+                return false;
+            }
+            for (i = 0; i < output_buffer->depth; i++)
+            {
+                *output_pointer++ = '\t';
+            }
+            output_buffer->offset += output_buffer->depth;
+        }
+
+        /* print key */
+        if (!print_string_ptr((unsigned char*)current_item->string, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+
+        length = (size_t) (output_buffer->format ? 2 : 1);
+        output_pointer = ensure(output_buffer, length);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+        *output_pointer++ = ':';
+        if (output_buffer->format)
+        {
+            *output_pointer++ = '\t';
+        }
+        output_buffer->offset += length;
+
+        /* print value */
+        if (!print_value(current_item, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+
+        /* print comma if not last */
+        length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0));
+        output_pointer = ensure(output_buffer, length + 1);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+        if (current_item->next)
+        {
+            *output_pointer++ = ',';
+        }
+
+        if (output_buffer->format)
+        {
+            *output_pointer++ = '\n';
+        }
+        *output_pointer = '\0';
+        output_buffer->offset += length;
+
+        current_item = current_item->next;
+    }
+
+    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    if (output_buffer->format)
+    {
+        size_t i;
+        for (i = 0; i < (output_buffer->depth - 1); i++)
+        {
+            *output_pointer++ = '\t';
+        }
+    }
+    *output_pointer++ = '}';
+    *output_pointer = '\0';
+    output_buffer->depth--;
+
+    return true;
+}
+
+/* Get Array size/item / object item. */
+CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
+{
+    if ((array == NULL) || !lazy_expand(array))
+    {
+        return 0;
+    }
+
+    return child_count(array);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetChild(const cJSON *item)
+{
+    if ((item == NULL) || !lazy_expand(item))
+    {
+        return NULL;
+    }
+
+    return item->child;
+}
+
+/* The child vector of an array or object, NULL if it has none */
+static cJSON **get_child_vector(const cJSON * const container)
+{
+    if ((container->index == NULL) || (container->index->items == NULL))
+    {
+        return NULL;
+    }
+
+    return container->index->items;
+}
+
+static cJSON* get_array_item(const cJSON *array, size_t index)
+{
+    cJSON *current_child = NULL;
+    cJSON **items = NULL;
+
+    if ((array == NULL) || !lazy_expand(array))
+    {
+        return NULL;
+    }
+    if (!(array->type & cJSON_IsReference) && (index >= (size_t)array->childcount))
+    {
+        return NULL;
+    }
+
+    items = get_child_vector(array);
+    if (items != NULL)
+    {
+        return items[index];
+    }
+
+    current_child = array->child;
+    while ((current_child != NULL) && (index > 0))
+    {
+        index--;
+        current_child = current_child->next;
+    }
+
+    return current_child;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    if (index < 0)
+    {
+        return NULL;
+    }
+
+    return get_array_item(array, (size_t)index);
+}
+
+CJSON_PUBLIC(unsigned int) cJSON_HashKey(const char *key, size_t length)
+{
+    /* 32 bit FNV-1a */
+    unsigned int hash = 2166136261u;
+    size_t i = 0;
+
+    if (key == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash = (hash * 16777619u) & 0xFFFFFFFFu;
+    }
+
+    return hash;
+}
+
+/* The index of an object if it has a key hash table */
+static cJSON_Index *get_object_index(const cJSON * const object)
+{
+    if ((object->index == NULL) || (object->index->slots == NULL))
+    {
+        return NULL;
+    }
+
+    return object->index;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemByHash(const cJSON * const object, const char *key, size_t length, unsigned int hash)
+{
+    cJSON_Index *index = NULL;
+    cJSON *current_element = NULL;
+
+    if ((object == NULL) || (key == NULL) || !lazy_expand(object))
+    {
+        return NULL;
+    }
+
+    index = get_object_index(object);
+    if (index != NULL)
+    {
+        size_t slot = hash & (index->capacity - 1);
+        while (index->slots[slot] != NULL)
+        {
+            current_element = index->slots[slot];
+            if ((index->hashes[slot] == hash) && (strncmp(current_element->string, key, length) == 0) && (current_element->string[length] == '\0'))
+            {
+                return current_element;
+            }
+            slot = (slot + 1) & (index->capacity - 1);
+        }
+
+        return NULL;
+    }
+
+    for (current_element = object->child; current_element != NULL; current_element = current_element->next)
+    {
+        if ((current_element->string != NULL) && (strncmp(current_element->string, key, length) == 0) && (current_element->string[length] == '\0'))
+        {
+            return current_element;
+        }
+    }
+
+    return NULL;
+}
+
+static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
+{
+    cJSON *current_element = NULL;
+
+    if ((object == NULL) || (name == NULL) || !lazy_expand(object))
+    {
+        return NULL;
+    }
+
+    if (case_sensitive && (get_object_index(object) != NULL))
+    {
+        size_t length = strlen(name);
+        return cJSON_GetObjectItemByHash(object, name, length, cJSON_HashKey(name, length));
+    }
+
+    current_element = object->child;
+    if (case_sensitive)
+    {
+        while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
+        {
+            current_element = current_element->next;
+        }
+    }
+    else
+    {
+        while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
+        {
+            current_element = current_element->next;
+        }
+    }
+
+    if ((current_element == NULL) || (current_element->string == NULL)) {
+        return NULL;
+    }
+
+    return current_element;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string)
+{
+    return get_object_item(object, string, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string)
+{
+    return get_object_item(object, string, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string)
+{
+    return cJSON_GetObjectItem(object, string) ? 1 : 0;
+}
+
+/* Utility for array list handling. */
+static void suffix_object(cJSON *prev, cJSON *item)
+{
+    prev->next = item;
+    item->prev = prev;
+}
+
+/* Utility for handling references. */
+static cJSON *create_reference(const cJSON *item, const internal_hooks * const hooks)
+{
+    cJSON *reference = NULL;
+    int internalflags = 0;
+    /* the reference has to share parsed children, not text */
+    if ((item == NULL) || !lazy_expand(item))
+    {
+        return NULL;
+    }
+
+    reference = cJSON_New_Item(hooks);
+    if (reference == NULL)
+    {
+        return NULL;
+    }
+
+    /* the reference keeps track of its own allocation */
+    internalflags = reference->internalflags;
+    memcpy(reference, item, sizeof(cJSON));
+    reference->internalflags = internalflags | (item->internalflags & cJSON_FlagInt64);
+    reference->index = NULL;
+    reference->childcount = 0;
+    reference->string = NULL;
+    reference->type |= cJSON_IsReference;
+    reference->next = reference->prev = NULL;
+    return reference;
+}
+
+/* An arena tree is released without walking it, so it can only take items from an arena */
+static cJSON_bool fits_arena(const cJSON * const parent, const cJSON * const item)
+{
+    return !(parent->internalflags & cJSON_FlagArena) || (item->internalflags & cJSON_FlagArena);
+}
+
+static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
+{
+    cJSON *child = NULL;
+
+    if ((item == NULL) || (array == NULL) || (array == item) || !fits_arena(array, item) || !lazy_expand(array))
+    {
+        return false;
+    }
+
+    child = array->child;
+    /*
+     * To find the last item in array quickly, we use prev in array
+     */
+    if (child == NULL)
+    {
+        /* list is empty, start new one */
+        array->child = item;
+        item->prev = item;
+        item->next = NULL;
+    }
+    else
+    {
+        /* append to the end */
+        if (!child->prev)
+        {
+            return true;
+        }
+        suffix_object(child->prev, item);
+        array->child->prev = item;
+    }
+
+    index_insert(array, (size_t)array->childcount, item);
+    array->childcount++;
+    update_keys(array, NULL, item, true);
+
+    return true;
+}
+
+/* Add item to array/object. */
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    return add_item_to_array(array, item);
+}
+
+
+
+static cJSON_bool add_item_to_object(cJSON * const object, const char * const string, cJSON * const item, const internal_hooks * const hooks, const cJSON_bool constant_key)
+{
+    char *new_key = NULL;
+    int new_type = cJSON_Invalid;
+
+    if ((object == NULL) || (string == NULL) || (item == NULL) || (object == item))
+    {
+        return false;
+    }
+    if ((item->internalflags & cJSON_FlagArena) || !fits_arena(object, item))
+    {
+        /* the new key wouldn't be released with the arena */
+        return false;
+    }
+
+    if (constant_key)
+    {
+        new_key = (char*)cast_away_const(string);
+        new_type = item->type | cJSON_StringIsConst;
+    }
+    else
+    {
+        new_key = (char*)cJSON_strdup((const unsigned char*)string, hooks);
+        if (new_key == NULL)
+        {
+            return false;
+        }
+
+        new_type = item->type & ~cJSON_StringIsConst;
+    }
+
+    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+    {
+        hooks->deallocate(item->string);
+    }
+
+    item->string = new_key;
+    item->type = new_type;
+
+    return add_item_to_array(object, item);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    return add_item_to_object(object, string, item, &global_hooks, false);
+}
+
+/* Add an item to an object with constant string as key */
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
+{
+    return add_item_to_object(object, string, item, &global_hooks, true);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
+{
+    if (array == NULL)
+    {
+        return false;
+    }
+
+    return add_item_to_array(array, create_reference(item, &global_hooks));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
+{
+    if ((object == NULL) || (string == NULL))
+    {
+        return false;
+    }
+
+    return add_item_to_object(object, string, create_reference(item, &global_hooks), &global_hooks, false);
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * const name)
+{
+    cJSON *null = cJSON_CreateNull();
+    if (add_item_to_object(object, name, null, &global_hooks, false))
+    {
+        return null;
+    }
+
+    cJSON_Delete(null);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddTrueToObject(cJSON * const object, const char * const name)
+{
+    cJSON *true_item = cJSON_CreateTrue();
+    if (add_item_to_object(object, name, true_item, &global_hooks, false))
+    {
+        return true_item;
+    }
+
+    cJSON_Delete(true_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddFalseToObject(cJSON * const object, const char * const name)
+{
+    cJSON *false_item = cJSON_CreateFalse();
+    if (add_item_to_object(object, name, false_item, &global_hooks, false))
+    {
+        return false_item;
+    }
+
+    cJSON_Delete(false_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObject(cJSON * const object, const char * const name, const cJSON_bool boolean)
+{
+    cJSON *bool_item = cJSON_CreateBool(boolean);
+    if (add_item_to_object(object, name, bool_item, &global_hooks, false))
+    {
+        return bool_item;
+    }
+
+    cJSON_Delete(bool_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObject(cJSON * const object, const char * const name, const double number)
+{
+    cJSON *number_item = cJSON_CreateNumber(number);
+    if (add_item_to_object(object, name, number_item, &global_hooks, false))
+    {
+        return number_item;
+    }
+
+    cJSON_Delete(number_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddInt64ToObject(cJSON * const object, const char * const name, const cJSON_int64 number)
+{
+    cJSON *number_item = cJSON_CreateInt64(number);
+    if (add_item_to_object(object, name, number_item, &global_hooks, false))
+    {
+        return number_item;
+    }
+
+    cJSON_Delete(number_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddStringToObject(cJSON * const object, const char * const name, const char * const string)
+{
+    cJSON *string_item = cJSON_CreateString(string);
+    if (add_item_to_object(object, name, string_item, &global_hooks, false))
+    {
+        return string_item;
+    }
+
+    cJSON_Delete(string_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddRawToObject(cJSON * const object, const char * const name, const char * const raw)
+{
+    cJSON *raw_item = cJSON_CreateRaw(raw);
+    if (add_item_to_object(object, name, raw_item, &global_hooks, false))
+    {
+        return raw_item;
+    }
+
+    cJSON_Delete(raw_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char * const name)
+{
+    cJSON *object_item = cJSON_CreateObject();
+    if (add_item_to_object(object, name, object_item, &global_hooks, false))
+    {
+        return object_item;
+    }
+
+    cJSON_Delete(object_item);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * const name)
+{
+    cJSON *array = cJSON_CreateArray();
+    if (add_item_to_object(object, name, array, &global_hooks, false))
+    {
+        return array;
+    }
+
+    cJSON_Delete(array);
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const item)
+{
+    if ((parent == NULL) || (item == NULL) || (item != parent->child && item->prev == NULL))
+    {
+        return NULL;
+    }
+
+    index_remove(parent, item);
+    parent->childcount--;
+
+    if (item != parent->child)
+    {
+        /* not the first element */
+        item->prev->next = item->next;
+    }
+    if (item->next != NULL)
+    {
+        /* not the last element */
+        item->next->prev = item->prev;
+    }
+
+    if (item == parent->child)
+    {
+        /* first element */
+        parent->child = item->next;
+    }
+    else if (item->next == NULL)
+    {
+        /* last element */
+        parent->child->prev = item->prev;
+    }
+
+    /* make sure the detached item doesn't point anywhere anymore */
+    item->prev = NULL;
+    item->next = NULL;
+    update_keys(parent, item, NULL, false);
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromArray(cJSON *array, int which)
+{
+    if (which < 0)
+    {
+        return NULL;
+    }
+
+    return cJSON_DetachItemViaPointer(array, get_array_item(array, (size_t)which));
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteItemFromArray(cJSON *array, int which)
+{
+    cJSON_Delete(cJSON_DetachItemFromArray(array, which));
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromObject(cJSON *object, const char *string)
+{
+    cJSON *to_detach = cJSON_GetObjectItem(object, string);
+
+    return cJSON_DetachItemViaPointer(object, to_detach);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromObjectCaseSensitive(cJSON *object, const char *string)
+{
+    cJSON *to_detach = cJSON_GetObjectItemCaseSensitive(object, string);
+
+    return cJSON_DetachItemViaPointer(object, to_detach);
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteItemFromObject(cJSON *object, const char *string)
+{
+    cJSON_Delete(cJSON_DetachItemFromObject(object, string));
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteItemFromObjectCaseSensitive(cJSON *object, const char *string)
+{
+    cJSON_Delete(cJSON_DetachItemFromObjectCaseSensitive(object, string));
+}
+
+/* Replace array/object items with new ones. */
+CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
+{
+    cJSON *after_inserted = NULL;
+
+    if (which < 0 || newitem == NULL || array == NULL || !fits_arena(array, newitem))
+    {
+        return false;
+    }
+
+    after_inserted = get_array_item(array, (size_t)which);
+    if (after_inserted == NULL)
+    {
+        return add_item_to_array(array, newitem);
+    }
+
+    if (after_inserted != array->child && after_inserted->prev == NULL) {
+        /* return false if after_inserted is a corrupted array item */
+        return false;
+    }
+
+    index_insert(array, (size_t)which, newitem);
+    array->childcount++;
+
+    newitem->next = after_inserted;
+    newitem->prev = after_inserted->prev;
+    after_inserted->prev = newitem;
+    if (after_inserted == array->child)
+    {
+        array->child = newitem;
+    }
+    else
+    {
+        newitem->prev->next = newitem;
     }
-    *output_pointer++ = ']';
-    *output_pointer = '\0';
-    output_buffer->depth--;
-
+    update_keys(array, NULL, newitem, false);
     return true;
 }
 
-/* Build an object from the text. */
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer)
+CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON * const item, cJSON * replacement)
 {
-    cJSON *head = NULL; /* linked list head */
-    cJSON *current_item = NULL;
-
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if ((parent == NULL) || (parent->child == NULL) || (replacement == NULL) || (item == NULL) || !fits_arena(parent, replacement))
     {
-        return false; /* to deeply nested */
+        return false;
     }
-    input_buffer->depth++;
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{'))
+    if (replacement == item)
     {
-        goto fail; /* not an object */
+        return true;
     }
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
-    {
-        goto success; /* empty object */
-    }
+    index_replace(parent, item, replacement);
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
+    replacement->next = item->next;
+    replacement->prev = item->prev;
+
+    if (replacement->next != NULL)
     {
-        input_buffer->offset--;
-        goto fail;
+        replacement->next->prev = replacement;
     }
-
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
+    if (parent->child == item)
     {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
+        if (parent->child->prev == parent->child)
         {
-            goto fail; /* allocation failure */
+            replacement->prev = replacement;
         }
-
-        /* attach next item to list */
-        if (head == NULL)
+        parent->child = replacement;
+    }
+    else
+    {   /*
+         * To find the last item in array quickly, we use prev in array.
+         * We can't modify the last item's next pointer where this item was the parent's child
+         */
+        if (replacement->prev != NULL)
         {
-            /* start the linked list */
-            current_item = head = new_item;
+            replacement->prev->next = replacement;
         }
-        else
+        if (replacement->next == NULL)
         {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
+            parent->child->prev = replacement;
         }
+    }
 
-        if (cannot_access_at_index(input_buffer, 1))
-        {
-            goto fail; /* nothing comes after the comma */
-        }
+    item->next = NULL;
+    item->prev = NULL;
+    update_keys(parent, item, replacement, false);
+    cJSON_Delete(item);
 
-        /* parse the name of the child */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer))
-        {
-            goto fail; /* failed to parse name */
-        }
-        buffer_skip_whitespace(input_buffer);
+    return true;
+}
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
+CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
+{
+    if (which < 0)
+    {
+        return false;
+    }
 
-        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
-        {
-            goto fail; /* invalid object */
-        }
+    return cJSON_ReplaceItemViaPointer(array, get_array_item(array, (size_t)which), newitem);
+}
 
-        /* parse the value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
-        {
-            goto fail; /* failed to parse value */
-        }
-        buffer_skip_whitespace(input_buffer);
+static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSON *replacement, cJSON_bool case_sensitive)
+{
+    if ((replacement == NULL) || (string == NULL) || (replacement->internalflags & cJSON_FlagArena))
+    {
+        /* the key of an arena item can't be replaced */
+        return false;
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+    /* replace the name in the replacement */
+    if (!(replacement->type & cJSON_StringIsConst) && (replacement->string != NULL))
     {
-        goto fail; /* expected end of object */
+        cJSON_free(replacement->string);
+    }
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+    if (replacement->string == NULL)
+    {
+        return false;
     }
 
-success:
-    input_buffer->depth--;
+    replacement->type &= ~cJSON_StringIsConst;
 
-    if (head != NULL) {
-        head->prev = current_item;
-    }
+    return cJSON_ReplaceItemViaPointer(object, get_object_item(object, string, case_sensitive), replacement);
+}
 
-    item->type = cJSON_Object;
-    item->child = head;
+CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
+{
+    return replace_item_in_object(object, string, newitem, false);
+}
 
-    input_buffer->offset++;
-    return true;
+CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, const char *string, cJSON *newitem)
+{
+    return replace_item_in_object(object, string, newitem, true);
+}
 
-fail:
-    if (head != NULL)
+/* Create basic types: */
+CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        cJSON_Delete(head);
+        item->type = cJSON_NULL;
     }
 
-    return false;
+    return item;
 }
 
-/* Render an object to text. */
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer)
+CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
 {
-    unsigned char *output_pointer = NULL;
-    size_t length = 0;
-    cJSON *current_item = item->child;
-
-    if (output_buffer == NULL)
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        return false;
+        item->type = cJSON_True;
     }
 
-    /* Compose the output: */
-    length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
-    output_pointer = ensure(output_buffer, length + 1);
-    if (output_pointer == NULL)
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        return false;
+        item->type = cJSON_False;
     }
 
-    *output_pointer++ = '{';
-    output_buffer->depth++;
-    if (output_buffer->format)
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        *output_pointer++ = '\n';
+        item->type = boolean ? cJSON_True : cJSON_False;
     }
-    output_buffer->offset += length;
 
-    while (current_item)
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        if (output_buffer->format)
-        {
-            size_t i;
-            output_pointer = ensure(output_buffer, output_buffer->depth);
-            if (output_pointer == NULL)
-            {
-                return false;
-            }
-            for (i = 0; i < output_buffer->depth; i++)
-            {
-                *output_pointer++ = '\t';
-            }
-            output_buffer->offset += output_buffer->depth;
-        }
+        item->type = cJSON_Number;
+        item->valuedouble = num;
 
-        /* print key */
-        if (!print_string_ptr((unsigned char*)current_item->string, output_buffer))
+        /* use saturation in case of overflow */
+        if (num >= INT_MAX)
         {
-            return false;
+            item->valueint = INT_MAX;
         }
-        update_offset(output_buffer);
-
-        length = (size_t) (output_buffer->format ? 2 : 1);
-        output_pointer = ensure(output_buffer, length);
-        if (output_pointer == NULL)
+        else if (num <= (double)INT_MIN)
         {
-            return false;
+            item->valueint = INT_MIN;
         }
-        *output_pointer++ = ':';
-        if (output_buffer->format)
+        else
         {
-            *output_pointer++ = '\t';
+            item->valueint = (int)num;
         }
-        output_buffer->offset += length;
+        item->valueint64 = double_to_int64(num);
+    }
 
-        /* print value */
-        if (!print_value(current_item, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
+    return item;
+}
 
-        /* print comma if not last */
-        length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0));
-        output_pointer = ensure(output_buffer, length + 1);
-        if (output_pointer == NULL)
-        {
-            return false;
-        }
-        if (current_item->next)
-        {
-            *output_pointer++ = ',';
-        }
+CJSON_PUBLIC(cJSON *) cJSON_CreateInt64(cJSON_int64 num)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_Number;
+        set_int64(item, num);
+    }
 
-        if (output_buffer->format)
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_String;
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+        if(!item->valuestring)
         {
-            *output_pointer++ = '\n';
+            cJSON_Delete(item);
+            return NULL;
         }
-        *output_pointer = '\0';
-        output_buffer->offset += length;
-
-        current_item = current_item->next;
     }
 
-    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
-    if (output_pointer == NULL)
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if (item != NULL)
     {
-        return false;
+        item->type = cJSON_String | cJSON_IsReference;
+        item->valuestring = (char*)cast_away_const(string);
     }
-    if (output_buffer->format)
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if (item != NULL) {
+        item->type = cJSON_Object | cJSON_IsReference;
+        item->child = (cJSON*)cast_away_const(child);
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child) {
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if (item != NULL) {
+        item->type = cJSON_Array | cJSON_IsReference;
+        item->child = (cJSON*)cast_away_const(child);
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        size_t i;
-        for (i = 0; i < (output_buffer->depth - 1); i++)
+        item->type = cJSON_Raw;
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)raw, &global_hooks);
+        if(!item->valuestring)
         {
-            *output_pointer++ = '\t';
+            cJSON_Delete(item);
+            return NULL;
         }
     }
-    *output_pointer++ = '}';
-    *output_pointer = '\0';
-    output_buffer->depth--;
 
-    return true;
+    return item;
 }
 
-/* Get Array size/item / object item. */
-CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
+CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
 {
-    cJSON *child = NULL;
-    size_t size = 0;
-
-    if (array == NULL)
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
     {
-        return 0;
+        item->type=cJSON_Array;
     }
 
-    child = array->child;
+    return item;
+}
 
-    while(child != NULL)
+CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if (item)
     {
-        size++;
-        child = child->next;
+        item->type = cJSON_Object;
     }
 
-    /* FIXME: Can overflow here. Cannot be fixed without breaking the API */
-
-    return (int)size;
+    return item;
 }
 
-static cJSON* get_array_item(const cJSON *array, size_t index)
+/* Create Arrays: */
+CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
 {
-    cJSON *current_child = NULL;
+    size_t i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = NULL;
 
-    if (array == NULL)
+    if ((count < 0) || (numbers == NULL))
     {
         return NULL;
     }
 
-    current_child = array->child;
-    while ((current_child != NULL) && (index > 0))
+    a = cJSON_CreateArray();
+
+    for(i = 0; a && (i < (size_t)count); i++)
     {
-        index--;
-        current_child = current_child->next;
+        n = cJSON_CreateNumber(numbers[i]);
+        if (!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
+        }
+        p = n;
     }
 
-    return current_child;
+    if (a && a->child) {
+        a->child->prev = n;
+        a->childcount = count;
+    }
+
+    return a;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
+CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
 {
-    if (index < 0)
+    size_t i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = NULL;
+
+    if ((count < 0) || (numbers == NULL))
     {
         return NULL;
     }
 
-    return get_array_item(array, (size_t)index);
+    a = cJSON_CreateArray();
+
+    for(i = 0; a && (i < (size_t)count); i++)
+    {
+        n = cJSON_CreateNumber((double)numbers[i]);
+        if(!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
+        }
+        p = n;
+    }
+
+    if (a && a->child) {
+        a->child->prev = n;
+        a->childcount = count;
+    }
+
+    return a;
 }
 
-static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
+CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count)
 {
-    cJSON *current_element = NULL;
+    size_t i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = NULL;
 
-    if ((object == NULL) || (name == NULL))
+    if ((count < 0) || (numbers == NULL))
     {
         return NULL;
     }
 
-    current_element = object->child;
-    if (case_sensitive)
+    a = cJSON_CreateArray();
+
+    for(i = 0; a && (i < (size_t)count); i++)
     {
-        while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
+        n = cJSON_CreateNumber(numbers[i]);
+        if(!n)
         {
-            current_element = current_element->next;
+            cJSON_Delete(a);
+            return NULL;
         }
-    }
-    else
-    {
-        while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
+        if(!i)
         {
-            current_element = current_element->next;
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
         }
+        p = n;
     }
 
-    if ((current_element == NULL) || (current_element->string == NULL)) {
-        return NULL;
+    if (a && a->child) {
+        a->child->prev = n;
+        a->childcount = count;
     }
 
-    return current_element;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string)
-{
-    return get_object_item(object, string, false);
+    return a;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string)
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int count)
 {
-    return get_object_item(object, string, true);
-}
+    size_t i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = NULL;
 
-CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string)
-{
-    return cJSON_GetObjectItem(object, string) ? 1 : 0;
-}
+    if ((count < 0) || (strings == NULL))
+    {
+        return NULL;
+    }
 
-/* Utility for array list handling. */
-static void suffix_object(cJSON *prev, cJSON *item)
-{
-    prev->next = item;
-    item->prev = prev;
-}
+    a = cJSON_CreateArray();
 
-/* Utility for handling references. */
-static cJSON *create_reference(const cJSON *item, const internal_hooks * const hooks)
-{
-    cJSON *reference = NULL;
-    if (item == NULL)
+    for (i = 0; a && (i < (size_t)count); i++)
     {
-        return NULL;
+        n = cJSON_CreateString(strings[i]);
+        if(!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p,n);
+        }
+        p = n;
     }
 
-    reference = cJSON_New_Item(hooks);
-    if (reference == NULL)
-    {
-        return NULL;
+    if (a && a->child) {
+        a->child->prev = n;
+        a->childcount = count;
     }
 
-    memcpy(reference, item, sizeof(cJSON));
-    reference->string = NULL;
-    reference->type |= cJSON_IsReference;
-    reference->next = reference->prev = NULL;
-    return reference;
+    return a;
 }
 
-static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
+/* Duplication */
+cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse);
+
+CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
+{
+    return cJSON_Duplicate_rec(item, 0, recurse );
+}
+
+cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
 {
+    cJSON *newitem = NULL;
     cJSON *child = NULL;
+    cJSON *next = NULL;
+    cJSON *newchild = NULL;
 
-    if ((item == NULL) || (array == NULL) || (array == item))
+    /* Bail on bad ptr, the copy must not point into the text of a lazy parse */
+    if (!item || !lazy_expand(item))
     {
-        return false;
+        goto fail;
     }
-
-    child = array->child;
-    /*
-     * To find the last item in array quickly, we use prev in array
-     */
-    if (child == NULL)
+    /* Create new item */
+    newitem = cJSON_New_Item(&global_hooks);
+    if (!newitem)
     {
-        /* list is empty, start new one */
-        array->child = item;
-        item->prev = item;
-        item->next = NULL;
+        goto fail;
     }
-    else
+    /* Copy over all vars */
+    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->valueint = item->valueint;
+    newitem->valuedouble = item->valuedouble;
+    newitem->valueint64 = item->valueint64;
+    newitem->internalflags |= item->internalflags & cJSON_FlagInt64;
+    if (item->valuestring)
     {
-        /* append to the end */
-        if (child->prev)
+        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
+        if (!newitem->valuestring)
         {
-            suffix_object(child->prev, item);
-            array->child->prev = item;
+            goto fail;
         }
     }
-
-    return true;
-}
-
-/* Add item to array/object. */
-CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToArray(cJSON *array, cJSON *item)
-{
-    return add_item_to_array(array, item);
-}
-
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-    #pragma GCC diagnostic push
-#endif
-#ifdef __GNUC__
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-/* helper function to cast away const */
-static void* cast_away_const(const void* string)
-{
-    return (void*)string;
-}
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-    #pragma GCC diagnostic pop
-#endif
-
-
-static cJSON_bool add_item_to_object(cJSON * const object, const char * const string, cJSON * const item, const internal_hooks * const hooks, const cJSON_bool constant_key)
-{
-    char *new_key = NULL;
-    int new_type = cJSON_Invalid;
-
-    if ((object == NULL) || (string == NULL) || (item == NULL) || (object == item))
+    if (item->string)
     {
-        return false;
+        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        if (!newitem->string)
+        {
+            goto fail;
+        }
     }
-
-    if (constant_key)
+    /* If non-recursive, then we're done! */
+    if (!recurse)
     {
-        new_key = (char*)cast_away_const(string);
-        new_type = item->type | cJSON_StringIsConst;
+        return newitem;
     }
-    else
+    /* Walk the ->next chain for the child. */
+    child = item->child;
+    while (child != NULL)
     {
-        new_key = (char*)cJSON_strdup((const unsigned char*)string, hooks);
-        if (new_key == NULL)
+        if(depth >= CJSON_CIRCULAR_LIMIT) {
+            goto fail;
+        }
+        newchild = cJSON_Duplicate_rec(child, depth + 1, true); /* Duplicate (with recurse) each item in the ->next chain */
+        if (!newchild)
         {
-            return false;
+            goto fail;
         }
-
-        new_type = item->type & ~cJSON_StringIsConst;
+        if (next != NULL)
+        {
+            /* If newitem->child already set, then crosswire ->prev and ->next and move on */
+            next->next = newchild;
+            newchild->prev = next;
+            next = newchild;
+        }
+        else
+        {
+            /* Set newitem->child and move to it */
+            newitem->child = newchild;
+            next = newchild;
+        }
+        newitem->childcount++;
+        child = child->next;
     }
-
-    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+    if (newitem && newitem->child)
     {
-        hooks->deallocate(item->string);
+        newitem->child->prev = newchild;
     }
 
-    item->string = new_key;
-    item->type = new_type;
+    return newitem;
 
-    return add_item_to_array(object, item);
-}
+fail:
+    if (newitem != NULL)
+    {
+        cJSON_Delete(newitem);
+    }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
-{
-    return add_item_to_object(object, string, item, &global_hooks, false);
+    return NULL;
 }
 
-/* Add an item to an object with constant string as key */
-CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
+/* states of cJSON_Minifier */
+#define minify_between       0 /* outside of strings and comments */
+#define minify_in_string     1
+#define minify_escape        2 /* after a backslash in a string */
+#define minify_slash         3 /* after a '/' that may start a comment */
+#define minify_line_comment  4
+#define minify_block_comment 5
+#define minify_block_star    6 /* after a '*' in a block comment */
+
+/* high bit set in each of the 8 characters in word that end a run: whitespace, control characters, '"' and '/'
+ * between values, '"' and '\\' in a string. Borrows can set bits after the first match, but not before it. */
+static cjson_uint64 minify_stops(const cjson_uint64 word, const cJSON_bool in_string)
 {
-    return add_item_to_object(object, string, item, &global_hooks, true);
-}
+    cjson_uint64 quotes = word ^ (CJSON_SWAR_ONES * '\"');
+    cjson_uint64 other = word ^ (CJSON_SWAR_ONES * (in_string ? '\\' : '/'));
+    cjson_uint64 found = ((quotes - CJSON_SWAR_ONES) & ~quotes) | ((other - CJSON_SWAR_ONES) & ~other);
 
-CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
-{
-    if (array == NULL)
+    if (!in_string)
     {
-        return false;
+        /* whitespace and control characters are all below '!' */
+        found |= (word - (CJSON_SWAR_ONES * '!')) & ~word;
     }
 
-    return add_item_to_array(array, create_reference(item, &global_hooks));
+    return found & CJSON_SWAR_HIGHS;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
+static cJSON_bool is_little_endian(void)
 {
-    if ((object == NULL) || (string == NULL))
-    {
-        return false;
-    }
+    const cjson_uint64 one = 1;
+    unsigned char first = 0;
 
-    return add_item_to_object(object, string, create_reference(item, &global_hooks), &global_hooks, false);
+    memcpy(&first, &one, sizeof(first));
+
+    return first == 1;
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * const name)
+/* copy the run of characters at the start of input that are kept as they are, 8 at a time */
+static void minify_copy_run(const unsigned char **input, const unsigned char * const end, unsigned char **output, const cJSON_bool in_string)
 {
-    cJSON *null = cJSON_CreateNull();
-    if (add_item_to_object(object, name, null, &global_hooks, false))
+    const unsigned char *in = *input;
+    unsigned char *into = *output;
+    cjson_uint64 word = 0;
+    cjson_uint64 found = 0;
+    size_t run = 0;
+
+    while ((size_t)(end - in) >= sizeof(word))
     {
-        return null;
-    }
+        memcpy(&word, in, sizeof(word));
+        found = minify_stops(word, in_string);
+        if (found == 0)
+        {
+            /* output never gets ahead of input, so this doesn't overwrite input that is still needed */
+            memcpy(into, &word, sizeof(word));
+            in += sizeof(word);
+            into += sizeof(word);
+            continue;
+        }
+        if (!is_little_endian())
+        {
+            break;
+        }
 
-    cJSON_Delete(null);
-    return NULL;
-}
+        /* the lowest bit marks the first character that ends the run, add up a one for each byte below it */
+        run = (size_t)(((((found & (~found + 1)) >> 7) - 1) & CJSON_SWAR_ONES) * CJSON_SWAR_ONES >> 56);
+        while (run-- > 0)
+        {
+            *into++ = *in++;
+        }
+        *input = in;
+        *output = into;
+        return;
+    }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddTrueToObject(cJSON * const object, const char * const name)
-{
-    cJSON *true_item = cJSON_CreateTrue();
-    if (add_item_to_object(object, name, true_item, &global_hooks, false))
+    if (in_string)
     {
-        return true_item;
+        while ((in < end) && (in[0] != '\"') && (in[0] != '\\'))
+        {
+            *into++ = *in++;
+        }
+    }
+    else
+    {
+        while ((in < end) && (in[0] > ' ') && (in[0] != '\"') && (in[0] != '/'))
+        {
+            *into++ = *in++;
+        }
     }
 
-    cJSON_Delete(true_item);
-    return NULL;
+    *input = in;
+    *output = into;
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddFalseToObject(cJSON * const object, const char * const name)
+CJSON_PUBLIC(void) cJSON_InitMinifier(cJSON_Minifier *minifier)
 {
-    cJSON *false_item = cJSON_CreateFalse();
-    if (add_item_to_object(object, name, false_item, &global_hooks, false))
+    if (minifier == NULL)
     {
-        return false_item;
+        return;
     }
 
-    cJSON_Delete(false_item);
-    return NULL;
+    minifier->state = minify_between;
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObject(cJSON * const object, const char * const name, const cJSON_bool boolean)
+CJSON_PUBLIC(size_t) cJSON_MinifyChunk(cJSON_Minifier *minifier, const char *input, size_t length, char *output)
 {
-    cJSON *bool_item = cJSON_CreateBool(boolean);
-    if (add_item_to_object(object, name, bool_item, &global_hooks, false))
+    const unsigned char *in = (const unsigned char*)input;
+    const unsigned char *end = NULL;
+    const unsigned char *found = NULL;
+    unsigned char *into = (unsigned char*)output;
+    int state = 0;
+
+    if ((minifier == NULL) || (input == NULL) || (output == NULL))
     {
-        return bool_item;
+        return 0;
     }
 
-    cJSON_Delete(bool_item);
-    return NULL;
-}
-
-CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObject(cJSON * const object, const char * const name, const double number)
-{
-    cJSON *number_item = cJSON_CreateNumber(number);
-    if (add_item_to_object(object, name, number_item, &global_hooks, false))
+    /* kept in a local while running, a store through output could otherwise alias it */
+    state = minifier->state;
+    end = in + length;
+    while (in < end)
     {
-        return number_item;
+        switch (state)
+        {
+            case minify_between:
+            case minify_in_string:
+                minify_copy_run(&in, end, &into, state == minify_in_string);
+                if (in == end)
+                {
+                    break;
+                }
+
+                if (state == minify_in_string)
+                {
+                    state = (in[0] == '\"') ? minify_between : minify_escape;
+                    *into++ = *in++;
+                    break;
+                }
+                switch (in[0])
+                {
+                    case ' ':
+                    case '\t':
+                    case '\r':
+                    case '\n':
+                        in++;
+                        /* indentation comes in runs */
+                        while (((size_t)(end - in) >= sizeof(cjson_uint64)) && (memcmp(in, "        ", sizeof(cjson_uint64)) == 0))
+                        {
+                            in += sizeof(cjson_uint64);
+                        }
+                        while ((in < end) && ((in[0] == ' ') || (in[0] == '\t') || (in[0] == '\r') || (in[0] == '\n')))
+                        {
+                            in++;
+                        }
+                        break;
+
+                    case '\"':
+                        state = minify_in_string;
+                        *into++ = *in++;
+                        break;
+
+                    case '/':
+                        state = minify_slash;
+                        in++;
+                        break;
+
+                    default:
+                        *into++ = *in++;
+                        break;
+                }
+                break;
+
+            case minify_escape:
+                state = minify_in_string;
+                *into++ = *in++;
+                break;
+
+            case minify_slash:
+                /* a '/' that doesn't start a comment is dropped */
+                state = minify_between;
+                if (in[0] == '/')
+                {
+                    state = minify_line_comment;
+                    in++;
+                }
+                else if (in[0] == '*')
+                {
+                    state = minify_block_comment;
+                    in++;
+                }
+                break;
+
+            case minify_line_comment:
+                found = (const unsigned char*)memchr(in, '\n', (size_t)(end - in));
+                if (found == NULL)
+                {
+                    in = end;
+                    break;
+                }
+                state = minify_between;
+                in = found + 1;
+                break;
+
+            case minify_block_comment:
+                found = (const unsigned char*)memchr(in, '*', (size_t)(end - in));
+                if (found == NULL)
+                {
+                    in = end;
+                    break;
+                }
+                state = minify_block_star;
+                in = found + 1;
+                break;
+
+            case minify_block_star:
+                if (in[0] == '/')
+                {
+                    state = minify_between;
+                    in++;
+                }
+                else if (in[0] == '*')
+                {
+                    in++;
+                }
+                else
+                {
+                    state = minify_block_comment;
+                }
+                break;
+
+            default:
+                return 0;
+        }
     }
 
-    cJSON_Delete(number_item);
-    return NULL;
+    minifier->state = state;
+    return (size_t)(into - (unsigned char*)output);
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddStringToObject(cJSON * const object, const char * const name, const char * const string)
+CJSON_PUBLIC(void) cJSON_Minify(char *json)
 {
-    cJSON *string_item = cJSON_CreateString(string);
-    if (add_item_to_object(object, name, string_item, &global_hooks, false))
+    cJSON_Minifier minifier;
+
+    if (json == NULL)
     {
-        return string_item;
+        return;
     }
 
-    cJSON_Delete(string_item);
-    return NULL;
+    cJSON_InitMinifier(&minifier);
+    /* the output never gets ahead of the input, so it can be minified in place */
+    json[cJSON_MinifyChunk(&minifier, json, strlen(json), json)] = '\0';
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddRawToObject(cJSON * const object, const char * const name, const char * const raw)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
 {
-    cJSON *raw_item = cJSON_CreateRaw(raw);
-    if (add_item_to_object(object, name, raw_item, &global_hooks, false))
+    if (item == NULL)
     {
-        return raw_item;
+        return false;
     }
 
-    cJSON_Delete(raw_item);
-    return NULL;
+    return (item->type & 0xFF) == cJSON_Invalid;
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char * const name)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsFalse(const cJSON * const item)
 {
-    cJSON *object_item = cJSON_CreateObject();
-    if (add_item_to_object(object, name, object_item, &global_hooks, false))
+    if (item == NULL)
     {
-        return object_item;
+        return false;
     }
 
-    cJSON_Delete(object_item);
-    return NULL;
+    return (item->type & 0xFF) == cJSON_False;
 }
 
-CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * const name)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsTrue(const cJSON * const item)
 {
-    cJSON *array = cJSON_CreateArray();
-    if (add_item_to_object(object, name, array, &global_hooks, false))
+    if (item == NULL)
     {
-        return array;
+        return false;
     }
 
-    cJSON_Delete(array);
-    return NULL;
+    return (item->type & 0xff) == cJSON_True;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const item)
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsBool(const cJSON * const item)
 {
-    if ((parent == NULL) || (item == NULL) || (item != parent->child && item->prev == NULL))
+    if (item == NULL)
     {
-        return NULL;
+        return false;
     }
 
-    if (item != parent->child)
-    {
-        /* not the first element */
-        item->prev->next = item->next;
-    }
-    if (item->next != NULL)
+    return (item->type & (cJSON_True | cJSON_False)) != 0;
+}
+CJSON_PUBLIC(cJSON_bool) cJSON_IsNull(const cJSON * const item)
+{
+    if (item == NULL)
     {
-        /* not the last element */
-        item->next->prev = item->prev;
+        return false;
     }
 
-    if (item == parent->child)
-    {
-        /* first element */
-        parent->child = item->next;
-    }
-    else if (item->next == NULL)
+    return (item->type & 0xFF) == cJSON_NULL;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsNumber(const cJSON * const item)
+{
+    if (item == NULL)
     {
-        /* last element */
-        parent->child->prev = item->prev;
+        return false;
     }
 
-    /* make sure the detached item doesn't point anywhere anymore */
-    item->prev = NULL;
-    item->next = NULL;
-
-    return item;
+    return (item->type & 0xFF) == cJSON_Number;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromArray(cJSON *array, int which)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsInt64(const cJSON * const item)
 {
-    if (which < 0)
+    if (!cJSON_IsNumber(item) || !(item->internalflags & cJSON_FlagInt64))
     {
-        return NULL;
+        return false;
     }
 
-    return cJSON_DetachItemViaPointer(array, get_array_item(array, (size_t)which));
+    /* valuedouble written directly goes before a stale valueint64 */
+    return item->valuedouble == (double)item->valueint64;
 }
 
-CJSON_PUBLIC(void) cJSON_DeleteItemFromArray(cJSON *array, int which)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item)
 {
-    cJSON_Delete(cJSON_DetachItemFromArray(array, which));
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_String;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromObject(cJSON *object, const char *string)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item)
 {
-    cJSON *to_detach = cJSON_GetObjectItem(object, string);
+    if (item == NULL)
+    {
+        return false;
+    }
 
-    return cJSON_DetachItemViaPointer(object, to_detach);
+    return (item->type & 0xFF) == cJSON_Array;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromObjectCaseSensitive(cJSON *object, const char *string)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item)
 {
-    cJSON *to_detach = cJSON_GetObjectItemCaseSensitive(object, string);
+    if (item == NULL)
+    {
+        return false;
+    }
 
-    return cJSON_DetachItemViaPointer(object, to_detach);
+    return (item->type & 0xFF) == cJSON_Object;
 }
 
-CJSON_PUBLIC(void) cJSON_DeleteItemFromObject(cJSON *object, const char *string)
+CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
 {
-    cJSON_Delete(cJSON_DetachItemFromObject(object, string));
-}
+    if (item == NULL)
+    {
+        return false;
+    }
 
-CJSON_PUBLIC(void) cJSON_DeleteItemFromObjectCaseSensitive(cJSON *object, const char *string)
-{
-    cJSON_Delete(cJSON_DetachItemFromObjectCaseSensitive(object, string));
+    return (item->type & 0xFF) == cJSON_Raw;
 }
 
-/* Replace array/object items with new ones. */
-CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
+CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
 {
-    cJSON *after_inserted = NULL;
-
-    if (which < 0 || newitem == NULL)
+    if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)))
     {
         return false;
     }
 
-    after_inserted = get_array_item(array, (size_t)which);
-    if (after_inserted == NULL)
+    /* check if type is valid */
+    switch (a->type & 0xFF)
     {
-        return add_item_to_array(array, newitem);
-    }
+        case cJSON_False:
+        case cJSON_True:
+        case cJSON_NULL:
+        case cJSON_Number:
+        case cJSON_String:
+        case cJSON_Raw:
+        case cJSON_Array:
+        case cJSON_Object:
+            break;
 
-    if (after_inserted != array->child && after_inserted->prev == NULL) {
-        /* return false if after_inserted is a corrupted array item */
-        return false;
+        default:
+            return false;
     }
 
-    newitem->next = after_inserted;
-    newitem->prev = after_inserted->prev;
-    after_inserted->prev = newitem;
-    if (after_inserted == array->child)
+    /* identical objects are equal */
+    if (a == b)
     {
-        array->child = newitem;
+        return true;
     }
-    else
+
+    if (!lazy_expand(a) || !lazy_expand(b))
     {
-        newitem->prev->next = newitem;
+        return false;
     }
-    return true;
-}
 
-CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON * const item, cJSON * replacement)
-{
-    if ((parent == NULL) || (parent->child == NULL) || (replacement == NULL) || (item == NULL))
-    {
-        return false;
-    }
+    switch (a->type & 0xFF)
+    {
+        /* in these cases and equal type is enough */
+        case cJSON_False:
+        case cJSON_True:
+        case cJSON_NULL:
+            return true;
+
+        case cJSON_Number:
+            if (cJSON_IsInt64(a) && cJSON_IsInt64(b))
+            {
+                return a->valueint64 == b->valueint64;
+            }
+            if (compare_double(a->valuedouble, b->valuedouble))
+            {
+                return true;
+            }
+            return false;
+
+        case cJSON_String:
+        case cJSON_Raw:
+            if ((a->valuestring == NULL) || (b->valuestring == NULL))
+            {
+                return false;
+            }
+            if (strcmp(a->valuestring, b->valuestring) == 0)
+            {
+                return true;
+            }
+
+            return false;
+
+        case cJSON_Array:
+        {
+            cJSON *a_element = a->child;
+            cJSON *b_element = b->child;
+
+            for (; (a_element != NULL) && (b_element != NULL);)
+            {
+                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                {
+                    return false;
+                }
+
+                a_element = a_element->next;
+                b_element = b_element->next;
+            }
+
+            /* one of the arrays is longer than the other */
+            if (a_element != b_element) {
+                return false;
+            }
+
+            return true;
+        }
+
+        case cJSON_Object:
+        {
+            cJSON *a_element = NULL;
+            cJSON *b_element = NULL;
+            cJSON_ArrayForEach(a_element, a)
+            {
+                /* TODO This has O(n^2) runtime, which is horrible! */
+                b_element = get_object_item(b, a_element->string, case_sensitive);
+                if (b_element == NULL)
+                {
+                    return false;
+                }
+
+                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                {
+                    return false;
+                }
+            }
+
+            /* doing this twice, once on a and b to prevent true comparison if a subset of b
+             * TODO: Do this the proper way, this is just a fix for now */
+            cJSON_ArrayForEach(b_element, b)
+            {
+                a_element = get_object_item(a, b_element->string, case_sensitive);
+                if (a_element == NULL)
+                {
+                    return false;
+                }
+
+                if (!cJSON_Compare(b_element, a_element, case_sensitive))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
 
-    if (replacement == item)
-    {
-        return true;
+        default:
+            return false;
     }
+}
 
-    replacement->next = item->next;
-    replacement->prev = item->prev;
+/* JSON Patch generation. The path of the value being compared is kept in one growing buffer. */
+typedef struct
+{
+    char *buffer;
+    size_t length;
+    size_t capacity;
+} patch_path;
 
-    if (replacement->next != NULL)
-    {
-        replacement->next->prev = replacement;
-    }
-    if (parent->child == item)
+static cJSON_bool path_append(patch_path * const path, const char * const text, const size_t length)
+{
+    if ((path->length + length + sizeof("")) > path->capacity)
     {
-        if (parent->child->prev == parent->child)
+        size_t capacity = (path->capacity > 0) ? path->capacity : 64;
+        char *buffer = NULL;
+        while (capacity < (path->length + length + sizeof("")))
         {
-            replacement->prev = replacement;
+            capacity *= 2;
         }
-        parent->child = replacement;
-    }
-    else
-    {   /*
-         * To find the last item in array quickly, we use prev in array.
-         * We can't modify the last item's next pointer where this item was the parent's child
-         */
-        if (replacement->prev != NULL)
+        buffer = (char*)global_hooks.allocate(capacity);
+        if (buffer == NULL)
         {
-            replacement->prev->next = replacement;
+            return false;
         }
-        if (replacement->next == NULL)
+        if (path->buffer != NULL)
         {
-            parent->child->prev = replacement;
+            memcpy(buffer, path->buffer, path->length);
+            global_hooks.deallocate(path->buffer);
         }
+        path->buffer = buffer;
+        path->capacity = capacity;
     }
 
-    item->next = NULL;
-    item->prev = NULL;
-    cJSON_Delete(item);
+    memcpy(path->buffer + path->length, text, length);
+    path->length += length;
+    path->buffer[path->length] = '\0';
 
     return true;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
-{
-    if (which < 0)
-    {
-        return false;
-    }
-
-    return cJSON_ReplaceItemViaPointer(array, get_array_item(array, (size_t)which), newitem);
-}
-
-static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSON *replacement, cJSON_bool case_sensitive)
+/* append a member name as a JSON pointer segment, '~' and '/' escaped */
+static cJSON_bool path_push_key(patch_path * const path, const char *key)
 {
-    if ((replacement == NULL) || (string == NULL))
+    if (!path_append(path, "/", 1))
     {
         return false;
     }
-
-    /* replace the name in the replacement */
-    if (!(replacement->type & cJSON_StringIsConst) && (replacement->string != NULL))
-    {
-        cJSON_free(replacement->string);
-    }
-    replacement->string = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
-    if (replacement->string == NULL)
+    for (; *key != '\0'; key++)
     {
-        return false;
+        const char *text = key;
+        size_t length = 1;
+        if (*key == '~')
+        {
+            text = "~0";
+            length = 2;
+        }
+        else if (*key == '/')
+        {
+            text = "~1";
+            length = 2;
+        }
+        if (!path_append(path, text, length))
+        {
+            return false;
+        }
     }
 
-    replacement->type &= ~cJSON_StringIsConst;
-
-    return cJSON_ReplaceItemViaPointer(object, get_object_item(object, string, case_sensitive), replacement);
+    return true;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
+static cJSON_bool path_push_index(patch_path * const path, const size_t index)
 {
-    return replace_item_in_object(object, string, newitem, false);
+    char segment[24];
+    const int length = sprintf(segment, "/%lu", (unsigned long)index);
+
+    return path_append(path, segment, (size_t)length);
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, const char *string, cJSON *newitem)
+static void path_pop(patch_path * const path, const size_t length)
 {
-    return replace_item_in_object(object, string, newitem, true);
+    path->length = length;
+    path->buffer[length] = '\0';
 }
 
-/* Create basic types: */
-CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
+/* append {"op": op, "from": from, "path": path, "value": value} to patch, from and value may be NULL */
+static cJSON_bool add_patch_operation(cJSON * const patch, const char * const op, const char * const from, const char * const path, const cJSON * const value)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    cJSON *operation = cJSON_CreateObject();
+    if (operation == NULL)
     {
-        item->type = cJSON_NULL;
+        return false;
     }
-
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    if (!cJSON_AddItemToArray(patch, operation))
     {
-        item->type = cJSON_True;
+        cJSON_Delete(operation);
+        return false;
     }
 
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    if ((cJSON_AddStringToObject(operation, "op", op) == NULL)
+        || ((from != NULL) && (cJSON_AddStringToObject(operation, "from", from) == NULL))
+        || (cJSON_AddStringToObject(operation, "path", path) == NULL))
     {
-        item->type = cJSON_False;
+        return false;
     }
-
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    if (value != NULL)
     {
-        item->type = boolean ? cJSON_True : cJSON_False;
+        cJSON *copy = cJSON_Duplicate(value, true);
+        if ((copy == NULL) || !cJSON_AddItemToObject(operation, "value", copy))
+        {
+            cJSON_Delete(copy);
+            return false;
+        }
     }
 
-    return item;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+static cJSON_bool diff_items(cJSON * const patch, patch_path * const path, const cJSON * const from, const cJSON * const to, const char * const key);
+
+static cJSON_bool diff_objects(cJSON * const patch, patch_path * const path, const cJSON * const from, const cJSON * const to, const char * const key)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
-    {
-        item->type = cJSON_Number;
-        item->valuedouble = num;
+    const size_t length = path->length;
+    const cJSON *element = NULL;
 
-        /* use saturation in case of overflow */
-        if (num >= INT_MAX)
+    for (element = from->child; element != NULL; element = element->next)
+    {
+        const cJSON *other = cJSON_GetObjectItemCaseSensitive(to, element->string);
+        if (!path_push_key(path, element->string))
         {
-            item->valueint = INT_MAX;
+            return false;
         }
-        else if (num <= (double)INT_MIN)
+        if (other == NULL)
         {
-            item->valueint = INT_MIN;
+            if (!add_patch_operation(patch, "remove", NULL, path->buffer, NULL))
+            {
+                return false;
+            }
         }
-        else
+        else if (!diff_items(patch, path, element, other, key))
         {
-            item->valueint = (int)num;
+            return false;
         }
+        path_pop(path, length);
     }
 
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    for (element = to->child; element != NULL; element = element->next)
     {
-        item->type = cJSON_String;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
-        if(!item->valuestring)
+        if (cJSON_GetObjectItemCaseSensitive(from, element->string) != NULL)
         {
-            cJSON_Delete(item);
-            return NULL;
+            continue;
         }
+        if (!path_push_key(path, element->string) || !add_patch_operation(patch, "add", NULL, path->buffer, element))
+        {
+            return false;
+        }
+        path_pop(path, length);
     }
 
-    return item;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
+/* arrays of different elements compared by position: common part, then removals from the back or additions */
+static cJSON_bool diff_arrays(cJSON * const patch, patch_path * const path, const cJSON * const from, const cJSON * const to, const char * const key)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if (item != NULL)
-    {
-        item->type = cJSON_String | cJSON_IsReference;
-        item->valuestring = (char*)cast_away_const(string);
-    }
-
-    return item;
-}
+    const size_t length = path->length;
+    const size_t from_count = (size_t)child_count(from);
+    const size_t to_count = (size_t)child_count(to);
+    const cJSON *from_element = from->child;
+    const cJSON *to_element = to->child;
+    size_t i = 0;
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if (item != NULL) {
-        item->type = cJSON_Object | cJSON_IsReference;
-        item->child = (cJSON*)cast_away_const(child);
+    for (i = 0; (from_element != NULL) && (to_element != NULL); i++)
+    {
+        if (!path_push_index(path, i) || !diff_items(patch, path, from_element, to_element, key))
+        {
+            return false;
+        }
+        path_pop(path, length);
+        from_element = from_element->next;
+        to_element = to_element->next;
     }
 
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child) {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if (item != NULL) {
-        item->type = cJSON_Array | cJSON_IsReference;
-        item->child = (cJSON*)cast_away_const(child);
+    for (i = from_count; i > to_count; i--)
+    {
+        if (!path_push_index(path, i - 1) || !add_patch_operation(patch, "remove", NULL, path->buffer, NULL))
+        {
+            return false;
+        }
+        path_pop(path, length);
     }
 
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    for (i = from_count; to_element != NULL; i++)
     {
-        item->type = cJSON_Raw;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)raw, &global_hooks);
-        if(!item->valuestring)
+        if (!path_push_index(path, i) || !add_patch_operation(patch, "add", NULL, path->buffer, to_element))
         {
-            cJSON_Delete(item);
-            return NULL;
+            return false;
         }
+        path_pop(path, length);
+        to_element = to_element->next;
     }
 
-    return item;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
+/* the member that identifies an element of a keyed array, NULL if it has none */
+static const cJSON *element_key(const cJSON * const element, const char * const key)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    const cJSON *value = NULL;
+
+    if (!cJSON_IsObject(element))
     {
-        item->type=cJSON_Array;
+        return NULL;
+    }
+    value = cJSON_GetObjectItemCaseSensitive(element, key);
+    if (!cJSON_IsString(value) && !cJSON_IsNumber(value))
+    {
+        return NULL;
     }
 
-    return item;
+    return value;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void)
+static unsigned int element_key_hash(const cJSON * const value)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if (item)
+    double number = value->valuedouble;
+
+    if (cJSON_IsString(value))
     {
-        item->type = cJSON_Object;
+        return cJSON_HashKey(value->valuestring, strlen(value->valuestring));
+    }
+    /* by the double, like cJSON_Compare compares them */
+    if (number == 0)
+    {
+        /* -0 is the same key as 0 */
+        number = 0;
     }
 
-    return item;
+    return cJSON_HashKey((const char*)&number, sizeof(number));
 }
 
-/* Create Arrays: */
-CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
+/* open addressing table from key to position + 1 in elements */
+typedef struct
 {
-    size_t i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = NULL;
-
-    if ((count < 0) || (numbers == NULL))
-    {
-        return NULL;
-    }
+    size_t *slots;
+    size_t mask;
+} key_table;
 
-    a = cJSON_CreateArray();
+static const cJSON *key_table_find(const key_table * const table, const cJSON * const * const elements, const char * const key, const cJSON * const value, size_t * const position)
+{
+    size_t slot = element_key_hash(value) & table->mask;
 
-    for(i = 0; a && (i < (size_t)count); i++)
+    for (; table->slots[slot] != 0; slot = (slot + 1) & table->mask)
     {
-        n = cJSON_CreateNumber(numbers[i]);
-        if (!n)
+        const cJSON *element = elements[table->slots[slot] - 1];
+        const cJSON *element_value = element_key(element, key);
+        if (((element_value->type & 0xFF) == (value->type & 0xFF)) && cJSON_Compare(element_value, value, true))
         {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
-        {
-            suffix_object(p, n);
+            *position = table->slots[slot] - 1;
+            return element;
         }
-        p = n;
     }
 
-    if (a && a->child) {
-        a->child->prev = n;
+    *position = slot;
+    return NULL;
+}
+
+/* Fill elements and table from array. Fails if an element has no key or a key appears twice. */
+static cJSON_bool key_table_build(key_table * const table, const cJSON ** const elements, const cJSON * const array, const char * const key)
+{
+    const cJSON *element = NULL;
+    size_t count = 0;
+
+    for (element = array->child; element != NULL; element = element->next)
+    {
+        const cJSON *value = element_key(element, key);
+        size_t slot = 0;
+        if ((value == NULL) || (key_table_find(table, elements, key, value, &slot) != NULL))
+        {
+            return false;
+        }
+        elements[count] = element;
+        table->slots[slot] = ++count;
     }
 
-    return a;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
+/* Arrays whose elements are identified by key: removals from the back, then for every position of to either a move
+ * of the matching element into place or an addition, followed by the diff of the matched pair.
+ * Returns -1 if the arrays don't qualify, 0 on allocation failure. */
+static int diff_keyed_arrays(cJSON * const patch, patch_path * const path, const cJSON * const from, const cJSON * const to, const char * const key)
 {
+    const size_t length = path->length;
+    const size_t from_count = (size_t)child_count(from);
+    const size_t to_count = (size_t)child_count(to);
+    size_t capacity = 1;
+    const cJSON **from_elements = NULL;
+    const cJSON **to_elements = NULL;
+    /* the array as the operations so far left it */
+    const cJSON **current = NULL;
+    size_t current_count = 0;
+    key_table from_table = { NULL, 0 };
+    key_table to_table = { NULL, 0 };
     size_t i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = NULL;
+    int result = 0;
 
-    if ((count < 0) || (numbers == NULL))
+    while (capacity < (((from_count > to_count) ? from_count : to_count) * 2))
     {
-        return NULL;
+        capacity <<= 1;
+    }
+    from_elements = (const cJSON**)global_hooks.allocate((from_count + (2 * to_count)) * sizeof(cJSON*));
+    from_table.slots = (size_t*)global_hooks.allocate(capacity * 2 * sizeof(size_t));
+    if ((from_elements == NULL) || (from_table.slots == NULL))
+    {
+        goto cleanup;
     }
+    to_elements = from_elements + from_count;
+    current = to_elements + to_count;
+    memset(from_table.slots, '\0', capacity * 2 * sizeof(size_t));
+    from_table.mask = capacity - 1;
+    to_table.slots = from_table.slots + capacity;
+    to_table.mask = capacity - 1;
 
-    a = cJSON_CreateArray();
+    if (!key_table_build(&from_table, from_elements, from, key) || !key_table_build(&to_table, to_elements, to, key))
+    {
+        result = -1;
+        goto cleanup;
+    }
 
-    for(i = 0; a && (i < (size_t)count); i++)
+    for (i = from_count; i > 0; i--)
     {
-        n = cJSON_CreateNumber((double)numbers[i]);
-        if(!n)
+        size_t position = 0;
+        if (key_table_find(&to_table, to_elements, key, element_key(from_elements[i - 1], key), &position) != NULL)
         {
-            cJSON_Delete(a);
-            return NULL;
+            continue;
         }
-        if(!i)
+        if (!path_push_index(path, i - 1) || !add_patch_operation(patch, "remove", NULL, path->buffer, NULL))
         {
-            a->child = n;
+            goto cleanup;
         }
-        else
+        path_pop(path, length);
+    }
+    for (i = 0; i < from_count; i++)
+    {
+        size_t position = 0;
+        if (key_table_find(&to_table, to_elements, key, element_key(from_elements[i], key), &position) != NULL)
         {
-            suffix_object(p, n);
+            current[current_count++] = from_elements[i];
         }
-        p = n;
     }
 
-    if (a && a->child) {
-        a->child->prev = n;
-    }
-
-    return a;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count)
-{
-    size_t i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = NULL;
-
-    if ((count < 0) || (numbers == NULL))
+    for (i = 0; i < to_count; i++)
     {
-        return NULL;
-    }
+        size_t position = 0;
+        const cJSON *match = key_table_find(&from_table, from_elements, key, element_key(to_elements[i], key), &position);
 
-    a = cJSON_CreateArray();
+        if (match == NULL)
+        {
+            if (!path_push_index(path, i) || !add_patch_operation(patch, "add", NULL, path->buffer, to_elements[i]))
+            {
+                goto cleanup;
+            }
+            path_pop(path, length);
+            memmove(current + i + 1, current + i, (current_count - i) * sizeof(cJSON*));
+            current[i] = to_elements[i];
+            current_count++;
+            continue;
+        }
 
-    for(i = 0; a && (i < (size_t)count); i++)
-    {
-        n = cJSON_CreateNumber(numbers[i]);
-        if(!n)
+        /* everything before i is in place already, so the match is at i or after it */
+        for (position = i; current[position] != match; position++)
         {
-            cJSON_Delete(a);
-            return NULL;
         }
-        if(!i)
+        if (position != i)
         {
-            a->child = n;
+            char *move_from = NULL;
+            cJSON_bool added = false;
+            if (!path_push_index(path, position))
+            {
+                goto cleanup;
+            }
+            move_from = (char*)cJSON_strdup((const unsigned char*)path->buffer, &global_hooks);
+            path_pop(path, length);
+            added = (move_from != NULL) && path_push_index(path, i) && add_patch_operation(patch, "move", move_from, path->buffer, NULL);
+            if (move_from != NULL)
+            {
+                global_hooks.deallocate(move_from);
+            }
+            if (!added)
+            {
+                goto cleanup;
+            }
+            path_pop(path, length);
+            memmove(current + i + 1, current + i, (position - i) * sizeof(cJSON*));
+            current[i] = match;
         }
-        else
+
+        if (!path_push_index(path, i) || !diff_items(patch, path, match, to_elements[i], key))
         {
-            suffix_object(p, n);
+            goto cleanup;
         }
-        p = n;
+        path_pop(path, length);
     }
+    result = 1;
 
-    if (a && a->child) {
-        a->child->prev = n;
+cleanup:
+    if (from_elements != NULL)
+    {
+        global_hooks.deallocate((void*)from_elements);
+    }
+    if (from_table.slots != NULL)
+    {
+        global_hooks.deallocate(from_table.slots);
     }
 
-    return a;
+    return result;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int count)
+static cJSON_bool diff_items(cJSON * const patch, patch_path * const path, const cJSON * const from, const cJSON * const to, const char * const key)
 {
-    size_t i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = NULL;
+    const int type = from->type & 0xFF;
 
-    if ((count < 0) || (strings == NULL))
+    if (!lazy_expand(from) || !lazy_expand(to))
     {
-        return NULL;
+        return false;
     }
 
-    a = cJSON_CreateArray();
-
-    for (i = 0; a && (i < (size_t)count); i++)
+    if (type == (to->type & 0xFF))
     {
-        n = cJSON_CreateString(strings[i]);
-        if(!n)
-        {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
+        switch (type)
         {
-            suffix_object(p,n);
+            case cJSON_Object:
+                return diff_objects(patch, path, from, to, key);
+
+            case cJSON_Array:
+                if ((key != NULL) && (from->child != NULL) && (to->child != NULL))
+                {
+                    const int result = diff_keyed_arrays(patch, path, from, to, key);
+                    if (result >= 0)
+                    {
+                        return result == 1;
+                    }
+                }
+                return diff_arrays(patch, path, from, to, key);
+
+            default:
+                if (cJSON_Compare(from, to, true))
+                {
+                    return true;
+                }
+                break;
         }
-        p = n;
     }
 
-    if (a && a->child) {
-        a->child->prev = n;
+    return add_patch_operation(patch, "replace", NULL, (path->buffer != NULL) ? path->buffer : "", to);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Diff(const cJSON *from, const cJSON *to, const char *key)
+{
+    patch_path path = { NULL, 0, 0 };
+    cJSON *patch = NULL;
+
+    if ((from == NULL) || (to == NULL))
+    {
+        return NULL;
     }
 
-    return a;
-}
+    patch = cJSON_CreateArray();
+    if (patch == NULL)
+    {
+        return NULL;
+    }
+    if (!diff_items(patch, &path, from, to, key))
+    {
+        cJSON_Delete(patch);
+        patch = NULL;
+    }
 
-/* Duplication */
-cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse);
+    if (path.buffer != NULL)
+    {
+        global_hooks.deallocate(path.buffer);
+    }
 
-CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
-{
-    return cJSON_Duplicate_rec(item, 0, recurse );
+    return patch;
 }
 
-cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
+CJSON_PUBLIC(unsigned char *) cJSON_EncodeCBOR(const cJSON *item, cJSON_bool framed, size_t *length)
 {
-    cJSON *newitem = NULL;
-    cJSON *child = NULL;
-    cJSON *next = NULL;
-    cJSON *newchild = NULL;
+    static const size_t default_buffer_size = 256;
+    printbuffer buffer;
+    unsigned char *encoded = NULL;
+    const size_t start = framed ? CJSON_CBOR_FRAME_HEADER : 0;
 
-    /* Bail on bad ptr */
-    if (!item)
+    if (item == NULL)
     {
-        goto fail;
+        return NULL;
     }
-    /* Create new item */
-    newitem = cJSON_New_Item(&global_hooks);
-    if (!newitem)
+
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.buffer = (unsigned char*)global_hooks.allocate(default_buffer_size);
+    if (buffer.buffer == NULL)
     {
-        goto fail;
+        return NULL;
     }
-    /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
-    newitem->valueint = item->valueint;
-    newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    buffer.length = default_buffer_size;
+    buffer.offset = start;
+    buffer.hooks = global_hooks;
+
+    if (!cbor_encode_value(item, &buffer) || (framed && !cbor_put_frame_length(buffer.buffer, buffer.offset - start)))
     {
-        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
-        if (!newitem->valuestring)
+        /* ensure frees the buffer when growing it fails */
+        if (buffer.buffer != NULL)
         {
-            goto fail;
+            global_hooks.deallocate(buffer.buffer);
         }
+        return NULL;
     }
-    if (item->string)
+
+    encoded = buffer.buffer;
+    if (global_hooks.reallocate != NULL)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
-        if (!newitem->string)
+        /* give back what wasn't used, keeping the null terminator */
+        encoded = (unsigned char*)global_hooks.reallocate(buffer.buffer, buffer.offset + 1);
+        if (encoded == NULL)
         {
-            goto fail;
+            global_hooks.deallocate(buffer.buffer);
+            return NULL;
         }
     }
-    /* If non-recursive, then we're done! */
-    if (!recurse)
+    if (length != NULL)
     {
-        return newitem;
+        *length = buffer.offset;
     }
-    /* Walk the ->next chain for the child. */
-    child = item->child;
-    while (child != NULL)
+
+    return encoded;
+}
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth;
+} cbor_buffer;
+
+/* Read an initial byte and the argument that follows it. info is CBOR_INDEFINITE for an indefinite length. */
+static cJSON_bool cbor_read_head(cbor_buffer * const input, int * const major, int * const info, cjson_uint64 * const argument)
+{
+    size_t bytes = 0;
+    size_t i = 0;
+
+    if (input->offset >= input->length)
     {
-        if(depth >= CJSON_CIRCULAR_LIMIT) {
-            goto fail;
-        }
-        newchild = cJSON_Duplicate_rec(child, depth + 1, true); /* Duplicate (with recurse) each item in the ->next chain */
-        if (!newchild)
-        {
-            goto fail;
-        }
-        if (next != NULL)
-        {
-            /* If newitem->child already set, then crosswire ->prev and ->next and move on */
-            next->next = newchild;
-            newchild->prev = next;
-            next = newchild;
-        }
-        else
-        {
-            /* Set newitem->child and move to it */
-            newitem->child = newchild;
-            next = newchild;
-        }
-        child = child->next;
+        return false;
     }
-    if (newitem && newitem->child)
+
+    *major = input->content[input->offset] >> 5;
+    *info = input->content[input->offset] & 0x1F;
+    input->offset++;
+    *argument = (cjson_uint64)*info;
+    if ((*info < 24) || (*info == CBOR_INDEFINITE))
     {
-        newitem->child->prev = newchild;
+        return true;
+    }
+    if (*info > 27)
+    {
+        /* reserved */
+        return false;
     }
 
-    return newitem;
-
-fail:
-    if (newitem != NULL)
+    bytes = (size_t)1 << (*info - 24);
+    if (bytes > (input->length - input->offset))
     {
-        cJSON_Delete(newitem);
+        return false;
+    }
+    *argument = 0;
+    for (i = 0; i < bytes; i++)
+    {
+        *argument = (*argument << 8) | input->content[input->offset + i];
     }
+    input->offset += bytes;
 
-    return NULL;
+    return true;
 }
 
-static void skip_oneline_comment(char **input)
+/* A chunk of text of the given length, which has to be there and can't contain NUL */
+static cJSON_bool cbor_text_chunk(const cbor_buffer * const input, const cjson_uint64 length)
 {
-    *input += static_strlen("//");
-
-    for (; (*input)[0] != '\0'; ++(*input))
-    {
-        if ((*input)[0] == '\n') {
-            *input += static_strlen("\n");
-            return;
-        }
-    }
+    return (length <= (cjson_uint64)(input->length - input->offset))
+        && (memchr(input->content + input->offset, '\0', (size_t)length) == NULL);
 }
 
-static void skip_multiline_comment(char **input)
+/* Read a text string whose head was read already into memory from the hooks */
+static cJSON_bool cbor_read_text(cbor_buffer * const input, const int info, const cjson_uint64 argument, char ** const text)
 {
-    *input += static_strlen("/*");
+    const size_t start = input->offset;
+    size_t length = 0;
+    unsigned char *output = NULL;
+    int major = 0;
+    int chunk_info = 0;
+    cjson_uint64 chunk = argument;
 
-    for (; (*input)[0] != '\0'; ++(*input))
+    if (info != CBOR_INDEFINITE)
     {
-        if (((*input)[0] == '*') && ((*input)[1] == '/'))
+        if (!cbor_text_chunk(input, argument))
         {
-            *input += static_strlen("*/");
-            return;
+            return false;
         }
+        length = (size_t)argument;
+        input->offset += length;
     }
-}
-
-static void minify_string(char **input, char **output) {
-    (*output)[0] = (*input)[0];
-    *input += static_strlen("\"");
-    *output += static_strlen("\"");
-
-
-    for (; (*input)[0] != '\0'; (void)++(*input), ++(*output)) {
-        (*output)[0] = (*input)[0];
-
-        if ((*input)[0] == '\"') {
-            (*output)[0] = '\"';
-            *input += static_strlen("\"");
-            *output += static_strlen("\"");
-            return;
-        } else if (((*input)[0] == '\\') && ((*input)[1] == '\"')) {
-            (*output)[1] = (*input)[1];
-            *input += static_strlen("\"");
-            *output += static_strlen("\"");
+    else
+    {
+        /* definite length chunks up to the break, measured before anything is copied */
+        while (true)
+        {
+            if (input->offset >= input->length)
+            {
+                return false;
+            }
+            if (input->content[input->offset] == CBOR_BREAK)
+            {
+                break;
+            }
+            if (!cbor_read_head(input, &major, &chunk_info, &chunk) || (major != CBOR_TEXT)
+                    || (chunk_info == CBOR_INDEFINITE) || !cbor_text_chunk(input, chunk))
+            {
+                return false;
+            }
+            length += (size_t)chunk;
+            input->offset += (size_t)chunk;
         }
     }
-}
-
-CJSON_PUBLIC(void) cJSON_Minify(char *json)
-{
-    char *into = json;
 
-    if (json == NULL)
+    output = (unsigned char*)global_hooks.allocate(length + sizeof(""));
+    if (output == NULL)
     {
-        return;
+        return false;
     }
 
-    while (json[0] != '\0')
+    if (info != CBOR_INDEFINITE)
     {
-        switch (json[0])
+        memcpy(output, input->content + start, length);
+    }
+    else
+    {
+        size_t copied = 0;
+        input->offset = start;
+        while (input->content[input->offset] != CBOR_BREAK)
         {
-            case ' ':
-            case '\t':
-            case '\r':
-            case '\n':
-                json++;
-                break;
-
-            case '/':
-                if (json[1] == '/')
-                {
-                    skip_oneline_comment(&json);
-                }
-                else if (json[1] == '*')
-                {
-                    skip_multiline_comment(&json);
-                } else {
-                    json++;
-                }
-                break;
-
-            case '\"':
-                minify_string(&json, (char**)&into);
-                break;
-
-            default:
-                into[0] = json[0];
-                json++;
-                into++;
+            cbor_read_head(input, &major, &chunk_info, &chunk);
+            memcpy(output + copied, input->content + input->offset, (size_t)chunk);
+            copied += (size_t)chunk;
+            input->offset += (size_t)chunk;
         }
+        /* skip the break */
+        input->offset++;
     }
+    output[length] = '\0';
+    *text = (char*)output;
 
-    /* and null-terminate. */
-    *into = '\0';
+    return true;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
+/* float16 and float32 are widened without relying on the layout of float */
+static double cbor_half_to_double(const cjson_uint64 half)
 {
-    if (item == NULL)
+    const int exponent = (int)((half >> 10) & 0x1F);
+    const double significand = (double)(half & 0x3FF);
+    double number = 0;
+
+    if (exponent == 0)
     {
-        return false;
+        number = ldexp(significand, -24);
     }
-
-    return (item->type & 0xFF) == cJSON_Invalid;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsFalse(const cJSON * const item)
-{
-    if (item == NULL)
+    else if (exponent != 0x1F)
     {
-        return false;
+        number = ldexp(significand + 1024, exponent - 25);
     }
-
-    return (item->type & 0xFF) == cJSON_False;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsTrue(const cJSON * const item)
-{
-    if (item == NULL)
+    else
     {
-        return false;
+        number = (significand == 0) ? HUGE_VAL : NAN;
     }
 
-    return (item->type & 0xff) == cJSON_True;
+    return (half & 0x8000) ? -number : number;
 }
 
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsBool(const cJSON * const item)
+static double cbor_single_to_double(const cjson_uint64 single)
 {
-    if (item == NULL)
+    const int exponent = (int)((single >> 23) & 0xFF);
+    const double significand = (double)(single & 0x7FFFFF);
+    double number = 0;
+
+    if (exponent == 0)
     {
-        return false;
+        number = ldexp(significand, -149);
     }
-
-    return (item->type & (cJSON_True | cJSON_False)) != 0;
-}
-CJSON_PUBLIC(cJSON_bool) cJSON_IsNull(const cJSON * const item)
-{
-    if (item == NULL)
+    else if (exponent != 0xFF)
     {
-        return false;
+        number = ldexp(significand + 8388608.0, exponent - 150);
     }
-
-    return (item->type & 0xFF) == cJSON_NULL;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsNumber(const cJSON * const item)
-{
-    if (item == NULL)
+    else
     {
-        return false;
+        number = (significand == 0) ? HUGE_VAL : NAN;
     }
 
-    return (item->type & 0xFF) == cJSON_Number;
+    return (single & 0x80000000UL) ? -number : number;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item)
+static cJSON_bool cbor_decode_value(cJSON * const item, cbor_buffer * const input);
+
+static cJSON_bool cbor_decode_container(cJSON * const item, cbor_buffer * const input, const int major, const int info, const cjson_uint64 count)
 {
-    if (item == NULL)
+    cJSON *child = NULL;
+    cjson_uint64 i = 0;
+    int key_major = 0;
+    int key_info = 0;
+    cjson_uint64 key_argument = 0;
+
+    if (input->depth >= CJSON_NESTING_LIMIT)
     {
         return false;
     }
-
-    return (item->type & 0xFF) == cJSON_String;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item)
-{
-    if (item == NULL)
+    /* every element takes at least one byte, which keeps absurd counts from looping */
+    if ((info != CBOR_INDEFINITE) && ((count > (cjson_uint64)(input->length - input->offset)) || (count > INT_MAX)))
     {
         return false;
     }
 
-    return (item->type & 0xFF) == cJSON_Array;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item)
-{
-    if (item == NULL)
+    item->type = (major == CBOR_ARRAY) ? cJSON_Array : cJSON_Object;
+    input->depth++;
+    for (i = 0; (info == CBOR_INDEFINITE) || (i < count); i++)
     {
-        return false;
-    }
+        if ((info == CBOR_INDEFINITE) && (input->offset < input->length) && (input->content[input->offset] == CBOR_BREAK))
+        {
+            input->offset++;
+            break;
+        }
+        if (item->childcount == INT_MAX)
+        {
+            return false;
+        }
 
-    return (item->type & 0xFF) == cJSON_Object;
-}
+        child = cJSON_New_Item(&global_hooks);
+        if (child == NULL)
+        {
+            return false;
+        }
+        /* linked first, so deleting item on failure releases it */
+        if (item->child == NULL)
+        {
+            item->child = child;
+        }
+        else
+        {
+            item->child->prev->next = child;
+            child->prev = item->child->prev;
+        }
+        item->child->prev = child;
+        item->childcount++;
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
-{
-    if (item == NULL)
-    {
-        return false;
+        if (major == CBOR_MAP)
+        {
+            if (!cbor_read_head(input, &key_major, &key_info, &key_argument) || (key_major != CBOR_TEXT)
+                    || !cbor_read_text(input, key_info, key_argument, &child->string))
+            {
+                return false;
+            }
+        }
+        if (!cbor_decode_value(child, input))
+        {
+            return false;
+        }
     }
+    input->depth--;
 
-    return (item->type & 0xFF) == cJSON_Raw;
+    return true;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
+static cJSON_bool cbor_decode_value(cJSON * const item, cbor_buffer * const input)
 {
-    if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)))
+    int major = 0;
+    int info = 0;
+    cjson_uint64 argument = 0;
+
+    if (!cbor_read_head(input, &major, &info, &argument))
     {
         return false;
     }
-
-    /* check if type is valid */
-    switch (a->type & 0xFF)
+    /* tags only annotate the item that follows */
+    while ((major == CBOR_TAG) && (info != CBOR_INDEFINITE))
     {
-        case cJSON_False:
-        case cJSON_True:
-        case cJSON_NULL:
-        case cJSON_Number:
-        case cJSON_String:
-        case cJSON_Raw:
-        case cJSON_Array:
-        case cJSON_Object:
-            break;
-
-        default:
+        if (!cbor_read_head(input, &major, &info, &argument))
+        {
             return false;
+        }
     }
-
-    /* identical objects are equal */
-    if (a == b)
+    if ((info == CBOR_INDEFINITE) && ((major < CBOR_BYTES) || (major == CBOR_TAG) || (major == CBOR_SIMPLE)))
     {
-        return true;
+        return false;
     }
 
-    switch (a->type & 0xFF)
+    switch (major)
     {
-        /* in these cases and equal type is enough */
-        case cJSON_False:
-        case cJSON_True:
-        case cJSON_NULL:
-            return true;
-
-        case cJSON_Number:
-            if (compare_double(a->valuedouble, b->valuedouble))
+        case CBOR_UNSIGNED:
+            item->type = cJSON_Number;
+            if (argument > (cjson_uint64)CJSON_INT64_MAX)
             {
-                return true;
+                cJSON_SetNumberHelper(item, (double)argument);
             }
-            return false;
+            else
+            {
+                set_int64(item, (cJSON_int64)argument);
+            }
+            return true;
 
-        case cJSON_String:
-        case cJSON_Raw:
-            if ((a->valuestring == NULL) || (b->valuestring == NULL))
+        case CBOR_NEGATIVE:
+            item->type = cJSON_Number;
+            if (argument > (cjson_uint64)CJSON_INT64_MAX)
             {
-                return false;
+                cJSON_SetNumberHelper(item, -1.0 - (double)argument);
             }
-            if (strcmp(a->valuestring, b->valuestring) == 0)
+            else
             {
-                return true;
+                set_int64(item, -1 - (cJSON_int64)argument);
             }
+            return true;
 
-            return false;
+        case CBOR_TEXT:
+            item->type = cJSON_String;
+            return cbor_read_text(input, info, argument, &item->valuestring);
 
-        case cJSON_Array:
-        {
-            cJSON *a_element = a->child;
-            cJSON *b_element = b->child;
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            return cbor_decode_container(item, input, major, info, argument);
 
-            for (; (a_element != NULL) && (b_element != NULL);)
+        case CBOR_SIMPLE:
+            switch (info)
             {
-                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                case CBOR_FALSE:
+                    item->type = cJSON_False;
+                    return true;
+
+                case CBOR_TRUE:
+                    item->type = cJSON_True;
+                    return true;
+
+                case CBOR_NULL:
+                case CBOR_UNDEFINED:
+                    item->type = cJSON_NULL;
+                    return true;
+
+                case CBOR_HALF:
+                    item->type = cJSON_Number;
+                    cJSON_SetNumberHelper(item, cbor_half_to_double(argument));
+                    return true;
+
+                case CBOR_SINGLE:
+                    item->type = cJSON_Number;
+                    cJSON_SetNumberHelper(item, cbor_single_to_double(argument));
+                    return true;
+
+                case CBOR_DOUBLE:
                 {
-                    return false;
+                    double number = 0;
+                    memcpy(&number, &argument, sizeof(number));
+                    item->type = cJSON_Number;
+                    cJSON_SetNumberHelper(item, number);
+                    return true;
                 }
 
-                a_element = a_element->next;
-                b_element = b_element->next;
+                default:
+                    return false;
             }
 
-            /* one of the arrays is longer than the other */
-            if (a_element != b_element) {
-                return false;
-            }
+        default:
+            /* byte strings have no JSON equivalent */
+            return false;
+    }
+}
 
-            return true;
-        }
+CJSON_PUBLIC(cJSON *) cJSON_DecodeCBOR(const unsigned char *data, size_t length, size_t *consumed)
+{
+    cbor_buffer input = { NULL, 0, 0, 0 };
+    cJSON *item = NULL;
 
-        case cJSON_Object:
-        {
-            cJSON *a_element = NULL;
-            cJSON *b_element = NULL;
-            cJSON_ArrayForEach(a_element, a)
-            {
-                /* TODO This has O(n^2) runtime, which is horrible! */
-                b_element = get_object_item(b, a_element->string, case_sensitive);
-                if (b_element == NULL)
-                {
-                    return false;
-                }
+    if (data == NULL)
+    {
+        return NULL;
+    }
 
-                if (!cJSON_Compare(a_element, b_element, case_sensitive))
-                {
-                    return false;
-                }
-            }
+    input.content = data;
+    input.length = length;
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL)
+    {
+        return NULL;
+    }
+    if (!cbor_decode_value(item, &input))
+    {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    if (consumed != NULL)
+    {
+        *consumed = input.offset;
+    }
 
-            /* doing this twice, once on a and b to prevent true comparison if a subset of b
-             * TODO: Do this the proper way, this is just a fix for now */
-            cJSON_ArrayForEach(b_element, b)
-            {
-                a_element = get_object_item(a, b_element->string, case_sensitive);
-                if (a_element == NULL)
-                {
-                    return false;
-                }
+    return item;
+}
 
-                if (!cJSON_Compare(b_element, a_element, case_sensitive))
-                {
-                    return false;
-                }
-            }
+CJSON_PUBLIC(int) cJSON_DecodeCBORFrame(const unsigned char *data, size_t length, size_t *consumed, cJSON **item)
+{
+    size_t frame_length = 0;
+    size_t used = 0;
+    size_t i = 0;
 
-            return true;
-        }
+    if ((data == NULL) || (item == NULL))
+    {
+        return -1;
+    }
+    *item = NULL;
+    if (length < CJSON_CBOR_FRAME_HEADER)
+    {
+        return 0;
+    }
 
-        default:
-            return false;
+    for (i = 0; i < CJSON_CBOR_FRAME_HEADER; i++)
+    {
+        frame_length = (frame_length << 8) | data[i];
+    }
+    if (frame_length > (length - CJSON_CBOR_FRAME_HEADER))
+    {
+        return 0;
     }
+
+    /* the item has to fill the frame exactly */
+    *item = cJSON_DecodeCBOR(data + CJSON_CBOR_FRAME_HEADER, frame_length, &used);
+    if ((*item != NULL) && (used != frame_length))
+    {
+        cJSON_Delete(*item);
+        *item = NULL;
+    }
+    if (*item == NULL)
+    {
+        return -1;
+    }
+    if (consumed != NULL)
+    {
+        *consumed = CJSON_CBOR_FRAME_HEADER + frame_length;
+    }
+
+    return 1;
 }
 
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size)
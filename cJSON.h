@@ -99,6 +99,15 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
 
+/* 64 bit integer for numbers that don't fit into a double exactly */
+#if defined(_MSC_VER)
+typedef __int64 cJSON_int64;
+#elif defined(__GNUC__)
+__extension__ typedef long long cJSON_int64;
+#else
+typedef long long cJSON_int64;
+#endif
+
 /* The cJSON structure: */
 typedef struct cJSON
 {
@@ -110,16 +119,27 @@ typedef struct cJSON
 
     /* The type of the item, as above. */
     int type;
+    /* Internal bookkeeping about how the item was allocated. Managed by cJSON, don't modify. */
+    int internalflags;
 
     /* The item's string, if type==cJSON_String  and type == cJSON_Raw */
     char *valuestring;
     /* writing to valueint is DEPRECATED, use cJSON_SetNumberValue instead */
     int valueint;
+    /* Number of items in the child list of an array or object. Kept up to date by all cJSON functions,
+     * so fix it up if you link children by hand. References don't have one, use cJSON_GetArraySize. */
+    int childcount;
     /* The item's number, if type==cJSON_Number */
     double valuedouble;
+    /* The item's number as a 64 bit integer, exact if cJSON_IsInt64 and saturated like valueint otherwise.
+     * Change it with cJSON_SetInt64Value. */
+    cJSON_int64 valueint64;
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Lookup index (child vector, key hash table) of an array or object, see cJSON_BuildIndex. Managed by cJSON, don't modify. */
+    struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -137,6 +157,17 @@ typedef int cJSON_bool;
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* cJSON_BuildIndex gives arrays and objects with at least this many items a child vector for access by index,
+ * and objects a hash table for case sensitive lookups. Below that a linear walk is cheaper. */
+#ifndef CJSON_INDEX_THRESHOLD
+#define CJSON_INDEX_THRESHOLD 16
+#endif
+
+/* Arrays smaller than this many bytes are always parsed on one thread by cJSON_ParseParallel. */
+#ifndef CJSON_PARALLEL_THRESHOLD
+#define CJSON_PARALLEL_THRESHOLD 262144
+#endif
+
 /* Limits the length of circular references can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_CIRCULAR_LIMIT
@@ -149,6 +180,38 @@ CJSON_PUBLIC(const char*) cJSON_Version(void);
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
 
+/* Node pool: when enabled, cJSON items (80 bytes each on 64 bit systems) are carved out of slabs and cJSON_Delete
+ * puts them on a free list for the next parse instead of handing them back to free_fn.
+ * Only items are pooled, keys and string values still come from malloc_fn every time (cJSON_ParseInto reuses
+ * those as well). Like the hooks, the pool is global and not thread safe. */
+typedef struct cJSON_PoolStats
+{
+    size_t slab_allocations; /* slabs requested from malloc_fn */
+    size_t item_allocations; /* items requested from malloc_fn directly (pool disabled) */
+    size_t string_allocations; /* keys, string values and long number literals requested from malloc_fn
+                                * (not counted for cJSON_ParseWithContext and the workers of cJSON_ParseParallel) */
+    size_t pool_allocations; /* items handed out by the pool */
+    size_t pool_releases;    /* items returned to the pool */
+    size_t items_in_use;     /* pooled items that are currently alive */
+    size_t items_free;       /* pooled items waiting on the free list */
+} cJSON_PoolStats;
+
+CJSON_PUBLIC(void) cJSON_EnableNodePool(cJSON_bool enable);
+CJSON_PUBLIC(void) cJSON_GetPoolStats(cJSON_PoolStats *stats);
+/* Return all slabs to free_fn. Fails and returns 0 while pooled items are still alive. */
+CJSON_PUBLIC(cJSON_bool) cJSON_ReleaseNodePool(void);
+
+/* Arena: trees parsed into one (see cJSON_ParseContext) live in a few big blocks and are released together in O(1),
+ * without walking them. cJSON_Delete leaves arena items alone. Adding, inserting or replacing items of an arena tree
+ * with items that aren't from an arena fails, as they would never be released. Arena items can't take new keys or
+ * strings that are longer than their old ones. */
+typedef struct cJSON_Arena cJSON_Arena;
+/* block_size 0 means CJSON_ARENA_BLOCK_SIZE. The blocks come from the hooks. */
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t block_size);
+/* Release every tree in the arena at once, its blocks are kept for the next ones. */
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena);
+
 /* Memory Management: the caller is always responsible to free the results from all variants of cJSON_Parse (with cJSON_Delete) and cJSON_Print (with stdlib free, cJSON_Hooks.free_fn, or cJSON_free as appropriate). The exception is cJSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value);
@@ -157,6 +220,202 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Parse newline delimited JSON, one document per line, straight out of buffer without copying or strlen.
+ * callback gets each document and owns it (free it with cJSON_Delete), or NULL and the line if the line isn't valid
+ * JSON, cJSON_GetErrorPtr() then points at the error in the line. Blank lines are skipped. Return 0 from the callback to stop after that line.
+ * Returns the number of bytes used up, which ends after the newline of the last line that was handed over.
+ * Text after the last newline is an incomplete line: pass it again once the rest has arrived. */
+typedef cJSON_bool (*cJSON_ParseManyCallback)(cJSON *item, const char *line, size_t length, void *user);
+CJSON_PUBLIC(size_t) cJSON_ParseMany(const char *buffer, size_t length, cJSON_ParseManyCallback callback, void *user);
+/* Lazy parse for documents of which only a few parts are read: arrays and objects inside the document are only
+ * skimmed for their end, and parsed one level at a time the first time something looks into them (the getters,
+ * cJSON_ArrayForEach, printing, comparing, ...). Whatever isn't looked at is never allocated.
+ * value has to stay unchanged as long as the tree has unparsed parts. Errors inside a skimmed array/object show up
+ * when it is parsed: it then looks empty and printing it fails. Reading a lazy tree changes it, so threads can't
+ * share one without a lock. Code that walks item->child by hand has to go through cJSON_GetChild. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseLazy(const char *value, size_t buffer_length);
+/* Parse into the items and strings of tree, a tree from an earlier parse that isn't needed anymore, e.g. the last
+ * event of a stream. Items are reused in the order they were parsed and strings wherever the new one fits, so a
+ * document of the same shape doesn't allocate at all. Parts the new document doesn't need are freed.
+ * tree is used up either way, even if parsing fails (returns NULL), and must not be part of another array/object.
+ * A tree in an arena is left to its arena. Trees are freed and allocated with the global hooks, use
+ * cJSON_ParseIntoWithContext for a tree from a parse context. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInto(cJSON *tree, const char *value, size_t buffer_length);
+/* Parse a big document on up to threads threads: the elements of its biggest array (e.g. all windows of an event)
+ * are split up between them. Documents without an array of at least CJSON_PARALLEL_THRESHOLD bytes are parsed like
+ * cJSON_ParseWithLength. Threads are only used if cJSON was built with ENABLE_THREADS (and -pthread), the hooks have
+ * to be thread safe then. The result is the same tree cJSON_ParseWithLength gives. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseParallel(const char *value, size_t buffer_length, unsigned int threads);
+
+/* The functions above report errors through cJSON_GetErrorPtr, which is shared by all threads. A parse context
+ * keeps everything about one parse with the caller instead: the allocator and options going in and the position
+ * coming out. Parsing with a context doesn't touch the global hooks, error or node pool, so every thread can parse
+ * with its own context at the same time. */
+typedef struct cJSON_ParseContext
+{
+    /* allocator for the tree, NULL functions mean malloc/free. Delete the tree with cJSON_DeleteWithContext. */
+    cJSON_Hooks hooks;
+    /* arrays/objects nested deeper than this are rejected, CJSON_NESTING_LIMIT at most */
+    size_t max_depth;
+    /* fail if anything but whitespace follows the document, up to the length or a null terminator */
+    cJSON_bool reject_trailing;
+    /* if set, the tree goes into this arena instead of being allocated with the hooks */
+    cJSON_Arena *arena;
+    /* set by the parse: where the document ended, or where the error is if it failed */
+    size_t position;
+} cJSON_ParseContext;
+
+/* Default options: malloc/free, CJSON_NESTING_LIMIT, trailing text is allowed and no arena. */
+CJSON_PUBLIC(void) cJSON_InitParseContext(cJSON_ParseContext *context);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithContext(cJSON_ParseContext *context, const char *value, size_t buffer_length);
+/* cJSON_ParseInto with the hooks and options of context, for a tree that was parsed with the same hooks. With an
+ * arena in context the new tree goes into the arena and tree is only released. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseIntoWithContext(cJSON_ParseContext *context, cJSON *tree, const char *value, size_t buffer_length);
+CJSON_PUBLIC(void) cJSON_DeleteWithContext(const cJSON_ParseContext *context, cJSON *item);
+
+/* Incremental parser for newline delimited JSON that is fed input in chunks as it arrives, e.g. from read().
+ * Only strings and numbers that are split between chunks are buffered, the tree is built as the input comes in. */
+typedef struct cJSON_Stream cJSON_Stream;
+#define cJSON_StreamNeedMore 0 /* all input was consumed without completing a line */
+#define cJSON_StreamDocument 1 /* a newline completed a document */
+#define cJSON_StreamInvalid  2 /* a line wasn't valid JSON and has been skipped */
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(void);
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream);
+/* Parse up to length bytes of chunk and set *consumed to the number of bytes used. Stops at the end of a line,
+ * so call again with the remaining bytes. On cJSON_StreamDocument *document is set, free it with cJSON_Delete. */
+CJSON_PUBLIC(int) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length, size_t *consumed, cJSON **document);
+/* Position in its line at which the last invalid line was rejected. */
+CJSON_PUBLIC(size_t) cJSON_StreamErrorPosition(const cJSON_Stream *stream);
+
+/* Pull tokenizer that walks JSON text one token at a time without building a tree or allocating.
+ * Tokens point into the input, so it has to outlive them. Stop calling cJSON_ReaderNext whenever you are done. */
+#define cJSON_TokenError       0 /* invalid JSON, see cJSON_Reader.error_position */
+#define cJSON_TokenEnd         1 /* the document is complete */
+#define cJSON_TokenObjectStart 2
+#define cJSON_TokenObjectEnd   3
+#define cJSON_TokenArrayStart  4
+#define cJSON_TokenArrayEnd    5
+#define cJSON_TokenKey         6
+#define cJSON_TokenString      7
+#define cJSON_TokenNumber      8
+#define cJSON_TokenTrue        9
+#define cJSON_TokenFalse      10
+#define cJSON_TokenNull       11
+
+typedef struct cJSON_Token
+{
+    int type;
+    /* text of the token in the input. Strings and keys are without quotes and still escaped. */
+    const char *text;
+    size_t length;
+    /* a string or key contains escape sequences, so text can't be used verbatim */
+    cJSON_bool escaped;
+} cJSON_Token;
+
+/* A piece of JSON text that is split up in memory, see cJSON_InitSegmentReader */
+typedef struct cJSON_Segment
+{
+    const char *data;
+    size_t length;
+} cJSON_Segment;
+
+typedef struct cJSON_Reader
+{
+    /* the part of the input that is being read, a segment or tokens copied together from several */
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    /* number of arrays/objects that are open at the current position */
+    size_t depth;
+    int state;
+    size_t error_position;
+    /* one bit per nesting level, set for objects */
+    unsigned char containers[(CJSON_NESTING_LIMIT + 7) / 8];
+    /* segmented input: the segments, where the input after content continues and the position of content in it */
+    const cJSON_Segment *segments;
+    size_t segment_count;
+    size_t segment;
+    size_t segment_offset;
+    size_t position;
+    unsigned char *scratch;
+    size_t scratch_size;
+} cJSON_Reader;
+
+CJSON_PUBLIC(void) cJSON_InitReader(cJSON_Reader *reader, const char *json, size_t length);
+/* Read a document that is split into count segments, e.g. the two halves of a ring buffer or consecutive reads,
+ * without copying it together. Tokens that span segments are copied into a buffer from the hooks and are only valid
+ * until the next call, the others point into the segments, which have to stay unchanged while reading.
+ * error_position counts from the start of the first segment. Free the buffer with cJSON_ReaderRelease. */
+CJSON_PUBLIC(void) cJSON_InitSegmentReader(cJSON_Reader *reader, const cJSON_Segment *segments, size_t count);
+CJSON_PUBLIC(void) cJSON_ReaderRelease(cJSON_Reader *reader);
+/* Returns the type of the next token and fills in token. */
+CJSON_PUBLIC(int) cJSON_ReaderNext(cJSON_Reader *reader, cJSON_Token *token);
+/* Skip the next value, e.g. the one after a key that isn't interesting. If the current array/object has
+ * no values left, its end is consumed instead. Returns 0 on invalid JSON. */
+CJSON_PUBLIC(cJSON_bool) cJSON_ReaderSkip(cJSON_Reader *reader);
+/* Compare a string or key token with a null terminated string, taking escape sequences into account. */
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenEquals(const cJSON_Token *token, const char *string);
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenToNumber(const cJSON_Token *token, double *number);
+/* Exact for integer literals that fit into 64 bits, saturated like cJSON_GetInt64Value otherwise. */
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenToInt64(const cJSON_Token *token, cJSON_int64 *number);
+/* Unescape a string or key token into buffer and null terminate it. Returns 0 if it doesn't fit. */
+CJSON_PUBLIC(cJSON_bool) cJSON_TokenCopyString(const cJSON_Token *token, char *buffer, size_t size);
+/* Callback flavour: calls callback for every token with the depth after it. Returning 0 from the callback stops early.
+ * Returns 0 if invalid JSON was encountered. */
+typedef cJSON_bool (*cJSON_TokenCallback)(const cJSON_Token *token, size_t depth, void *user_data);
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseTokens(const char *json, size_t length, cJSON_TokenCallback callback, void *user_data);
+/* Check that the length bytes of json are exactly one valid document, without building a tree or allocating. A null
+ * byte within length is invalid. On failure error_offset (which may be NULL) gets the position of the first invalid
+ * byte. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Validate(const char *json, size_t length, size_t *error_offset);
+
+/* Decoding into C structs: a table of fields says where the members of an object go, and the reader fills them in
+ * without building a tree. Values of the wrong type and unknown members are skipped. */
+#define cJSON_FieldInt         1 /* int, saturated like valueint */
+#define cJSON_FieldDouble      2 /* double */
+#define cJSON_FieldBool        3 /* cJSON_bool */
+#define cJSON_FieldString      4 /* char *, allocated with the hooks */
+#define cJSON_FieldStringArray 5 /* char ** allocated with the hooks, non-string elements are left out */
+#define cJSON_FieldObject      6 /* nested struct, decoded with its own table */
+#define cJSON_FieldInt64       7 /* cJSON_int64, exact for integer literals */
+
+/* Limit on the number of fields in a table, one bit each in the found mask */
+#ifndef CJSON_DECODE_MAX_FIELDS
+#define CJSON_DECODE_MAX_FIELDS 32
+#endif
+
+typedef struct cJSON_Field
+{
+    /* member name, or names separated by '.' to reach into nested objects */
+    const char *path;
+    int type;
+    /* where the value goes in the struct, use offsetof */
+    size_t offset;
+    /* cJSON_FieldStringArray: offset of the int that receives the number of strings */
+    size_t count_offset;
+    /* cJSON_FieldObject: table of the nested struct */
+    const struct cJSON_Field *fields;
+} cJSON_Field;
+
+/* Decode the next value of the reader into target using a table ending in an entry with a NULL path.
+ * Strings already in target are replaced, so it has to start out zeroed (or hold earlier results).
+ * Bit i of found is set if fields[i] was filled in, found may be NULL. Returns 0 on invalid JSON or if an allocation
+ * failed, what was decoded up to then stays in target. */
+CJSON_PUBLIC(cJSON_bool) cJSON_DecodeObject(cJSON_Reader *reader, const cJSON_Field *fields, void *target, unsigned long *found);
+CJSON_PUBLIC(cJSON_bool) cJSON_Decode(const char *json, size_t length, const cJSON_Field *fields, void *target, unsigned long *found);
+/* Free the strings decoded into target and reset them to NULL. */
+CJSON_PUBLIC(void) cJSON_FreeDecoded(const cJSON_Field *fields, void *target);
+
+/* A set of JSON pointers (RFC 6901, e.g. "/KeyboardLayoutSwitched/idx") compiled once and then run over many documents.
+ * Only the values they point at are parsed into trees, everything else is skipped by the reader without allocating. */
+typedef struct cJSON_Query cJSON_Query;
+/* Returns NULL if a pointer is invalid or appears twice. */
+CJSON_PUBLIC(cJSON_Query *) cJSON_CompileQueries(const char * const *pointers, size_t count);
+CJSON_PUBLIC(void) cJSON_DeleteQuery(cJSON_Query *query);
+/* results needs room for count items, results[i] gets the value pointers[i] points at or NULL if there is none.
+ * Delete them with cJSON_Delete. Reading stops as soon as every pointer matched, so the rest of the document isn't
+ * checked. Returns 0 on invalid JSON or if an allocation failed, results are all NULL then. */
+CJSON_PUBLIC(cJSON_bool) cJSON_RunQueries(const cJSON_Query *query, const char *json, size_t length, cJSON **results);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -165,25 +424,118 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt);
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
-/* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
+/* NOTE: cJSON_PrintedLength(item, format) + 1 bytes are exactly enough. */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
+/* Number of characters cJSON_Print (format=1) or cJSON_PrintUnformatted (format=0) produce, without the null terminator.
+ * Returns 0 if the item can't be printed, and for an empty raw item. */
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format);
+/* A printer keeps its output buffer between calls, so printing many documents doesn't allocate once it is big enough.
+ * The returned text belongs to the printer and stays valid until its next print. length may be NULL. */
+typedef struct cJSON_Printer cJSON_Printer;
+CJSON_PUBLIC(cJSON_Printer *) cJSON_CreatePrinter(void);
+CJSON_PUBLIC(void) cJSON_DeletePrinter(cJSON_Printer *printer);
+CJSON_PUBLIC(const char *) cJSON_PrinterPrint(cJSON_Printer *printer, const cJSON *item, cJSON_bool format, size_t *length);
+/* Streaming writer that renders JSON straight into a buffer, without building a tree first. Output is the same as
+ * cJSON_Print (format=1) or cJSON_PrintUnformatted (format=0) would give for the equivalent tree.
+ * Pass a buffer to write into it, or NULL to let the writer allocate one that grows as needed (release it with
+ * cJSON_FreeWriter). Every call returns 0 once something failed: misuse such as a value without a key inside an
+ * object, or running out of space. */
+typedef struct cJSON_Writer
+{
+    char *buffer;
+    size_t length;
+    /* number of characters written, the buffer is always null terminated */
+    size_t offset;
+    /* number of arrays/objects that are open */
+    size_t depth;
+    cJSON_bool format;
+    /* the buffer was allocated by the writer and is grown as needed */
+    cJSON_bool growable;
+    /* the current array/object (or the document) has a value already */
+    cJSON_bool has_values;
+    /* a key was written and waits for its value */
+    cJSON_bool after_key;
+    cJSON_bool failed;
+    /* writing CBOR instead of JSON (see cJSON_InitCBORWriter) */
+    cJSON_bool cbor;
+    /* the first 4 bytes are reserved for the frame length */
+    cJSON_bool framed;
+    /* one bit per nesting level, set for objects */
+    unsigned char containers[(CJSON_NESTING_LIMIT + 7) / 8];
+} cJSON_Writer;
+
+CJSON_PUBLIC(void) cJSON_InitWriter(cJSON_Writer *writer, char *buffer, size_t length, cJSON_bool format);
+/* Same calls, but the writer emits CBOR (RFC 8949) with indefinite length arrays/objects. With framed=1 the output
+ * starts with the frame length like cJSON_EncodeCBOR gives it. cJSON_WriteRaw fails on a CBOR writer. */
+CJSON_PUBLIC(void) cJSON_InitCBORWriter(cJSON_Writer *writer, char *buffer, size_t length, cJSON_bool framed);
+/* Start over with the next document, keeping the buffer. */
+CJSON_PUBLIC(void) cJSON_ResetWriter(cJSON_Writer *writer);
+CJSON_PUBLIC(void) cJSON_FreeWriter(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteObjectStart(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteObjectEnd(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteArrayStart(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteArrayEnd(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteKey(cJSON_Writer *writer, const char *key);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteString(cJSON_Writer *writer, const char *string);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNumber(cJSON_Writer *writer, double number);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteInt64(cJSON_Writer *writer, cJSON_int64 number);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteBool(cJSON_Writer *writer, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteNull(cJSON_Writer *writer);
+/* Write already rendered JSON text as a value, it is not checked. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteRaw(cJSON_Writer *writer, const char *json);
+/* Write an existing tree as a value. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriteItem(cJSON_Writer *writer, const cJSON *item);
+/* The document, once it is complete and nothing failed. NULL otherwise. length may be NULL. */
+CJSON_PUBLIC(const char *) cJSON_WriterOutput(const cJSON_Writer *writer, size_t *length);
+
+/* CBOR (RFC 8949), a binary encoding of the same data that is smaller and much cheaper to read than JSON text.
+ * Integers are written in their shortest form, other numbers as float32 where that is exact and float64 otherwise.
+ * Raw items can't be encoded. A frame is a 4 byte big endian length followed by one encoded item, so items can
+ * be sent back to back over a stream. */
+#define CJSON_CBOR_FRAME_HEADER 4
+/* Encoded item in memory from cJSON_malloc, NULL on failure. With framed=1 it starts with the frame length. */
+CJSON_PUBLIC(unsigned char *) cJSON_EncodeCBOR(const cJSON *item, cJSON_bool framed, size_t *length);
+/* Decode one item from the start of data, consumed (may be NULL) is set to the number of bytes it took up.
+ * Accepts indefinite lengths, half/single/double floats and tags (which are ignored). Byte strings, text
+ * containing NUL bytes and non-string map keys can't be represented and are rejected. */
+CJSON_PUBLIC(cJSON *) cJSON_DecodeCBOR(const unsigned char *data, size_t length, size_t *consumed);
+/* Decode the frame at the start of data. Returns 1 and sets item and consumed once the frame is complete,
+ * 0 if more data is needed and -1 if the frame is invalid. */
+CJSON_PUBLIC(int) cJSON_DecodeCBORFrame(const unsigned char *data, size_t length, size_t *consumed, cJSON **item);
+
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
-/* Returns the number of items in an array (or object). */
+/* Returns the number of items in an array (or object) in constant time, references (see cJSON_IsReference) count them. */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array);
+/* First element of an array (or object), NULL if it is empty. Parses it first if it is lazy, see cJSON_ParseLazy. */
+CJSON_PUBLIC(cJSON *) cJSON_GetChild(const cJSON *item);
 /* Retrieve item number "index" from array "array". Returns NULL if unsuccessful. */
 CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 /* Get item "string" from object. Case insensitive. */
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Hash a key of the given length for cJSON_GetObjectItemByHash. Compute this once for keys that are looked up repeatedly. */
+CJSON_PUBLIC(unsigned int) cJSON_HashKey(const char *key, size_t length);
+/* Case sensitive lookup of a key that doesn't need to be null terminated. hash has to be cJSON_HashKey(key, length). */
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemByHash(const cJSON * const object, const char *key, size_t length, unsigned int hash);
+/* Index item and every array/object in it that has at least CJSON_INDEX_THRESHOLD items, so that cJSON_GetArrayItem
+ * and case sensitive lookups of keys don't walk them anymore. Without an index they do, lookups never build one, so
+ * threads can share a tree for reading either way. The cJSON functions that add, remove or replace items keep the
+ * index up to date, but an array/object that was too small to be indexed doesn't get an index as it grows: call
+ * cJSON_BuildIndex again for that.
+ * References, unparsed parts of a lazy tree and arena items are left out. Returns 0 if an allocation failed, what
+ * couldn't be indexed is walked. */
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *item);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
 /* Check item type and return its value */
 CJSON_PUBLIC(char *) cJSON_GetStringValue(const cJSON * const item);
 CJSON_PUBLIC(double) cJSON_GetNumberValue(const cJSON * const item);
+/* Exact if cJSON_IsInt64, otherwise valuedouble saturated to the 64 bit range. 0 if item isn't a number. */
+CJSON_PUBLIC(cJSON_int64) cJSON_GetInt64Value(const cJSON * const item);
 
 /* These functions check the type of an item */
 CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item);
@@ -192,6 +544,9 @@ CJSON_PUBLIC(cJSON_bool) cJSON_IsTrue(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsBool(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsNull(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsNumber(const cJSON * const item);
+/* A number parsed from an integer literal that fits into 64 bits or set with cJSON_SetInt64Value/cJSON_CreateInt64.
+ * valueint64 holds its exact value and it is printed from there. */
+CJSON_PUBLIC(cJSON_bool) cJSON_IsInt64(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item);
@@ -203,6 +558,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean);
 CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num);
+CJSON_PUBLIC(cJSON *) cJSON_CreateInt64(cJSON_int64 num);
 CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string);
 /* raw json */
 CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw);
@@ -259,12 +615,29 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse);
 /* Recursively compare two cJSON items for equality. If either a or b is NULL or invalid, they will be considered unequal.
  * case_sensitive determines if object keys are treated case sensitive (1) or case insensitive (0) */
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive);
+/* JSON Patch (RFC 6902) that turns from into to, as an array of operations to delete with cJSON_Delete.
+ * If key isn't NULL, arrays whose elements are all objects with a unique string or number member of that name
+ * (e.g. "id") are matched by it, so elements that moved or changed give move operations and changes inside them
+ * instead of a replacement of everything after the first difference. Returns NULL if an allocation failed. */
+CJSON_PUBLIC(cJSON *) cJSON_Diff(const cJSON *from, const cJSON *to, const char *key);
 
 /* Minify a strings, remove blank characters(such as ' ', '\t', '\r', '\n') from strings.
  * The input pointer json cannot point to a read-only address area, such as a string constant, 
  * but should point to a readable and writable address area. */
 CJSON_PUBLIC(void) cJSON_Minify(char *json);
 
+/* Minifier that is fed the text in chunks, e.g. to compact a large file without loading it whole.
+ * Strings and comments may be split between chunks, the minifier keeps track of them. */
+typedef struct cJSON_Minifier
+{
+    int state;
+} cJSON_Minifier;
+
+CJSON_PUBLIC(void) cJSON_InitMinifier(cJSON_Minifier *minifier);
+/* Minify length bytes of input into output, which needs room for length bytes and may be input itself.
+ * Returns the number of bytes written, the output is not null-terminated. */
+CJSON_PUBLIC(size_t) cJSON_MinifyChunk(cJSON_Minifier *minifier, const char *input, size_t length, char *output);
+
 /* Helper functions for creating and adding items to an object at the same time.
  * They return the added item or NULL on failure. */
 CJSON_PUBLIC(cJSON*) cJSON_AddNullToObject(cJSON * const object, const char * const name);
@@ -272,6 +645,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddTrueToObject(cJSON * const object, const char * co
 CJSON_PUBLIC(cJSON*) cJSON_AddFalseToObject(cJSON * const object, const char * const name);
 CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObject(cJSON * const object, const char * const name, const cJSON_bool boolean);
 CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObject(cJSON * const object, const char * const name, const double number);
+CJSON_PUBLIC(cJSON*) cJSON_AddInt64ToObject(cJSON * const object, const char * const name, const cJSON_int64 number);
 CJSON_PUBLIC(cJSON*) cJSON_AddStringToObject(cJSON * const object, const char * const name, const char * const string);
 CJSON_PUBLIC(cJSON*) cJSON_AddRawToObject(cJSON * const object, const char * const name, const char * const raw);
 CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char * const name);
@@ -282,6 +656,8 @@ CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * c
 /* helper for the cJSON_SetNumberValue macro */
 CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number);
 #define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (double)number) : (number))
+/* Set all number fields from a 64 bit integer, valuedouble gets the nearest double. */
+CJSON_PUBLIC(cJSON_int64) cJSON_SetInt64Value(cJSON *object, cJSON_int64 number);
 /* Change the valuestring of a cJSON_String object, only takes effect when type of object is cJSON_String */
 CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring);
 
@@ -293,7 +669,7 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 )
 
 /* Macro for iterating over an array or object */
-#define cJSON_ArrayForEach(element, array) for(element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+#define cJSON_ArrayForEach(element, array) for(element = (array != NULL) ? cJSON_GetChild(array) : NULL; element != NULL; element = element->next)
 
 /* malloc/free objects using the malloc/free functions that have been set with cJSON_InitHooks */
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size);
@@ -1,4 +1,5 @@
 #include "cJSON.h"
+#include "niri_events.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,21 +24,20 @@
 
 #define ERROR -1
 
+// Malformed events are counted but only the first few and then every
+// INVALID_LOG_INTERVAL-th are logged, cut down to the text around the error
+#define INVALID_LOG_FIRST 10
+#define INVALID_LOG_INTERVAL 1000
+#define INVALID_LOG_EXCERPT 64
+
 typedef enum { STATE_WAITING, STATE_LAYOUT_INIT, STATE_RECEIVING } state;
 
 typedef struct {
   state s;
-  char **layouts;
-  int n;           // number of layouts
-  int current_idx; // index of current layout
+  niri_keyboard_layouts_t layouts;
+  unsigned long invalid_lines;
 } program_state_t;
 
-typedef struct {
-  char *buf;
-  size_t len;
-  size_t capacity;
-} line_buffer_t;
-
 static void send_notification(char *message) {
   if (message == NULL) {
     DO_LOG_ERROR("Message can not be NULL");
@@ -78,129 +78,236 @@ finish:
   return;
 }
 
-static void process_line(char *line, program_state_t *ps) {
-  cJSON *root;
-  if (!(root = cJSON_Parse(line))) {
-    DO_LOG_ERROR("Invalid JSON format: %s", line);
-    goto cleanup;
+// Reads go into fixed size chunks. A line that continues in the next read
+// keeps its chunks and is read from them as segments, so it is never copied
+// together and no buffer has to grow to the size of the largest event.
+#define READ_CHUNK_SIZE 4096
+
+typedef struct read_chunk {
+  struct read_chunk *next;
+  char data[READ_CHUNK_SIZE];
+} read_chunk_t;
+
+typedef struct {
+  // pieces of the line so far
+  cJSON_Segment *segments;
+  size_t n_segments;
+  size_t capacity;
+  // chunks the pieces point into, and one to read into next
+  read_chunk_t *held;
+  read_chunk_t *spare;
+} pending_line_t;
+
+static int pending_line_add(pending_line_t *pl, const char *data, size_t len) {
+  if (len == 0) {
+    return 0;
+  }
+  if (pl->n_segments == pl->capacity) {
+    size_t capacity = pl->capacity ? 2 * pl->capacity : 8;
+    cJSON_Segment *segments =
+        realloc(pl->segments, capacity * sizeof(cJSON_Segment));
+    if (!segments) {
+      DO_LOG_ERRNO("realloc");
+      return ERROR;
+    }
+    pl->segments = segments;
+    pl->capacity = capacity;
   }
+  pl->segments[pl->n_segments].data = data;
+  pl->segments[pl->n_segments].length = len;
+  pl->n_segments++;
+  return 0;
+}
 
-  switch (ps->s) {
-  case STATE_WAITING: {
-    cJSON *ok_obj;
-    if (!(ok_obj = cJSON_GetObjectItemCaseSensitive(root, "Ok"))) {
-      goto cleanup;
+static read_chunk_t *pending_line_take_chunk(pending_line_t *pl) {
+  read_chunk_t *chunk = pl->spare;
+  if (chunk) {
+    pl->spare = NULL;
+    return chunk;
+  }
+  if (!(chunk = malloc(sizeof(read_chunk_t)))) {
+    DO_LOG_ERRNO("malloc");
+  }
+  return chunk;
+}
+
+// Forget the line, only one of its chunks is kept for the next read
+static void pending_line_clear(pending_line_t *pl) {
+  pl->n_segments = 0;
+  while (pl->held) {
+    read_chunk_t *chunk = pl->held;
+    pl->held = chunk->next;
+    if (pl->spare) {
+      free(chunk);
+    } else {
+      pl->spare = chunk;
     }
-    ps->s = STATE_LAYOUT_INIT;
-    break;
   }
-  case STATE_LAYOUT_INIT: {
-    cJSON *obj;
-    if (!(obj = cJSON_GetObjectItemCaseSensitive(root,
-                                                 "KeyboardLayoutsChanged"))) {
-      goto cleanup;
+}
+
+static void pending_line_free(pending_line_t *pl) {
+  pending_line_clear(pl);
+  free(pl->spare);
+  free(pl->segments);
+}
+
+static void on_keyboard_layouts_changed(niri_keyboard_layouts_changed_t *event,
+                                        program_state_t *ps) {
+  // Take over the decoded layouts, the current layout stays if it's missing
+  int current_idx = ps->layouts.current_idx;
+  niri_free_keyboard_layouts(&ps->layouts);
+  ps->layouts = event->keyboard_layouts;
+  if (!ps->layouts.has_current_idx) {
+    ps->layouts.current_idx = current_idx;
+  }
+  memset(&event->keyboard_layouts, 0, sizeof(event->keyboard_layouts));
+}
+
+static void on_keyboard_layout_switched(niri_keyboard_layout_switched_t *event,
+                                        program_state_t *ps) {
+  niri_keyboard_layouts_t *layouts = &ps->layouts;
+  if (event->has_idx && event->idx >= 0 && event->idx < layouts->n_names &&
+      layouts->current_idx != event->idx) {
+    layouts->current_idx = event->idx;
+    send_notification(layouts->names[layouts->current_idx]);
+  }
+}
+
+// Copy up to size bytes of a line in segments, starting at offset
+static size_t copy_excerpt(const cJSON_Segment *segments, size_t n_segments,
+                           size_t offset, char *out, size_t size) {
+  size_t copied = 0;
+  for (size_t i = 0; i < n_segments && copied < size; i++) {
+    if (offset >= segments[i].length) {
+      offset -= segments[i].length;
+      continue;
     }
-    ps->s = STATE_RECEIVING;
-    cJSON *keyboard_layouts =
-        cJSON_GetObjectItemCaseSensitive(obj, "keyboard_layouts");
-    cJSON *current_idx =
-        cJSON_GetObjectItemCaseSensitive(keyboard_layouts, "current_idx");
-    if (cJSON_IsNumber(current_idx)) {
-      ps->current_idx = current_idx->valueint;
+    size_t n = segments[i].length - offset;
+    if (n > size - copied) {
+      n = size - copied;
     }
-    cJSON *names = cJSON_GetObjectItemCaseSensitive(keyboard_layouts, "names");
-    if (cJSON_IsArray(names)) {
-      ps->layouts = calloc(cJSON_GetArraySize(names), sizeof(char *));
-      if (!ps->layouts) {
-        DO_LOG_ERRNO("calloc");
-        goto cleanup;
-      }
+    memcpy(out + copied, segments[i].data + offset, n);
+    copied += n;
+    offset = 0;
+  }
+  return copied;
+}
 
-      cJSON *name = NULL;
-      cJSON_ArrayForEach(name, names) {
-        if (cJSON_IsString(name)) {
-          char *layout = strdup(name->valuestring);
-          if (!layout) {
-            goto cleanup;
-          }
-          ps->layouts[ps->n] = layout;
-          ps->n++;
-        }
-      }
+static void report_invalid_line(const cJSON_Segment *segments,
+                                size_t n_segments, size_t offset,
+                                program_state_t *ps) {
+  char excerpt[INVALID_LOG_EXCERPT];
+  size_t len = 0;
+  ps->invalid_lines++;
+  if (ps->invalid_lines > INVALID_LOG_FIRST &&
+      ps->invalid_lines % INVALID_LOG_INTERVAL != 0) {
+    return;
+  }
+  for (size_t i = 0; i < n_segments; i++) {
+    len += segments[i].length;
+  }
+  size_t start =
+      offset > INVALID_LOG_EXCERPT / 2 ? offset - INVALID_LOG_EXCERPT / 2 : 0;
+  size_t n = copy_excerpt(segments, n_segments, start, excerpt,
+                          sizeof(excerpt));
+  DO_LOG_ERROR("Invalid JSON at byte %zu of %zu byte event (%lu so far): "
+               "%s%.*s%s",
+               offset, len, ps->invalid_lines, start > 0 ? "..." : "",
+               (int)n, excerpt, start + n < len ? "..." : "");
+}
+
+// Events are read token by token in place and decoded by the code generated
+// from niri_schema.h in one pass, events we don't know are skipped. No cJSON
+// trees are built, so the node pool and cJSON_Stream aren't used here, and
+// cJSON_Validate would need the line in one piece.
+static void process_line(const cJSON_Segment *segments, size_t n_segments,
+                         program_state_t *ps) {
+  cJSON_Reader reader;
+  cJSON_Token token;
+  niri_event_t event;
+
+  cJSON_InitSegmentReader(&reader, segments, n_segments);
+  if (!niri_read_event(&reader, &event)) {
+    // A reader that found invalid JSON keeps failing, otherwise the decoder
+    // ran out of memory
+    size_t error_position = reader.error_position;
+    if (cJSON_ReaderNext(&reader, &token) == cJSON_TokenError) {
+      report_invalid_line(segments, n_segments, error_position, ps);
+    } else {
+      DO_LOG_ERROR("Failed to decode event");
     }
-    break;
+    goto cleanup;
   }
-  case STATE_RECEIVING: {
-    cJSON *obj;
-    if (!(obj = cJSON_GetObjectItemCaseSensitive(root,
-                                                 "KeyboardLayoutSwitched"))) {
-      goto cleanup;
+
+  switch (event.type) {
+  case NIRI_EVENT_Ok:
+    if (ps->s == STATE_WAITING) {
+      ps->s = STATE_LAYOUT_INIT;
     }
-    cJSON *idx = cJSON_GetObjectItemCaseSensitive(obj, "idx");
-    if (cJSON_IsNumber(idx)) {
-      int new_idx = idx->valueint;
-      if (new_idx >= 0 && new_idx < ps->n && ps->current_idx != new_idx) {
-        ps->current_idx = idx->valueint;
-        send_notification(ps->layouts[ps->current_idx]);
-      }
+    break;
+  case NIRI_EVENT_KeyboardLayoutsChanged:
+    if (ps->s == STATE_LAYOUT_INIT) {
+      on_keyboard_layouts_changed(&event.u.KeyboardLayoutsChanged, ps);
+      ps->s = STATE_RECEIVING;
+    }
+    break;
+  case NIRI_EVENT_KeyboardLayoutSwitched:
+    if (ps->s == STATE_RECEIVING) {
+      on_keyboard_layout_switched(&event.u.KeyboardLayoutSwitched, ps);
     }
     break;
-  }
   default:
-    DO_LOG_ERROR("Unknown state");
     break;
   }
 cleanup:
-  cJSON_Delete(root);
-  return;
+  cJSON_ReaderRelease(&reader);
+  niri_free_event(&event);
 }
 
 static int read_socket(int sock) {
   int res = -1;
   program_state_t ps = {0};
   ps.s = STATE_WAITING;
-  ps.n = 0;
 
-  line_buffer_t lb = {0};
-  lb.capacity = 4096;
-  if (!(lb.buf = malloc(lb.capacity))) {
-    DO_LOG_ERRNO("malloc");
-    goto cleanup;
-  }
-  char temp[4096];
+  pending_line_t pl = {0};
+  read_chunk_t *chunk = NULL;
   ssize_t n;
 
-  while ((n = read(sock, temp, sizeof(temp))) > 0) {
-    for (ssize_t i = 0; i < n; i++) {
-      // Grow buffer if needed
-      if (lb.len + 1 >= lb.capacity) {
-        lb.capacity *= 2;
-        char *new_buf;
-        if (!(realloc(lb.buf, lb.capacity))) {
-          DO_LOG_ERRNO("realloc");
-          goto cleanup;
-        }
-        lb.buf = new_buf;
+  for (;;) {
+    if (!chunk && !(chunk = pending_line_take_chunk(&pl))) {
+      goto cleanup;
+    }
+    if ((n = read(sock, chunk->data, READ_CHUNK_SIZE)) <= 0) {
+      break;
+    }
+    const char *start = chunk->data;
+    const char *end = chunk->data + n;
+    const char *newline;
+    while ((newline = memchr(start, '\n', end - start))) {
+      if (pending_line_add(&pl, start, newline - start) < 0) {
+        goto cleanup;
       }
-      lb.buf[lb.len++] = temp[i];
-
-      // Found complete line
-      if (temp[i] == '\n') {
-        lb.buf[lb.len - 1] = '\0';
-        process_line(lb.buf, &ps);
-        lb.len = 0; // reset for next line
+      process_line(pl.segments, pl.n_segments, &ps);
+      pending_line_clear(&pl);
+      start = newline + 1;
+    }
+    if (start < end) {
+      // The rest of the line comes with the next read, keep this chunk
+      if (pending_line_add(&pl, start, end - start) < 0) {
+        goto cleanup;
       }
+      chunk->next = pl.held;
+      pl.held = chunk;
+      chunk = NULL;
     }
   }
   res = 0;
 cleanup:
   // Free allocated layouts
-  for (int i = 0; i < ps.n; i++) {
-    free(ps.layouts[i]);
-  }
-  free(ps.layouts);
+  niri_free_keyboard_layouts(&ps.layouts);
 
-  free(lb.buf);
+  free(chunk);
+  pending_line_free(&pl);
   return res;
 }
 
@@ -0,0 +1,259 @@
+#include "niri_events.h"
+#include <limits.h>
+#include <string.h>
+
+// Skip what is left of a value whose first token was already read
+static int finish_value(cJSON_Reader *reader, size_t depth) {
+  while (reader->depth > depth) {
+    if (!cJSON_ReaderSkip(reader)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Read the next token, skipping the rest of the value unless it has the
+// wanted type. Returns 1 if token holds a value of that type, 0 if it was
+// skipped and -1 on invalid JSON. The readers below return the same, 1 if
+// they filled in their output.
+static int read_value(cJSON_Reader *reader, int wanted, cJSON_Token *token) {
+  size_t depth = reader->depth;
+  int type = cJSON_ReaderNext(reader, token);
+  if (type == cJSON_TokenError || type == cJSON_TokenEnd) {
+    return -1;
+  }
+  if (type == wanted) {
+    return 1;
+  }
+  return finish_value(reader, depth) ? 0 : -1;
+}
+
+static int read_int(cJSON_Reader *reader, int *out) {
+  cJSON_Token token;
+  double number;
+  int res = read_value(reader, cJSON_TokenNumber, &token);
+  if (res <= 0) {
+    return res;
+  }
+  if (!cJSON_TokenToNumber(&token, &number)) {
+    return -1;
+  }
+  // saturate like valueint
+  if (number >= INT_MAX) {
+    *out = INT_MAX;
+  } else if (number <= (double)INT_MIN) {
+    *out = INT_MIN;
+  } else {
+    *out = (int)number;
+  }
+  return 1;
+}
+
+static int read_int64(cJSON_Reader *reader, cJSON_int64 *out) {
+  cJSON_Token token;
+  int res = read_value(reader, cJSON_TokenNumber, &token);
+  if (res <= 0) {
+    return res;
+  }
+  return cJSON_TokenToInt64(&token, out) ? 1 : -1;
+}
+
+static int read_bool(cJSON_Reader *reader, cJSON_bool *out) {
+  cJSON_Token token;
+  size_t depth = reader->depth;
+  int type = cJSON_ReaderNext(reader, &token);
+  if (type == cJSON_TokenTrue || type == cJSON_TokenFalse) {
+    *out = type == cJSON_TokenTrue;
+    return 1;
+  }
+  if (type == cJSON_TokenError || type == cJSON_TokenEnd) {
+    return -1;
+  }
+  return finish_value(reader, depth) ? 0 : -1;
+}
+
+// Copy a string token into memory from the cJSON hooks
+static char *copy_string(const cJSON_Token *token) {
+  // Unescaping never makes a string longer
+  char *string = cJSON_malloc(token->length + 1);
+  if (!string) {
+    return NULL;
+  }
+  if (!cJSON_TokenCopyString(token, string, token->length + 1)) {
+    cJSON_free(string);
+    return NULL;
+  }
+  return string;
+}
+
+static void free_strings(char **strings, int n) {
+  for (int i = 0; i < n; i++) {
+    cJSON_free(strings[i]);
+  }
+  cJSON_free(strings);
+}
+
+static int read_strings(cJSON_Reader *reader, char ***out, int *n_out) {
+  cJSON_Token token;
+  int res = read_value(reader, cJSON_TokenArrayStart, &token);
+  if (res <= 0) {
+    return res;
+  }
+
+  char **strings = NULL;
+  int n = 0;
+  int type;
+  size_t depth = reader->depth;
+  while ((type = cJSON_ReaderNext(reader, &token)) != cJSON_TokenArrayEnd) {
+    if (type == cJSON_TokenError) {
+      goto fail;
+    }
+    if (type != cJSON_TokenString) {
+      if (!finish_value(reader, depth)) {
+        goto fail;
+      }
+      continue;
+    }
+    // Grow by powers of two
+    if ((n & (n - 1)) == 0) {
+      char **grown = cJSON_malloc((n ? 2 * n : 1) * sizeof(char *));
+      if (!grown) {
+        goto fail;
+      }
+      if (n) {
+        memcpy(grown, strings, n * sizeof(char *));
+      }
+      cJSON_free(strings);
+      strings = grown;
+    }
+    if (!(strings[n] = copy_string(&token))) {
+      goto fail;
+    }
+    n++;
+  }
+
+  free_strings(*out, *n_out);
+  *out = strings;
+  *n_out = n;
+  return 1;
+
+fail:
+  free_strings(strings, n);
+  return -1;
+}
+
+// Decoders: one branch per field, straight from the schema
+
+#define NIRI_DECODE_INT(name, sub) read_int(reader, &out->name)
+#define NIRI_DECODE_INT64(name, sub) read_int64(reader, &out->name)
+#define NIRI_DECODE_BOOL(name, sub) read_bool(reader, &out->name)
+#define NIRI_DECODE_STRINGS(name, sub)                                         \
+  read_strings(reader, &out->name, &out->n_##name)
+#define NIRI_DECODE_OBJECT(name, sub) niri_decode_##sub(reader, &out->name)
+#define NIRI_DECODE_BRANCH(kind, name, sub)                                    \
+  else if (cJSON_TokenEquals(&token, #name)) {                                 \
+    res = NIRI_DECODE_##kind(name, sub);                                       \
+    if (res > 0) {                                                             \
+      out->has_##name = 1;                                                     \
+    }                                                                          \
+  }
+
+#define NIRI_DEFINE_DECODER(payload)                                           \
+  int niri_decode_##payload(cJSON_Reader *reader, niri_##payload##_t *out) {   \
+    cJSON_Token token;                                                         \
+    int res = read_value(reader, cJSON_TokenObjectStart, &token);              \
+    if (res <= 0) {                                                            \
+      return res;                                                              \
+    }                                                                          \
+    while (res >= 0 && cJSON_ReaderNext(reader, &token) == cJSON_TokenKey) {   \
+      if (0) {                                                                 \
+      }                                                                        \
+      NIRI_FIELDS_##payload(NIRI_DECODE_BRANCH) else {                         \
+        res = cJSON_ReaderSkip(reader) ? 0 : -1;                               \
+      }                                                                        \
+    }                                                                          \
+    return res >= 0 && token.type == cJSON_TokenObjectEnd ? 1 : -1;            \
+  }
+
+NIRI_PAYLOADS(NIRI_DEFINE_DECODER)
+
+#define NIRI_FREE_INT(name, sub)
+#define NIRI_FREE_INT64(name, sub)
+#define NIRI_FREE_BOOL(name, sub)
+#define NIRI_FREE_STRINGS(name, sub)                                           \
+  free_strings(value->name, value->n_##name);                                  \
+  value->name = NULL;                                                          \
+  value->n_##name = 0;                                                         \
+  value->has_##name = 0;
+#define NIRI_FREE_OBJECT(name, sub) niri_free_##sub(&value->name);
+#define NIRI_FREE_FIELD(kind, name, sub) NIRI_FREE_##kind(name, sub)
+
+#define NIRI_DEFINE_FREE(payload)                                              \
+  void niri_free_##payload(niri_##payload##_t *value) {                        \
+    (void)value;                                                               \
+    NIRI_FIELDS_##payload(NIRI_FREE_FIELD)                                     \
+  }
+
+NIRI_PAYLOADS(NIRI_DEFINE_FREE)
+
+// Event name lookup, a comparison per known event generated from the schema
+
+#define NIRI_LOOKUP_EVENT(name, kind, payload)                                 \
+  if (cJSON_TokenEquals(key, #name)) {                                         \
+    return NIRI_EVENT_##name;                                                  \
+  }
+
+niri_event_type_t niri_event_lookup(const cJSON_Token *key) {
+  NIRI_EVENTS(NIRI_LOOKUP_EVENT)
+  return NIRI_EVENT_UNKNOWN;
+}
+
+#define NIRI_READ_NONE(name, payload)                                          \
+  ok = cJSON_ReaderSkip(reader);
+#define NIRI_READ_OBJECT(name, payload)                                        \
+  ok = niri_decode_##payload(reader, &event->u.name) >= 0;
+#define NIRI_READ_EVENT(name, kind, payload)                                   \
+  case NIRI_EVENT_##name:                                                      \
+    NIRI_READ_##kind(name, payload) break;
+
+int niri_read_event(cJSON_Reader *reader, niri_event_t *event) {
+  cJSON_Token token;
+  int ok = 1;
+  memset(event, 0, sizeof(*event));
+
+  // Anything but an object with a key first is no event we know, but it
+  // still has to be valid JSON
+  if (cJSON_ReaderNext(reader, &token) == cJSON_TokenObjectStart &&
+      cJSON_ReaderNext(reader, &token) == cJSON_TokenKey) {
+    event->type = niri_event_lookup(&token);
+    switch (event->type) {
+      NIRI_EVENTS(NIRI_READ_EVENT)
+    default:
+      ok = cJSON_ReaderSkip(reader);
+      break;
+    }
+  }
+  if (token.type == cJSON_TokenError) {
+    return 0;
+  }
+
+  // The rest of the document, e.g. more members of the event object
+  return ok && finish_value(reader, 0) &&
+         cJSON_ReaderNext(reader, &token) == cJSON_TokenEnd;
+}
+
+#define NIRI_FREE_EVENT_NONE(name, payload)
+#define NIRI_FREE_EVENT_OBJECT(name, payload)                                  \
+  niri_free_##payload(&event->u.name);
+#define NIRI_FREE_EVENT(name, kind, payload)                                   \
+  case NIRI_EVENT_##name:                                                      \
+    NIRI_FREE_EVENT_##kind(name, payload) break;
+
+void niri_free_event(niri_event_t *event) {
+  switch (event->type) {
+    NIRI_EVENTS(NIRI_FREE_EVENT)
+  default:
+    break;
+  }
+  event->type = NIRI_EVENT_UNKNOWN;
+}
@@ -0,0 +1,61 @@
+#ifndef NIRI_EVENTS_H
+#define NIRI_EVENTS_H
+
+#include "cJSON.h"
+#include "niri_schema.h"
+
+// Typed niri events, generated from niri_schema.h
+
+#define NIRI_MEMBER_INT(name, sub) int name;
+#define NIRI_MEMBER_INT64(name, sub) cJSON_int64 name;
+#define NIRI_MEMBER_BOOL(name, sub) cJSON_bool name;
+#define NIRI_MEMBER_STRINGS(name, sub)                                         \
+  char **name;                                                                 \
+  int n_##name;
+#define NIRI_MEMBER_OBJECT(name, sub) niri_##sub##_t name;
+// has_<name> is set if the member was there with the right type
+#define NIRI_MEMBER(kind, name, sub)                                           \
+  NIRI_MEMBER_##kind(name, sub) cJSON_bool has_##name;
+
+#define NIRI_DECLARE_PAYLOAD(payload)                                          \
+  typedef struct {                                                             \
+    NIRI_FIELDS_##payload(NIRI_MEMBER)                                         \
+  } niri_##payload##_t;                                                        \
+  int niri_decode_##payload(cJSON_Reader *reader, niri_##payload##_t *out);    \
+  void niri_free_##payload(niri_##payload##_t *value);
+
+// niri_decode_<payload> decodes the next value of reader into out, which has
+// to start out zeroed. Returns 1 if it was an object, 0 if it was skipped for
+// being something else and -1 on invalid JSON or if an allocation failed.
+
+NIRI_PAYLOADS(NIRI_DECLARE_PAYLOAD)
+
+#define NIRI_EVENT_ENUM(name, kind, payload) NIRI_EVENT_##name,
+typedef enum {
+  NIRI_EVENT_UNKNOWN,
+  NIRI_EVENTS(NIRI_EVENT_ENUM) NIRI_EVENT_COUNT
+} niri_event_type_t;
+
+#define NIRI_UNION_NONE(name, payload)
+#define NIRI_UNION_OBJECT(name, payload) niri_##payload##_t name;
+#define NIRI_UNION_MEMBER(name, kind, payload) NIRI_UNION_##kind(name, payload)
+
+typedef struct {
+  niri_event_type_t type;
+  union {
+    int none; // for events without a payload
+    NIRI_EVENTS(NIRI_UNION_MEMBER)
+  } u;
+} niri_event_t;
+
+// Find the event type of the key of an event object
+niri_event_type_t niri_event_lookup(const cJSON_Token *key);
+// Read a whole event line like {"KeyboardLayoutSwitched":{"idx":1}}. Unknown
+// events have type NIRI_EVENT_UNKNOWN. Returns 0 if the line isn't exactly
+// one valid JSON document or if an allocation failed. After invalid JSON the
+// reader has failed, its error_position tells where. Release the event with
+// niri_free_event either way.
+int niri_read_event(cJSON_Reader *reader, niri_event_t *event);
+void niri_free_event(niri_event_t *event);
+
+#endif
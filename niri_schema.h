@@ -0,0 +1,48 @@
+// Schema of the niri events we understand. Structs, decoders and the event
+// name lookup in niri_events.h/.c are all generated from these lists, so a new
+// event only needs to be declared here.
+//
+// NIRI_EVENTS lists EVENT(name, kind, payload). name is the key of the event
+// object niri sends, kind is OBJECT if the value is an object decoded into
+// niri_<payload>_t, or NONE if the value is ignored.
+//
+// Every payload has a NIRI_FIELDS_<payload> list of FIELD(kind, name, sub):
+//   INT      int, saturated like cJSON valueint
+//   INT64    cJSON_int64, exact for integer literals, for ids and counters
+//   BOOL     cJSON_bool
+//   STRINGS  char **name plus int n_name, non-string elements are left out
+//   OBJECT   niri_<sub>_t, decoded with its own field list
+// Every field also gets a cJSON_bool has_<name> that is set if the member was
+// there with the right type. Members that are missing, null or of another
+// type are left zero, so check has_<name> where 0 is a valid value.
+
+#define NIRI_EVENTS(EVENT)                                                     \
+  EVENT(Ok, NONE, _)                                                           \
+  EVENT(KeyboardLayoutsChanged, OBJECT, keyboard_layouts_changed)              \
+  EVENT(KeyboardLayoutSwitched, OBJECT, keyboard_layout_switched)              \
+  EVENT(WorkspaceActivated, OBJECT, workspace_activated)                       \
+  EVENT(WindowFocusChanged, OBJECT, window_focus_changed)
+
+// Payloads in dependency order, nested ones first
+#define NIRI_PAYLOADS(PAYLOAD)                                                 \
+  PAYLOAD(keyboard_layouts)                                                    \
+  PAYLOAD(keyboard_layouts_changed)                                            \
+  PAYLOAD(keyboard_layout_switched)                                            \
+  PAYLOAD(workspace_activated)                                                 \
+  PAYLOAD(window_focus_changed)
+
+#define NIRI_FIELDS_keyboard_layouts(FIELD)                                    \
+  FIELD(INT, current_idx, _)                                                   \
+  FIELD(STRINGS, names, _)
+
+#define NIRI_FIELDS_keyboard_layouts_changed(FIELD)                            \
+  FIELD(OBJECT, keyboard_layouts, keyboard_layouts)
+
+#define NIRI_FIELDS_keyboard_layout_switched(FIELD) FIELD(INT, idx, _)
+
+#define NIRI_FIELDS_workspace_activated(FIELD)                                 \
+  FIELD(INT64, id, _)                                                          \
+  FIELD(BOOL, focused, _)
+
+// id is null when no window has focus, has_id is 0 then
+#define NIRI_FIELDS_window_focus_changed(FIELD) FIELD(INT64, id, _)
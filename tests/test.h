@@ -0,0 +1,114 @@
+// Checks shared by the tests in this directory. A failed CHECK prints where
+// it failed and the test goes on, test_done() gives the exit status.
+#ifndef TEST_H
+#define TEST_H
+
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int test_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      test_failures++;                                                         \
+    }                                                                          \
+  } while (0)
+
+// item printed without formatting is expected
+#define CHECK_JSON(item, expected)                                             \
+  do {                                                                         \
+    char *printed_ = cJSON_PrintUnformatted(item);                             \
+    if (!printed_ || strcmp(printed_, expected) != 0) {                        \
+      fprintf(stderr, "%s:%d: printed %s, expected %s\n", __FILE__, __LINE__,  \
+              printed_ ? printed_ : "NULL", expected);                         \
+      test_failures++;                                                         \
+    }                                                                          \
+    cJSON_free(printed_);                                                      \
+  } while (0)
+
+static int test_done(void) {
+  if (test_failures) {
+    fprintf(stderr, "%d checks failed\n", test_failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Deterministic xorshift so failures can be reproduced
+static unsigned long long test_random_state = 88172645463325252ULL;
+
+static inline unsigned long long test_random(void) {
+  test_random_state ^= test_random_state << 13;
+  test_random_state ^= test_random_state >> 7;
+  test_random_state ^= test_random_state << 17;
+  return test_random_state;
+}
+
+// Random tree of every type but raw, with strings that need escaping, keys
+// that repeat and arrays/objects big enough to be indexed
+static inline cJSON *test_random_tree(int depth) {
+  static const char *const pieces[] = {"a", "b", "\"", "\\", "/", "\n",
+                                       "\t", "\x01", "\xc3\xa9", " ", "z"};
+  char buffer[64];
+  double number;
+  unsigned long long bits;
+
+  switch (test_random() % (depth > 4 ? 6 : 9)) {
+  case 0:
+    return cJSON_CreateNull();
+  case 1:
+    return cJSON_CreateBool(test_random() & 1);
+  case 2:
+    bits = test_random();
+    memcpy(&number, &bits, sizeof(number));
+    return cJSON_CreateNumber(number == number && number - number == 0 ? number
+                                                                       : 1.5);
+  case 3:
+    return cJSON_CreateNumber((double)(test_random() % 2000000) - 1000000);
+  case 4:
+    return cJSON_CreateInt64((cJSON_int64)test_random());
+  case 5:
+    buffer[0] = '\0';
+    for (int n = test_random() % 20; n > 0; n--) {
+      strcat(buffer, pieces[test_random() % (sizeof(pieces) / sizeof(*pieces))]);
+    }
+    return cJSON_CreateString(buffer);
+  case 6:
+  case 7: {
+    cJSON *array = cJSON_CreateArray();
+    for (int n = test_random() % (test_random() % 4 == 0 ? 40 : 5); n > 0; n--) {
+      cJSON_AddItemToArray(array, test_random_tree(depth + 1));
+    }
+    return array;
+  }
+  default: {
+    cJSON *object = cJSON_CreateObject();
+    for (int n = test_random() % (test_random() % 4 == 0 ? 40 : 5); n > 0; n--) {
+      snprintf(buffer, sizeof(buffer), "k%d", (int)(test_random() % 30));
+      cJSON_AddItemToObject(object, buffer, test_random_tree(depth + 1));
+    }
+    return object;
+  }
+  }
+}
+
+// Drop all but the first of every repeated key, for cJSON_Compare
+static inline void test_remove_duplicate_keys(cJSON *tree) {
+  cJSON *child = tree->child;
+  while (child) {
+    cJSON *next = child->next;
+    if (cJSON_IsObject(tree) &&
+        cJSON_GetObjectItemCaseSensitive(tree, child->string) != child) {
+      cJSON_Delete(cJSON_DetachItemViaPointer(tree, child));
+    } else {
+      test_remove_duplicate_keys(child);
+    }
+    child = next;
+  }
+}
+
+#endif
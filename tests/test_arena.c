@@ -0,0 +1,85 @@
+// Trees parsed into an arena, its blocks reused after a reset and the items
+// an arena tree can take.
+#include "test.h"
+
+static size_t allocations;
+
+static void *counting_malloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+static cJSON *parse_into(cJSON_Arena *arena, const char *json) {
+  cJSON_ParseContext context;
+  cJSON_InitParseContext(&context);
+  context.arena = arena;
+  return cJSON_ParseWithContext(&context, json, strlen(json));
+}
+
+int main(void) {
+  cJSON_Hooks hooks = {counting_malloc, free};
+  cJSON_InitHooks(&hooks);
+
+  // Small values first and a long string last, and the other way around
+  char small_first[2048] = "[";
+  char long_first[2048] = "[\"";
+  for (int i = 0; i < 60; i++) {
+    strcat(small_first, "[1],");
+  }
+  strcat(small_first, "\"");
+  memset(small_first + strlen(small_first), 'x', 1000);
+  strcat(small_first, "\"]");
+  memset(long_first + strlen(long_first), 'x', 1000);
+  strcat(long_first, "\"");
+  for (int i = 0; i < 60; i++) {
+    strcat(long_first, ",[1]");
+  }
+  strcat(long_first, "]");
+
+  cJSON_Arena *arena = cJSON_CreateArena(256);
+  CHECK(arena != NULL);
+  size_t first_round = 0;
+  size_t warmed_up = 0;
+  for (int round = 0; round < 20; round++) {
+    cJSON *tree = parse_into(arena, round % 2 ? long_first : small_first);
+    CHECK(cJSON_GetArraySize(tree) == 61);
+    cJSON_Delete(tree);
+    cJSON_ResetArena(arena);
+    if (round == 0) {
+      first_round = allocations;
+    } else if (round == 3) {
+      warmed_up = allocations;
+    }
+    // The long string finds the big block behind the small ones
+    if (round == 1) {
+      CHECK(allocations == first_round);
+    }
+  }
+  // The chain stops growing once there are blocks for both orders
+  CHECK(allocations == warmed_up);
+
+  cJSON *tree = parse_into(arena, "{\"a\":[1,2],\"b\":{\"c\":true}}");
+  cJSON *a = cJSON_GetObjectItem(tree, "a");
+  cJSON *plain = cJSON_CreateNumber(3);
+  CHECK(!cJSON_AddItemToArray(a, plain));
+  CHECK(!cJSON_InsertItemInArray(a, 0, plain));
+  CHECK(!cJSON_ReplaceItemInArray(a, 0, plain));
+  CHECK(!cJSON_AddItemToObject(tree, "d", plain));
+  CHECK(!cJSON_ReplaceItemInObject(tree, "a", plain));
+  CHECK(cJSON_AddNumberToObject(tree, "d", 4) == NULL);
+  cJSON_Delete(plain);
+
+  // Items of the arena can move around within it, and out of it
+  cJSON *b = cJSON_DetachItemFromObject(tree, "b");
+  CHECK(cJSON_AddItemToArray(a, b));
+  CHECK_JSON(tree, "{\"a\":[1,2,{\"c\":true}]}");
+  cJSON *outside = cJSON_CreateArray();
+  CHECK(cJSON_AddItemToArray(outside, cJSON_DetachItemFromArray(a, 0)));
+  CHECK_JSON(outside, "[1]");
+  cJSON_Delete(outside);
+  cJSON_Delete(tree);
+
+  cJSON_DeleteArena(arena);
+  cJSON_InitHooks(NULL);
+  return test_done();
+}
@@ -0,0 +1,118 @@
+// Trees encoded as CBOR decode to the same tree, and so do the documents of
+// the CBOR writer.
+#include "test.h"
+
+static int round_trips(const cJSON *item, cJSON_bool framed) {
+  size_t length = 0;
+  size_t consumed = 0;
+  cJSON *decoded = NULL;
+  unsigned char *encoded = cJSON_EncodeCBOR(item, framed, &length);
+  if (!encoded) {
+    return 0;
+  }
+  if (framed) {
+    // Incomplete frames need more data
+    int complete = 1;
+    for (size_t part = 0; part < length && complete; part++) {
+      complete = cJSON_DecodeCBORFrame(encoded, part, &consumed, &decoded) == 0;
+    }
+    complete = complete &&
+               cJSON_DecodeCBORFrame(encoded, length, &consumed, &decoded) == 1;
+    if (!complete) {
+      decoded = NULL;
+    }
+  } else {
+    decoded = cJSON_DecodeCBOR(encoded, length, &consumed);
+  }
+  // Whole doubles come back as integers, so compare values and not text
+  int same = decoded && consumed == length && cJSON_Compare(item, decoded, 1);
+  cJSON_Delete(decoded);
+  cJSON_free(encoded);
+  return same;
+}
+
+static int encodes_as(const char *json, const char *hex) {
+  cJSON *item = cJSON_Parse(json);
+  size_t length = 0;
+  unsigned char *encoded = cJSON_EncodeCBOR(item, 0, &length);
+  char out[256] = "";
+  for (size_t i = 0; encoded && i < length && 2 * i + 2 < sizeof(out); i++) {
+    snprintf(out + 2 * i, 3, "%02x", encoded[i]);
+  }
+  cJSON_free(encoded);
+  cJSON_Delete(item);
+  if (strcmp(out, hex) != 0) {
+    fprintf(stderr, "%s: encoded %s, expected %s\n", json, out, hex);
+    return 0;
+  }
+  return 1;
+}
+
+int main(void) {
+  // Examples from RFC 8949 appendix A
+  CHECK(encodes_as("0", "00"));
+  CHECK(encodes_as("23", "17"));
+  CHECK(encodes_as("24", "1818"));
+  CHECK(encodes_as("1000000", "1a000f4240"));
+  CHECK(encodes_as("-1000", "3903e7"));
+  CHECK(encodes_as("1.5", "fa3fc00000"));
+  CHECK(encodes_as("1.1", "fb3ff199999999999a"));
+  CHECK(encodes_as("[true,false,null]", "83f5f4f6"));
+  CHECK(encodes_as("{\"a\":1,\"b\":[2,3]}", "a26161016162820203"));
+  CHECK(encodes_as("\"\\u00fc\"", "62c3bc"));
+
+  const char *documents[] = {
+      "[0,-1,24,-25,255,256,65535,65536,4294967295,4294967296,"
+      "9223372036854775807,-9223372036854775808,0.5,-2.5e-300,1e300]",
+      "{\"\":\"\",\"nested\":{\"a\":[[],{}],\"b\":\"\\u20ac\\ud83d\\ude00\"}}",
+      "\"a string that is longer than twenty three bytes\"",
+  };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(*documents); i++) {
+    cJSON *item = cJSON_Parse(documents[i]);
+    CHECK(round_trips(item, 0));
+    CHECK(round_trips(item, 1));
+    cJSON_Delete(item);
+  }
+  for (int i = 0; i < 300; i++) {
+    cJSON *item = test_random_tree(0);
+    test_remove_duplicate_keys(item);
+    CHECK(round_trips(item, i & 1));
+    cJSON_Delete(item);
+  }
+
+  // Raw items can't be encoded, decoding rejects what JSON can't hold
+  cJSON *raw = cJSON_CreateRaw("[1]");
+  CHECK(cJSON_EncodeCBOR(raw, 0, NULL) == NULL);
+  cJSON_Delete(raw);
+  static const unsigned char byte_string[] = {0x41, 0x00};
+  static const unsigned char integer_key[] = {0xa1, 0x01, 0x02};
+  static const unsigned char truncated[] = {0x82, 0x01};
+  CHECK(cJSON_DecodeCBOR(byte_string, sizeof(byte_string), NULL) == NULL);
+  CHECK(cJSON_DecodeCBOR(integer_key, sizeof(integer_key), NULL) == NULL);
+  CHECK(cJSON_DecodeCBOR(truncated, sizeof(truncated), NULL) == NULL);
+
+  // Indefinite lengths from the writer
+  char buffer[256];
+  cJSON_Writer writer;
+  cJSON_InitCBORWriter(&writer, buffer, sizeof(buffer), 0);
+  cJSON_WriteObjectStart(&writer);
+  cJSON_WriteKey(&writer, "ids");
+  cJSON_WriteArrayStart(&writer);
+  cJSON_WriteInt64(&writer, 7);
+  cJSON_WriteNumber(&writer, 0.25);
+  cJSON_WriteArrayEnd(&writer);
+  cJSON_WriteKey(&writer, "ok");
+  cJSON_WriteBool(&writer, 1);
+  cJSON_WriteObjectEnd(&writer);
+  size_t length = 0;
+  const char *output = cJSON_WriterOutput(&writer, &length);
+  CHECK(output != NULL);
+  cJSON *decoded =
+      output ? cJSON_DecodeCBOR((const unsigned char *)output, length, NULL)
+             : NULL;
+  CHECK_JSON(decoded, "{\"ids\":[7,0.25],\"ok\":true}");
+  cJSON_Delete(decoded);
+  cJSON_FreeWriter(&writer);
+
+  return test_done();
+}
@@ -0,0 +1,132 @@
+// Parse contexts on two threads at once: each keeps its own hooks, options
+// and error position, and the global hooks and error are left alone.
+#include "test.h"
+#include <pthread.h>
+
+#define ROUNDS 2000
+
+// Hooks of each context count their own calls, only its thread uses them
+static size_t mallocs[2], frees[2];
+static void *malloc_0(size_t size) { mallocs[0]++; return malloc(size); }
+static void free_0(void *pointer) { frees[0]++; free(pointer); }
+static void *malloc_1(size_t size) { mallocs[1]++; return malloc(size); }
+static void free_1(void *pointer) { frees[1]++; free(pointer); }
+
+// The global hooks must not be called by context parses
+static size_t global_calls;
+static void *global_malloc(size_t size) {
+  __atomic_add_fetch(&global_calls, 1, __ATOMIC_RELAXED);
+  return malloc(size);
+}
+
+typedef struct {
+  int id;
+  cJSON_ParseContext context;
+  int failures;
+} worker_t;
+
+#define WORKER_CHECK(worker, cond)                                             \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: worker %d: CHECK(%s) failed\n", __FILE__,        \
+              __LINE__, (worker)->id, #cond);                                  \
+      (worker)->failures++;                                                    \
+    }                                                                          \
+  } while (0)
+
+static void *work(void *argument) {
+  worker_t *worker = argument;
+  cJSON_ParseContext *context = &worker->context;
+  char valid[64], invalid[64];
+  // The invalid documents differ per worker, so mixed up positions show
+  int error_at = 10 + worker->id * 7;
+
+  snprintf(valid, sizeof(valid), "{\"worker\":%d,\"name\":\"w%d\"}  x",
+           worker->id, worker->id);
+  memset(invalid, ' ', sizeof(invalid));
+  memcpy(invalid, "[1", 2);
+  memcpy(invalid + error_at, "]", 1);
+  invalid[error_at - 1] = ',';
+  invalid[error_at + 1] = '\0';
+
+  for (int i = 0; i < ROUNDS; i++) {
+    cJSON *tree = cJSON_ParseWithContext(context, valid, strlen(valid));
+    WORKER_CHECK(worker, tree != NULL);
+    WORKER_CHECK(worker, context->position == strlen(valid) - 3);
+    WORKER_CHECK(worker, cJSON_GetObjectItem(tree, "worker") &&
+                             cJSON_GetObjectItem(tree, "worker")->valueint ==
+                                 worker->id);
+
+    // Reusing the tree's items and strings
+    tree = cJSON_ParseIntoWithContext(context, tree, valid, strlen(valid));
+    WORKER_CHECK(worker, tree != NULL);
+    cJSON_DeleteWithContext(context, tree);
+
+    WORKER_CHECK(worker,
+                 cJSON_ParseWithContext(context, invalid, strlen(invalid)) ==
+                     NULL);
+    WORKER_CHECK(worker, context->position == (size_t)error_at);
+  }
+
+  // Options of one context don't leak into the other
+  context->reject_trailing = worker->id == 0;
+  cJSON *tree = cJSON_ParseWithContext(context, valid, strlen(valid));
+  WORKER_CHECK(worker, (tree == NULL) == (worker->id == 0));
+  cJSON_DeleteWithContext(context, tree);
+  return NULL;
+}
+
+int main(void) {
+  cJSON_Hooks hooks = {global_malloc, free};
+  worker_t workers[2];
+  pthread_t threads[2];
+
+  // An error of the global parse that has to survive the context parses
+  const char *global_text = "[1,2,}";
+  cJSON_InitHooks(&hooks);
+  CHECK(cJSON_Parse(global_text) == NULL);
+  const char *global_error = cJSON_GetErrorPtr();
+  CHECK(global_error == global_text + 5);
+  global_calls = 0;
+
+  for (int i = 0; i < 2; i++) {
+    workers[i].id = i;
+    workers[i].failures = 0;
+    cJSON_InitParseContext(&workers[i].context);
+    workers[i].context.hooks.malloc_fn = i == 0 ? malloc_0 : malloc_1;
+    workers[i].context.hooks.free_fn = i == 0 ? free_0 : free_1;
+  }
+  for (int i = 0; i < 2; i++) {
+    CHECK(pthread_create(&threads[i], NULL, work, &workers[i]) == 0);
+  }
+  for (int i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+    test_failures += workers[i].failures;
+  }
+
+  // Each context allocated and freed with its own hooks only
+  for (int i = 0; i < 2; i++) {
+    CHECK(mallocs[i] > 0);
+    CHECK(mallocs[i] == frees[i]);
+  }
+  CHECK(global_calls == 0);
+  CHECK(cJSON_GetErrorPtr() == global_error);
+
+  // Missing hooks fall back to malloc/free, and depth limits apply per context
+  cJSON_ParseContext context;
+  cJSON_InitParseContext(&context);
+  context.max_depth = 2;
+  cJSON *tree = cJSON_ParseWithContext(&context, "[[1]]", 5);
+  CHECK(tree != NULL && context.position == 5);
+  cJSON_DeleteWithContext(&context, tree);
+  CHECK(cJSON_ParseWithContext(&context, "[[[1]]]", 7) == NULL);
+  CHECK(context.position == 2);
+  CHECK(cJSON_ParseWithContext(&context, "", 0) == NULL);
+  CHECK(cJSON_ParseWithContext(NULL, "1", 1) == NULL);
+  cJSON_DeleteWithContext(&context, NULL);
+  CHECK(global_calls == 0);
+  CHECK(cJSON_GetErrorPtr() == global_error);
+
+  cJSON_InitHooks(NULL);
+  return test_done();
+}
@@ -0,0 +1,186 @@
+// Decoding objects into structs with a table of cJSON_Field: every kind of
+// field, values of the wrong type, and what is left to free after a failure.
+#include "test.h"
+#include <limits.h>
+#include <stddef.h>
+
+typedef struct {
+  int idx;
+  char *label;
+} inner_t;
+
+typedef struct {
+  int x;
+  double d;
+  cJSON_bool b;
+  char *name;
+  char **tags;
+  int n_tags;
+  inner_t inner;
+  cJSON_int64 id;
+  int deep;
+  char *outer_name;
+} record_t;
+
+static const cJSON_Field inner_fields[] = {
+    {"idx", cJSON_FieldInt, offsetof(inner_t, idx), 0, NULL},
+    {"label", cJSON_FieldString, offsetof(inner_t, label), 0, NULL},
+    {NULL, 0, 0, 0, NULL},
+};
+
+static const cJSON_Field record_fields[] = {
+    {"x", cJSON_FieldInt, offsetof(record_t, x), 0, NULL},
+    {"d", cJSON_FieldDouble, offsetof(record_t, d), 0, NULL},
+    {"b", cJSON_FieldBool, offsetof(record_t, b), 0, NULL},
+    {"name", cJSON_FieldString, offsetof(record_t, name), 0, NULL},
+    {"tags", cJSON_FieldStringArray, offsetof(record_t, tags),
+     offsetof(record_t, n_tags), NULL},
+    {"inner", cJSON_FieldObject, offsetof(record_t, inner), 0, inner_fields},
+    {"id", cJSON_FieldInt64, offsetof(record_t, id), 0, NULL},
+    {"outer.deep.value", cJSON_FieldInt, offsetof(record_t, deep), 0, NULL},
+    {"outer.name", cJSON_FieldString, offsetof(record_t, outer_name), 0, NULL},
+    {NULL, 0, 0, 0, NULL},
+};
+
+static const char full[] =
+    "{\"x\":-7,\"d\":2.5,\"b\":true,\"n\\u0061me\":\"a\\\"b\","
+    "\"tags\":[\"one\",1,{\"no\":\"two\"},[\"three\"],\"four\"],"
+    "\"inner\":{\"label\":\"in\",\"idx\":3,\"other\":[]},"
+    "\"id\":9007199254740993,\"unknown\":{\"x\":1},"
+    "\"outer\":{\"name\":\"out\",\"deep\":{\"value\":42}}}";
+
+static unsigned long decode(const char *json, record_t *record, int *ok) {
+  unsigned long found = 0;
+  *ok = cJSON_Decode(json, strlen(json), record_fields, record, &found);
+  return found;
+}
+
+// Fail every allocation after the first allowed ones
+static long allocations_left = -1;
+
+static void *failing_malloc(size_t size) {
+  if (allocations_left == 0) {
+    return NULL;
+  }
+  if (allocations_left > 0) {
+    allocations_left--;
+  }
+  return malloc(size);
+}
+
+int main(void) {
+  record_t record = {0};
+  int ok = 0;
+
+  // Every kind of field, unknown members and non-strings in arrays are skipped
+  unsigned long found = decode(full, &record, &ok);
+  CHECK(ok);
+  CHECK(found == 0x1ff);
+  CHECK(record.x == -7);
+  CHECK(record.d == 2.5);
+  CHECK(record.b);
+  CHECK(record.name && strcmp(record.name, "a\"b") == 0);
+  CHECK(record.n_tags == 2);
+  CHECK(record.n_tags == 2 && strcmp(record.tags[0], "one") == 0 &&
+        strcmp(record.tags[1], "four") == 0);
+  CHECK(record.inner.idx == 3);
+  CHECK(record.inner.label && strcmp(record.inner.label, "in") == 0);
+  CHECK(record.id == 9007199254740993LL);
+  CHECK(record.deep == 42);
+  CHECK(record.outer_name && strcmp(record.outer_name, "out") == 0);
+
+  // Repeated keys replace earlier values without leaking them
+  found = decode("{\"name\":\"again\",\"tags\":[],\"name\":\"last\","
+                 "\"inner\":{\"label\":\"new\"}}",
+                 &record, &ok);
+  CHECK(ok);
+  CHECK(found == ((1UL << 3) | (1UL << 4) | (1UL << 5)));
+  CHECK(strcmp(record.name, "last") == 0);
+  CHECK(record.n_tags == 0 && record.tags == NULL);
+  CHECK(strcmp(record.inner.label, "new") == 0);
+  CHECK(record.inner.idx == 3);
+
+  cJSON_FreeDecoded(record_fields, &record);
+  CHECK(record.name == NULL && record.outer_name == NULL);
+  CHECK(record.inner.label == NULL);
+  CHECK(record.tags == NULL && record.n_tags == 0);
+
+  // Values of the wrong type leave fields alone
+  memset(&record, 0, sizeof(record));
+  found = decode("{\"x\":\"1\",\"d\":true,\"b\":0,\"name\":5,\"tags\":\"t\","
+                 "\"inner\":[1],\"id\":null,\"outer\":{\"deep\":7}}",
+                 &record, &ok);
+  CHECK(ok);
+  CHECK(found == 0);
+  CHECK(record.x == 0 && record.d == 0 && !record.b && record.name == NULL);
+  CHECK(record.tags == NULL && record.deep == 0);
+
+  // Ints saturate and truncate like valueint, int64 fields are exact
+  found = decode("{\"x\":1e20,\"id\":-9223372036854775808}", &record, &ok);
+  CHECK(ok && record.x == INT_MAX && record.id == LLONG_MIN);
+  found = decode("{\"x\":-1e20,\"d\":1e-3}", &record, &ok);
+  CHECK(ok && record.x == INT_MIN && record.d == 1e-3);
+  found = decode("{\"x\":2.9}", &record, &ok);
+  CHECK(ok && record.x == 2);
+
+  // A document that is no object decodes nothing
+  found = decode("[{\"x\":1}]", &record, &ok);
+  CHECK(ok && found == 0 && record.x == 2);
+  found = decode("", &record, &ok);
+  CHECK(!ok && found == 0);
+
+  // Invalid JSON keeps what was decoded before it, the rest is freed
+  const char *broken[] = {
+      "{\"name\":\"kept\",\"x\":1,}",
+      "{\"name\":\"kept\",\"tags\":[\"a\",\"b\",}",
+      "{\"name\":\"kept\",\"tags\":[\"a\",\"b\"",
+      "{\"name\":\"kept\",\"inner\":{\"label\":\"l\",\"idx\":}}",
+      "{\"name\":\"kept\",\"outer\":{\"deep\":{\"value\":1",
+      "{\"name\":\"kept\",\"unknown\":[1,{]}",
+      "{\"name\":\"kept\",\"id\":-}",
+  };
+  for (size_t i = 0; i < sizeof(broken) / sizeof(*broken); i++) {
+    memset(&record, 0, sizeof(record));
+    decode(broken[i], &record, &ok);
+    CHECK(!ok);
+    CHECK(record.name && strcmp(record.name, "kept") == 0);
+    CHECK(record.tags == NULL && record.n_tags == 0);
+    cJSON_FreeDecoded(record_fields, &record);
+  }
+  memset(&record, 0, sizeof(record));
+  decode("{\"inner\":{\"label\":\"l\",\"idx\":}}", &record, &ok);
+  CHECK(!ok && record.inner.label && strcmp(record.inner.label, "l") == 0);
+  cJSON_FreeDecoded(record_fields, &record);
+
+  // Running out of memory anywhere fails cleanly, with enough it succeeds
+  cJSON_Hooks hooks = {failing_malloc, free};
+  cJSON_InitHooks(&hooks);
+  for (long allowed = 0;; allowed++) {
+    memset(&record, 0, sizeof(record));
+    allocations_left = allowed;
+    found = decode(full, &record, &ok);
+    allocations_left = -1;
+    cJSON_FreeDecoded(record_fields, &record);
+    if (ok) {
+      CHECK(found == 0x1ff);
+      break;
+    }
+    CHECK(allowed < 100);
+    if (allowed >= 100) {
+      break;
+    }
+  }
+  cJSON_InitHooks(NULL);
+
+  // Tables with more fields than bits in found are refused
+  cJSON_Field many[CJSON_DECODE_MAX_FIELDS + 2];
+  for (int i = 0; i <= CJSON_DECODE_MAX_FIELDS; i++) {
+    many[i] = record_fields[0];
+  }
+  many[CJSON_DECODE_MAX_FIELDS + 1].path = NULL;
+  memset(&record, 0, sizeof(record));
+  CHECK(!cJSON_Decode("{\"x\":1}", 7, many, &record, &found));
+  CHECK(found == 0 && record.x == 0);
+
+  return test_done();
+}
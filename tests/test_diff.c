@@ -0,0 +1,207 @@
+// Patches from cJSON_Diff turn from into to when applied.
+#include "test.h"
+
+// Parent of the item a JSON pointer points at, its last reference token
+// unescaped into token
+static cJSON *pointer_parent(cJSON *root, const char *pointer, char *token) {
+  cJSON *current = root;
+  while (*pointer == '/') {
+    size_t n = 0;
+    for (pointer++; *pointer && *pointer != '/'; pointer++) {
+      if (*pointer == '~') {
+        pointer++;
+        token[n++] = *pointer == '0' ? '~' : '/';
+      } else {
+        token[n++] = *pointer;
+      }
+    }
+    token[n] = '\0';
+    if (!*pointer) {
+      return current;
+    }
+    current = cJSON_IsArray(current)
+                  ? cJSON_GetArrayItem(current, atoi(token))
+                  : cJSON_GetObjectItemCaseSensitive(current, token);
+    if (!current) {
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
+static cJSON *take(cJSON **root, const char *pointer) {
+  char token[256];
+  if (!*pointer) {
+    cJSON *taken = *root;
+    *root = NULL;
+    return taken;
+  }
+  cJSON *parent = pointer_parent(*root, pointer, token);
+  if (!parent) {
+    return NULL;
+  }
+  return cJSON_IsArray(parent)
+             ? cJSON_DetachItemFromArray(parent, atoi(token))
+             : cJSON_DetachItemFromObjectCaseSensitive(parent, token);
+}
+
+static int put(cJSON **root, const char *pointer, cJSON *value) {
+  char token[256];
+  if (!*pointer) {
+    cJSON_Delete(*root);
+    *root = value;
+    return 1;
+  }
+  cJSON *parent = pointer_parent(*root, pointer, token);
+  if (!parent) {
+    return 0;
+  }
+  if (cJSON_IsArray(parent)) {
+    int size = cJSON_GetArraySize(parent);
+    int index = strcmp(token, "-") == 0 ? size : atoi(token);
+    if (index > size) {
+      return 0;
+    }
+    return index == size ? cJSON_AddItemToArray(parent, value)
+                         : cJSON_InsertItemInArray(parent, index, value);
+  }
+  cJSON_DeleteItemFromObjectCaseSensitive(parent, token);
+  return cJSON_AddItemToObject(parent, token, value);
+}
+
+// Apply the add, remove, replace and move operations of patch to a copy of
+// from and compare with to
+static int patch_gives(const cJSON *from, const cJSON *patch,
+                       const cJSON *to) {
+  cJSON *document = cJSON_Duplicate(from, 1);
+  cJSON *operation;
+  int ok = patch != NULL;
+  cJSON_ArrayForEach(operation, patch) {
+    const char *op = cJSON_GetStringValue(cJSON_GetObjectItem(operation, "op"));
+    const char *path =
+        cJSON_GetStringValue(cJSON_GetObjectItem(operation, "path"));
+    cJSON *value = cJSON_GetObjectItem(operation, "value");
+    cJSON *taken = NULL;
+    if (!op || !path) {
+      ok = 0;
+    } else if (strcmp(op, "remove") == 0) {
+      ok = ok && (taken = take(&document, path)) != NULL;
+    } else if (strcmp(op, "add") == 0) {
+      ok = ok && put(&document, path, cJSON_Duplicate(value, 1));
+    } else if (strcmp(op, "replace") == 0) {
+      ok = ok && ((taken = take(&document, path)) != NULL || !*path) &&
+           put(&document, path, cJSON_Duplicate(value, 1));
+    } else if (strcmp(op, "move") == 0) {
+      const char *source =
+          cJSON_GetStringValue(cJSON_GetObjectItem(operation, "from"));
+      cJSON *moved = source ? take(&document, source) : NULL;
+      ok = ok && moved && put(&document, path, moved);
+    } else {
+      ok = 0;
+    }
+    cJSON_Delete(taken);
+  }
+  ok = ok && cJSON_Compare(document, to, 1);
+  cJSON_Delete(document);
+  return ok;
+}
+
+static cJSON *window(int id) {
+  cJSON *w = cJSON_CreateObject();
+  cJSON_AddNumberToObject(w, "id", id);
+  cJSON_AddStringToObject(w, "title", test_random() % 3 ? "a" : "b");
+  cJSON_AddBoolToObject(w, "focused", test_random() & 1);
+  return w;
+}
+
+static cJSON *random_unique_tree(int depth) {
+  cJSON *tree = test_random_tree(depth);
+  test_remove_duplicate_keys(tree);
+  return tree;
+}
+
+int main(void) {
+  cJSON *from = cJSON_Parse("{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"}}");
+  cJSON *to = cJSON_Parse("{\"a\":1,\"b\":[1,3],\"c\":{\"d\":\"y\"},"
+                          "\"e/~f\":null}");
+  cJSON *patch = cJSON_Diff(from, to, NULL);
+  CHECK_JSON(patch, "[{\"op\":\"replace\",\"path\":\"/b/1\",\"value\":3},"
+                    "{\"op\":\"remove\",\"path\":\"/b/2\"},"
+                    "{\"op\":\"replace\",\"path\":\"/c/d\",\"value\":\"y\"},"
+                    "{\"op\":\"add\",\"path\":\"/e~1~0f\",\"value\":null}]");
+  CHECK(patch_gives(from, patch, to));
+  cJSON_Delete(patch);
+  patch = cJSON_Diff(to, to, NULL);
+  CHECK_JSON(patch, "[]");
+  cJSON_Delete(patch);
+  cJSON_Delete(from);
+  cJSON_Delete(to);
+
+  // Window lists where windows close, open, move and change
+  for (int round = 0; round < 2000; round++) {
+    cJSON *windows = cJSON_CreateArray();
+    cJSON *changed = cJSON_CreateArray();
+    int ids[32];
+    int n = test_random() % 12;
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+      cJSON_AddItemToArray(windows, window(i));
+      if (test_random() % 4) {
+        ids[m++] = i;
+      }
+    }
+    for (int i = 0; i < m; i++) {
+      int j = test_random() % m;
+      int swap = ids[i];
+      ids[i] = ids[j];
+      ids[j] = swap;
+    }
+    for (int i = 0; i < m; i++) {
+      cJSON *w = cJSON_Duplicate(cJSON_GetArrayItem(windows, ids[i]), 1);
+      if (test_random() % 3 == 0) {
+        cJSON_ReplaceItemInObject(w, "title", cJSON_CreateString("z"));
+      }
+      cJSON_AddItemToArray(changed, w);
+    }
+    for (int i = test_random() % 3; i > 0; i--) {
+      cJSON_InsertItemInArray(changed, test_random() % (m + 1), window(100 + i));
+      m++;
+    }
+    from = cJSON_CreateObject();
+    cJSON_AddItemToObject(from, "windows", windows);
+    to = cJSON_CreateObject();
+    cJSON_AddItemToObject(to, "windows", changed);
+
+    cJSON *positional = cJSON_Diff(from, to, NULL);
+    cJSON *keyed = cJSON_Diff(from, to, "id");
+    CHECK(patch_gives(from, positional, to));
+    CHECK(patch_gives(from, keyed, to));
+    cJSON_Delete(positional);
+    cJSON_Delete(keyed);
+    cJSON_Delete(from);
+    cJSON_Delete(to);
+  }
+
+  // Random trees, without duplicate keys as a patch can't express them
+  for (int round = 0; round < 300; round++) {
+    from = cJSON_CreateObject();
+    to = cJSON_CreateObject();
+    for (int i = 0; i < 8; i++) {
+      char key[8];
+      snprintf(key, sizeof(key), "k%d", i);
+      if (test_random() % 4) {
+        cJSON_AddItemToObject(from, key, random_unique_tree(2));
+      }
+      if (test_random() % 4) {
+        cJSON_AddItemToObject(to, key, random_unique_tree(2));
+      }
+    }
+    patch = cJSON_Diff(from, to, NULL);
+    CHECK(patch_gives(from, patch, to));
+    cJSON_Delete(patch);
+    cJSON_Delete(from);
+    cJSON_Delete(to);
+  }
+
+  return test_done();
+}
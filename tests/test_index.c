@@ -0,0 +1,165 @@
+// Child vectors and key hash tables of cJSON_BuildIndex: lookups never build
+// them, and the functions that change children keep them up to date.
+#include "test.h"
+
+// What a lookup has to return: the first member with that key
+static cJSON *walk_lookup(const cJSON *object, const char *key) {
+  for (cJSON *child = object->child; child; child = child->next) {
+    if (strcmp(child->string, key) == 0) {
+      return child;
+    }
+  }
+  return NULL;
+}
+
+static cJSON *walk_item(const cJSON *array, int index) {
+  cJSON *child = array->child;
+  while (child && index-- > 0) {
+    child = child->next;
+  }
+  return child;
+}
+
+static void check_lookups(const cJSON *object) {
+  char key[16];
+  for (int i = 0; i < 80; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    CHECK(cJSON_GetObjectItemCaseSensitive(object, key) ==
+          walk_lookup(object, key));
+    CHECK(cJSON_GetObjectItemByHash(object, key, strlen(key),
+                                    cJSON_HashKey(key, strlen(key))) ==
+          walk_lookup(object, key));
+  }
+  for (int i = -1; i <= cJSON_GetArraySize(object); i++) {
+    CHECK(cJSON_GetArrayItem(object, i) == (i < 0 ? NULL : walk_item(object, i)));
+  }
+}
+
+static size_t allocations;
+
+static void *counting_malloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+int main(void) {
+  cJSON_Hooks hooks = {counting_malloc, free};
+  cJSON_InitHooks(&hooks);
+  cJSON *object = cJSON_CreateObject();
+  char key[16];
+  for (int i = 0; i < 40; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    cJSON_AddNumberToObject(object, key, i);
+  }
+  cJSON_AddNumberToObject(object, "k3", 100);
+
+  // Lookups leave the tree alone, so threads can share it
+  check_lookups(object);
+  CHECK(object->index == NULL);
+
+  CHECK(cJSON_BuildIndex(object));
+  CHECK(object->index != NULL);
+  check_lookups(object);
+  CHECK(cJSON_GetObjectItemCaseSensitive(object, "k3")->valuedouble == 3);
+
+  // Appending, also past the size of the hash table
+  for (int i = 40; i < 80; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    cJSON_AddNumberToObject(object, key, i);
+    CHECK(cJSON_GetObjectItemCaseSensitive(object, key) != NULL);
+  }
+  check_lookups(object);
+
+  // Removing the first of two members with the same key
+  cJSON_DeleteItemFromObjectCaseSensitive(object, "k3");
+  CHECK(cJSON_GetObjectItemCaseSensitive(object, "k3")->valuedouble == 100);
+  cJSON_DeleteItemFromObjectCaseSensitive(object, "k3");
+  CHECK(cJSON_GetObjectItemCaseSensitive(object, "k3") == NULL);
+  check_lookups(object);
+
+  // Replacing and inserting in the middle
+  cJSON_ReplaceItemInObjectCaseSensitive(object, "k10", cJSON_CreateString("x"));
+  CHECK(cJSON_IsString(cJSON_GetObjectItemCaseSensitive(object, "k10")));
+  cJSON *inserted = cJSON_CreateTrue();
+  inserted->string = strcpy(cJSON_malloc(4), "k20");
+  cJSON_InsertItemInArray(object, 5, inserted);
+  CHECK(cJSON_GetObjectItemCaseSensitive(object, "k20") == inserted);
+  CHECK(cJSON_GetArrayItem(object, 5) == inserted);
+  check_lookups(object);
+
+  cJSON *detached = cJSON_DetachItemFromArray(object, 0);
+  CHECK(detached != NULL && cJSON_GetObjectItemCaseSensitive(object, "k0") == NULL);
+  cJSON_Delete(detached);
+  check_lookups(object);
+
+  // Random changes with repeated keys keep the table right
+  for (int round = 0; round < 3000; round++) {
+    int size = cJSON_GetArraySize(object);
+    cJSON *item = cJSON_CreateNumber(round);
+    snprintf(key, sizeof(key), "k%d", (int)(test_random() % 80));
+    switch (test_random() % 4) {
+    case 0:
+      cJSON_AddItemToObject(object, key, item);
+      break;
+    case 1:
+      item->string = strcpy(cJSON_malloc(strlen(key) + 1), key);
+      if (!cJSON_InsertItemInArray(object, test_random() % (size + 1), item)) {
+        cJSON_Delete(item);
+      }
+      break;
+    case 2:
+      cJSON_Delete(item);
+      if (size > 20) {
+        cJSON_DeleteItemFromArray(object, test_random() % size);
+      }
+      break;
+    default:
+      if (size > 0) {
+        item->string = strcpy(cJSON_malloc(strlen(key) + 1), key);
+        cJSON_ReplaceItemInArray(object, test_random() % size, item);
+      } else {
+        cJSON_Delete(item);
+      }
+      break;
+    }
+    if (round % 100 == 0) {
+      check_lookups(object);
+    }
+  }
+  check_lookups(object);
+
+  // Members with keys of their own are taken out of the table in place
+  cJSON *unique = cJSON_CreateObject();
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    cJSON_AddNumberToObject(unique, key, i);
+  }
+  CHECK(cJSON_BuildIndex(unique));
+  size_t before = allocations;
+  for (int i = 0; i < 1000; i += 2) {
+    snprintf(key, sizeof(key), "k%d", i);
+    cJSON_DeleteItemFromObjectCaseSensitive(unique, key);
+  }
+  CHECK(allocations == before);
+  check_lookups(unique);
+  for (int i = 1; i < 1000; i += 2) {
+    snprintf(key, sizeof(key), "k%d", i);
+    cJSON_Delete(cJSON_DetachItemFromObjectCaseSensitive(unique, key));
+    CHECK(cJSON_GetObjectItemCaseSensitive(unique, key) == NULL);
+  }
+  CHECK(allocations == before && unique->child == NULL);
+  cJSON_Delete(unique);
+
+  // Nested arrays/objects are indexed too, small ones aren't
+  cJSON *parsed = cJSON_Parse("{\"small\":{\"a\":1},\"big\":[0,1,2,3,4,5,6,7,8,"
+                              "9,10,11,12,13,14,15,16,17,18,19]}");
+  CHECK(cJSON_BuildIndex(parsed));
+  CHECK(cJSON_GetObjectItem(parsed, "small")->index == NULL);
+  CHECK(cJSON_GetObjectItem(parsed, "big")->index != NULL);
+  CHECK(cJSON_GetArrayItem(cJSON_GetObjectItem(parsed, "big"), 17)->valueint == 17);
+  cJSON_Delete(parsed);
+
+  cJSON_Delete(object);
+  cJSON_InitHooks(NULL);
+  return test_done();
+}
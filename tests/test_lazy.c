@@ -0,0 +1,95 @@
+// Lazily parsed trees read the same as plainly parsed ones.
+#include "test.h"
+
+// Walk item and plain together through the getters, which expand item
+static int same_tree(const cJSON *item, const cJSON *plain) {
+  if ((item->type & 0xFF) != (plain->type & 0xFF)) {
+    return 0;
+  }
+  if (cJSON_GetArraySize(item) != cJSON_GetArraySize(plain)) {
+    return 0;
+  }
+  const cJSON *child = cJSON_GetChild(item);
+  const cJSON *plain_child = plain->child;
+  int index = 0;
+  for (; child && plain_child; child = child->next, plain_child = plain_child->next) {
+    if (cJSON_IsArray(item) && cJSON_GetArrayItem(item, index) != child) {
+      return 0;
+    }
+    if ((child->string || plain_child->string) &&
+        (!child->string || !plain_child->string ||
+         strcmp(child->string, plain_child->string) != 0)) {
+      return 0;
+    }
+    if (!same_tree(child, plain_child)) {
+      return 0;
+    }
+    index++;
+  }
+  return child == plain_child;
+}
+
+int main(void) {
+  const char *json = "{\"windows\":[{\"id\":1,\"title\":\"a\\u00e9\","
+                     "\"layout\":{\"pos\":[1,2]}},{\"id\":2,\"title\":\"b\"}],"
+                     "\"focused\":2,\"names\":[\"x\",\"y\"],\"empty\":{}}";
+  cJSON *lazy = cJSON_ParseLazy(json, strlen(json));
+  cJSON *plain = cJSON_Parse(json);
+
+  // Only what is looked at gets parsed
+  cJSON *windows = cJSON_GetObjectItem(lazy, "windows");
+  CHECK(cJSON_GetArraySize(windows) == 2);
+  cJSON *second = cJSON_GetArrayItem(windows, 1);
+  CHECK(cJSON_GetObjectItem(second, "id")->valueint == 2);
+  CHECK(cJSON_GetObjectItem(lazy, "focused")->valueint == 2);
+  int names = 0;
+  cJSON *name;
+  cJSON_ArrayForEach(name, cJSON_GetObjectItem(lazy, "names")) { names++; }
+  CHECK(names == 2);
+  CHECK(same_tree(lazy, plain));
+  CHECK(cJSON_Compare(lazy, plain, 1));
+  cJSON_Delete(lazy);
+
+  // Printing parses the rest
+  lazy = cJSON_ParseLazy(json, strlen(json));
+  CHECK_JSON(lazy, "{\"windows\":[{\"id\":1,\"title\":\"a\xc3\xa9\","
+                   "\"layout\":{\"pos\":[1,2]}},{\"id\":2,\"title\":\"b\"}],"
+                   "\"focused\":2,\"names\":[\"x\",\"y\"],\"empty\":{}}");
+  cJSON_Delete(lazy);
+  lazy = cJSON_ParseLazy(json, strlen(json));
+  cJSON *copy = cJSON_Duplicate(lazy, 1);
+  CHECK(cJSON_Compare(copy, plain, 1));
+  cJSON_Delete(copy);
+  cJSON_Delete(lazy);
+  cJSON_Delete(plain);
+
+  for (int i = 0; i < 200; i++) {
+    cJSON *tree = test_random_tree(0);
+    char *printed = cJSON_PrintUnformatted(tree);
+    lazy = cJSON_ParseLazy(printed, strlen(printed));
+    plain = cJSON_Parse(printed);
+    CHECK(same_tree(lazy, plain));
+    cJSON_Delete(lazy);
+    lazy = cJSON_ParseLazy(printed, strlen(printed));
+    CHECK_JSON(lazy, printed);
+    cJSON_Delete(lazy);
+    cJSON_Delete(plain);
+    cJSON_free(printed);
+    cJSON_Delete(tree);
+  }
+
+  // Errors at the top level fail the parse, errors inside a nested array or
+  // object leave it empty and printing fails
+  CHECK(cJSON_ParseLazy("{\"a\":1,}", 8) == NULL);
+  CHECK(cJSON_ParseLazy("[[1]", 4) == NULL);
+  lazy = cJSON_ParseLazy("{\"a\":[1,,2],\"b\":3}", 18);
+  CHECK(lazy != NULL);
+  CHECK(cJSON_GetObjectItem(lazy, "b")->valueint == 3);
+  CHECK(cJSON_GetArraySize(cJSON_GetObjectItem(lazy, "a")) == 0);
+  char *printed = cJSON_PrintUnformatted(lazy);
+  CHECK(printed == NULL);
+  cJSON_free(printed);
+  cJSON_Delete(lazy);
+
+  return test_done();
+}
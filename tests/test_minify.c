@@ -0,0 +1,161 @@
+// cJSON_Minify and cJSON_MinifyChunk against the byte at a time minifier
+// cJSON used to have, on text whose quotes, backslashes and comments fall
+// anywhere relative to 8 byte words and chunk boundaries.
+#include "test.h"
+
+// The original cJSON_Minify, one character at a time
+static void reference_minify(char *json) {
+  char *into = json;
+  while (*json) {
+    switch (*json) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      json++;
+      break;
+    case '/':
+      if (json[1] == '/') {
+        json += 2;
+        while (*json && *json != '\n') {
+          json++;
+        }
+        if (*json) {
+          json++;
+        }
+      } else if (json[1] == '*') {
+        json += 2;
+        while (*json && !(json[0] == '*' && json[1] == '/')) {
+          json++;
+        }
+        if (*json) {
+          json += 2;
+        }
+      } else {
+        json++;
+      }
+      break;
+    case '\"':
+      *into++ = *json++;
+      while (*json && *json != '\"') {
+        if (*json == '\\' && json[1]) {
+          *into++ = *json++;
+        }
+        *into++ = *json++;
+      }
+      if (*json) {
+        *into++ = *json++;
+      }
+      break;
+    default:
+      *into++ = *json++;
+      break;
+    }
+  }
+  *into = '\0';
+}
+
+// Text made of pieces that start and end strings, escapes and comments
+static void random_text(char *text, size_t size) {
+  static const char *const pieces[] = {
+      "\"",       "\\",        "\\\"",      "\"\"\"\"", "\\\\\\\\", "/",
+      "*",        "//",        "/*",        "*/",       "/**/",     " ",
+      "\n",       "\t",        "\r",        "        ", "a",        "abcdefgh",
+      "{\"k\":[", "]}",        ",",         "\x01",     "\xc3\xa9", "0123456789",
+      "\"ab/*c\"", "// x\n",   "/* \" */"};
+  size_t length = 0;
+  text[0] = '\0';
+  for (;;) {
+    const char *piece = pieces[test_random() % (sizeof(pieces) / sizeof(*pieces))];
+    if (length + strlen(piece) + 1 > size) {
+      return;
+    }
+    strcpy(text + length, piece);
+    length += strlen(piece);
+  }
+}
+
+// Minify text in chunks of the given sizes, in place if in_place
+static size_t minify_chunks(const char *text, char *output, size_t chunk,
+                            int in_place) {
+  cJSON_Minifier minifier;
+  size_t length = strlen(text);
+  size_t written = 0;
+  char copy[512];
+  cJSON_InitMinifier(&minifier);
+  for (size_t offset = 0; offset < length; offset += chunk) {
+    size_t size = length - offset < chunk ? length - offset : chunk;
+    if (in_place) {
+      memcpy(copy, text + offset, size);
+      size_t n = cJSON_MinifyChunk(&minifier, copy, size, copy);
+      memcpy(output + written, copy, n);
+      written += n;
+    } else {
+      written += cJSON_MinifyChunk(&minifier, text + offset, size,
+                                   output + written);
+    }
+  }
+  output[written] = '\0';
+  return written;
+}
+
+static void check_minify(const char *text) {
+  char expected[512];
+  char actual[512 + 8];
+  strcpy(expected, text);
+  reference_minify(expected);
+
+  // In place, starting at every offset into a word
+  for (size_t misalign = 0; misalign < 8; misalign++) {
+    strcpy(actual + misalign, text);
+    cJSON_Minify(actual + misalign);
+    if (strcmp(actual + misalign, expected) != 0) {
+      fprintf(stderr, "minified \"%s\" at offset %zu to \"%s\", expected \"%s\"\n",
+              text, misalign, actual + misalign, expected);
+      test_failures++;
+    }
+  }
+
+  // In chunks of every size up to a few words
+  for (size_t chunk = 1; chunk <= 20; chunk++) {
+    for (int in_place = 0; in_place < 2; in_place++) {
+      minify_chunks(text, actual, chunk, in_place);
+      if (strcmp(actual, expected) != 0) {
+        fprintf(stderr, "minified \"%s\" in chunks of %zu to \"%s\", expected \"%s\"\n",
+                text, chunk, actual, expected);
+        test_failures++;
+      }
+    }
+  }
+}
+
+int main(void) {
+  char text[256];
+
+  check_minify("");
+  check_minify("{ \"a\" : [ 1 , 2 ] }");
+  check_minify("\"1234567\\\"89abcdef\\\\\" \"\\\\\\\\\\\\\\\\\\\"\"  x");
+  check_minify("[\"http://x/*y*/\"] // \"comment\n/* \"block\" **/ 1");
+  check_minify("/*/ still a comment */2/ 3 /* unterminated");
+  check_minify("1 // unterminated");
+  check_minify("\"unterminated \\");
+  check_minify("{\n        \"indented\":        \"        spaces kept\"\n}");
+
+  for (int i = 0; i < 3000; i++) {
+    random_text(text, 8 + test_random() % (sizeof(text) - 8));
+    check_minify(text);
+  }
+
+  // A minifier carries its state from one call to the next
+  cJSON_Minifier minifier;
+  char output[16];
+  cJSON_InitMinifier(&minifier);
+  CHECK(cJSON_MinifyChunk(&minifier, "[\"a ", 4, output) == 4);
+  CHECK(cJSON_MinifyChunk(&minifier, "b\" /", 4, output) == 2);
+  CHECK(memcmp(output, "b\"", 2) == 0);
+  CHECK(cJSON_MinifyChunk(&minifier, "* ] */]", 7, output) == 1);
+  CHECK(output[0] == ']');
+  CHECK(cJSON_MinifyChunk(NULL, "1", 1, output) == 0);
+
+  return test_done();
+}
@@ -0,0 +1,134 @@
+// Event lines decoded by niri_read_event, whole and split into segments like
+// the daemon reads them.
+#include "niri_events.h"
+#include "test.h"
+
+static int read_line(const char *line, niri_event_t *event) {
+  cJSON_Reader reader;
+  cJSON_InitReader(&reader, line, strlen(line));
+  int ok = niri_read_event(&reader, event);
+  cJSON_ReaderRelease(&reader);
+  return ok;
+}
+
+// Same line cut into pieces of at most size bytes
+static int read_segmented(const char *line, size_t size, niri_event_t *event) {
+  cJSON_Segment segments[256];
+  size_t n = 0;
+  size_t len = strlen(line);
+  for (size_t offset = 0; offset < len; offset += size) {
+    segments[n].data = line + offset;
+    segments[n].length = len - offset < size ? len - offset : size;
+    n++;
+  }
+  cJSON_Reader reader;
+  cJSON_InitSegmentReader(&reader, segments, n);
+  int ok = niri_read_event(&reader, event);
+  cJSON_ReaderRelease(&reader);
+  return ok;
+}
+
+int main(void) {
+  niri_event_t event;
+
+  CHECK(read_line("{\"KeyboardLayoutSwitched\":{\"idx\":1}}", &event));
+  CHECK(event.type == NIRI_EVENT_KeyboardLayoutSwitched);
+  CHECK(event.u.KeyboardLayoutSwitched.has_idx);
+  CHECK(event.u.KeyboardLayoutSwitched.idx == 1);
+  niri_free_event(&event);
+
+  // Missing and null members are not 0
+  CHECK(read_line("{\"KeyboardLayoutSwitched\":{}}", &event));
+  CHECK(event.type == NIRI_EVENT_KeyboardLayoutSwitched);
+  CHECK(!event.u.KeyboardLayoutSwitched.has_idx);
+  niri_free_event(&event);
+  CHECK(read_line("{\"KeyboardLayoutSwitched\":{\"idx\":null}}", &event));
+  CHECK(!event.u.KeyboardLayoutSwitched.has_idx);
+  niri_free_event(&event);
+  CHECK(read_line("{\"KeyboardLayoutSwitched\":{\"idx\":\"1\"}}", &event));
+  CHECK(!event.u.KeyboardLayoutSwitched.has_idx);
+  niri_free_event(&event);
+
+  CHECK(read_line("{\"WindowFocusChanged\":{\"id\":null}}", &event));
+  CHECK(event.type == NIRI_EVENT_WindowFocusChanged);
+  CHECK(!event.u.WindowFocusChanged.has_id);
+  niri_free_event(&event);
+  CHECK(read_line("{\"WindowFocusChanged\":{\"id\":0}}", &event));
+  CHECK(event.u.WindowFocusChanged.has_id && event.u.WindowFocusChanged.id == 0);
+  niri_free_event(&event);
+  CHECK(read_line("{\"WindowFocusChanged\":{\"id\":9007199254740993}}", &event));
+  CHECK(event.u.WindowFocusChanged.id == 9007199254740993LL);
+  niri_free_event(&event);
+
+  const char *layouts = "{\"KeyboardLayoutsChanged\":{\"keyboard_layouts\":"
+                        "{\"names\":[\"English (US)\",7,\"Deutsch\"],"
+                        "\"current_idx\":1,\"extra\":[{\"a\":[]}]}}}";
+  CHECK(read_line(layouts, &event));
+  niri_keyboard_layouts_t *kl = &event.u.KeyboardLayoutsChanged.keyboard_layouts;
+  CHECK(event.u.KeyboardLayoutsChanged.has_keyboard_layouts);
+  CHECK(kl->has_names && kl->n_names == 2);
+  CHECK(kl->n_names == 2 && strcmp(kl->names[0], "English (US)") == 0 &&
+        strcmp(kl->names[1], "Deutsch") == 0);
+  CHECK(kl->has_current_idx && kl->current_idx == 1);
+  niri_free_event(&event);
+
+  // Segments of every size decode the same
+  for (size_t size = 1; size < 8; size++) {
+    CHECK(read_segmented(layouts, size, &event));
+    CHECK(kl->n_names == 2 && strcmp(kl->names[1], "Deutsch") == 0);
+    CHECK(kl->current_idx == 1);
+    niri_free_event(&event);
+  }
+
+  // Escaped keys are the same names
+  CHECK(read_line("{\"Keyboard\\u004cayoutSwitched\":{\"i\\u0064x\":2}}",
+                  &event));
+  CHECK(event.type == NIRI_EVENT_KeyboardLayoutSwitched);
+  CHECK(event.u.KeyboardLayoutSwitched.idx == 2);
+  niri_free_event(&event);
+
+  // Unknown events and documents that are no event are skipped
+  CHECK(read_line("{\"ConfigLoaded\":{\"failed\":false}}", &event));
+  CHECK(event.type == NIRI_EVENT_UNKNOWN);
+  niri_free_event(&event);
+  CHECK(read_line("{\"Ok\":\"Handled\"}", &event));
+  CHECK(event.type == NIRI_EVENT_Ok);
+  niri_free_event(&event);
+  CHECK(read_line("{}", &event) && event.type == NIRI_EVENT_UNKNOWN);
+  CHECK(read_line("[1,2]", &event) && event.type == NIRI_EVENT_UNKNOWN);
+  CHECK(read_line("\"EventStream\"", &event));
+  CHECK(read_line("{\"KeyboardLayoutSwitched\":5}", &event));
+  CHECK(!event.u.KeyboardLayoutSwitched.has_idx);
+
+  // Invalid JSON anywhere in the line
+  CHECK(!read_line("{\"KeyboardLayoutSwitched\":{\"idx\":1}} x", &event));
+  niri_free_event(&event);
+  CHECK(!read_line("{\"KeyboardLayoutSwitched\":{\"idx\":1}}{}", &event));
+  niri_free_event(&event);
+  CHECK(!read_line("{\"KeyboardLayoutSwitched\":{\"idx\":1,\"a\":}}", &event));
+  niri_free_event(&event);
+  CHECK(!read_line("{\"KeyboardLayoutSwitched\":{\"idx\":1},\"b\":[}", &event));
+  niri_free_event(&event);
+  CHECK(!read_line("{\"Ok\":1,}", &event));
+  niri_free_event(&event);
+  CHECK(!read_line("[1,]", &event));
+  CHECK(!read_line("", &event));
+  CHECK(!read_line("{\"KeyboardLayoutsChanged\":{\"keyboard_layouts\":"
+                   "{\"names\":[\"a\",\"b\"]",
+                   &event));
+  niri_free_event(&event);
+
+  // The reader tells invalid JSON from a failed allocation
+  const char *invalid = "{\"KeyboardLayoutSwitched\":{\"idx\":1,}}";
+  cJSON_Segment halves[] = {{invalid, 20}, {invalid + 20, strlen(invalid) - 20}};
+  cJSON_Reader reader;
+  cJSON_Token token;
+  cJSON_InitSegmentReader(&reader, halves, 2);
+  CHECK(!niri_read_event(&reader, &event));
+  CHECK(reader.error_position == 35);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenError);
+  cJSON_ReaderRelease(&reader);
+  niri_free_event(&event);
+
+  return test_done();
+}
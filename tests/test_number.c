@@ -0,0 +1,69 @@
+// Numbers printed with Grisu2 and the integer printer read back as exactly
+// the same value.
+#include "test.h"
+#include <math.h>
+
+static void check_double(double number) {
+  cJSON *item = cJSON_CreateNumber(number);
+  char *printed = cJSON_PrintUnformatted(item);
+  double back = printed ? strtod(printed, NULL) : NAN;
+  if (memcmp(&number, &back, sizeof(number)) != 0 &&
+      !(number == 0 && back == 0)) {
+    fprintf(stderr, "%.17g printed as %s\n", number, printed);
+    test_failures++;
+  }
+  CHECK(printed && strlen(printed) == cJSON_PrintedLength(item, 0));
+  cJSON_free(printed);
+  cJSON_Delete(item);
+}
+
+static void check_int64(cJSON_int64 number) {
+  cJSON *item = cJSON_CreateInt64(number);
+  char *printed = cJSON_PrintUnformatted(item);
+  cJSON *back = printed ? cJSON_Parse(printed) : NULL;
+  CHECK(back && cJSON_IsInt64(back) && cJSON_GetInt64Value(back) == number);
+  cJSON_Delete(back);
+  cJSON_free(printed);
+  cJSON_Delete(item);
+}
+
+int main(void) {
+  static const double doubles[] = {
+      0.0, -0.0, 1.0, -1.0, 0.1, 0.3, 1.0 / 3, 2.5e-324, 2.2250738585072014e-308,
+      1.7976931348623157e308, 5e-324, 123456789012345680.0, 1e21, 1e22, 1e23,
+      9007199254740993.0, -2.169627238865771e-283, 4.4200448961730265e+87,
+      299989, 0.000001, 1e-7};
+  for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++) {
+    check_double(doubles[i]);
+  }
+
+  // Random bit patterns cover every exponent, quotients the short decimals
+  for (int i = 0; i < 200000; i++) {
+    unsigned long long bits = test_random();
+    double number;
+    memcpy(&number, &bits, sizeof(number));
+    if (isfinite(number)) {
+      check_double(number);
+    }
+    check_double((double)(test_random() % 100000) /
+                 (double)(1 + test_random() % 1000));
+  }
+
+  static const cJSON_int64 integers[] = {
+      0, 1, -1, 9, 10, 99, 100, 2147483647, -2147483648LL, 4294967296LL,
+      9007199254740993LL, -2139181883398957458LL, 6414703033599903323LL,
+      9223372036854775807LL, -9223372036854775807LL - 1};
+  for (size_t i = 0; i < sizeof(integers) / sizeof(integers[0]); i++) {
+    check_int64(integers[i]);
+  }
+  for (int i = 0; i < 100000; i++) {
+    check_int64((cJSON_int64)test_random());
+  }
+
+  // Integer literals are kept exactly, others go through doubles
+  cJSON *parsed = cJSON_Parse("[12345678901234567890123,-0,1.5e3,123456789012345678]");
+  CHECK_JSON(parsed, "[1.2345678901234568e+22,0,1500,123456789012345678]");
+  cJSON_Delete(parsed);
+
+  return test_done();
+}
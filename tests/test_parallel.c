@@ -0,0 +1,110 @@
+// cJSON_ParseParallel on real threads: above and below the threshold the tree
+// is the one cJSON_ParseWithLength gives, and errors inside any thread's part
+// of the array are reported the same way.
+#include "test.h"
+
+#ifndef ENABLE_THREADS
+#error "built without threads, see tests/test_parallel in the Makefile"
+#endif
+
+// Text of {"windows":[...]} with elements until it is at least size bytes,
+// strings with brackets and commas in between to mislead the split
+static char *windows_document(size_t size) {
+  cJSON *document = cJSON_CreateObject();
+  cJSON *windows = cJSON_AddArrayToObject(document, "windows");
+  char *text = NULL;
+  for (int i = 0; !text || strlen(text) < size; i++) {
+    cJSON *window = test_random_tree(1);
+    test_remove_duplicate_keys(window);
+    cJSON_AddItemToArray(windows, window);
+    if (i % 7 == 0) {
+      cJSON_AddItemToArray(windows, cJSON_CreateString("],[{\"a\",}"));
+    }
+    if (i % 64 == 0 || strlen(text) >= size) {
+      cJSON_free(text);
+      text = cJSON_PrintUnformatted(document);
+    }
+  }
+  cJSON_Delete(document);
+  return text;
+}
+
+static void check_same_as_sequential(const char *text, unsigned int threads) {
+  size_t length = strlen(text);
+  cJSON *expected = cJSON_ParseWithLength(text, length);
+  cJSON *parallel = cJSON_ParseParallel(text, length, threads);
+  CHECK(expected != NULL && parallel != NULL);
+  CHECK(cJSON_Compare(parallel, expected, 1));
+
+  // The linked chunks are one proper list
+  cJSON *windows = cJSON_GetObjectItemCaseSensitive(parallel, "windows");
+  cJSON *expected_windows = cJSON_GetObjectItemCaseSensitive(expected, "windows");
+  CHECK(cJSON_GetArraySize(windows) == cJSON_GetArraySize(expected_windows));
+  int count = 0;
+  cJSON *last = NULL;
+  for (cJSON *child = windows ? windows->child : NULL; child;
+       child = child->next) {
+    CHECK(child->prev != NULL);
+    CHECK(child == windows->child || child->prev->next == child);
+    last = child;
+    count++;
+  }
+  CHECK(count == cJSON_GetArraySize(windows));
+  CHECK(windows && windows->child && windows->child->prev == last);
+
+  cJSON_Delete(expected);
+  cJSON_Delete(parallel);
+}
+
+// Break the element that starts at about fraction of the text
+static void check_error_at(char *text, double fraction, unsigned int threads) {
+  size_t length = strlen(text);
+  char *broken = strdup(text);
+  char *at = strstr(broken + (size_t)(length * fraction), ",{");
+  CHECK(at != NULL);
+  if (!at) {
+    free(broken);
+    return;
+  }
+  at[1] = '}';
+
+  CHECK(cJSON_ParseWithLength(broken, length) == NULL);
+  const char *expected_error = cJSON_GetErrorPtr();
+  CHECK(expected_error == at + 1);
+  CHECK(cJSON_ParseParallel(broken, length, threads) == NULL);
+  CHECK(cJSON_GetErrorPtr() == expected_error);
+  free(broken);
+}
+
+int main(void) {
+  char *small = windows_document(CJSON_PARALLEL_THRESHOLD / 4);
+  char *big = windows_document(CJSON_PARALLEL_THRESHOLD * 3);
+  CHECK(strlen(small) < CJSON_PARALLEL_THRESHOLD);
+
+  unsigned int thread_counts[] = {0, 1, 2, 3, 8, 16, 100};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); i++) {
+    check_same_as_sequential(small, thread_counts[i]);
+    check_same_as_sequential(big, thread_counts[i]);
+  }
+
+  // An error in the part of the first, a middle and the last thread
+  check_error_at(big, 0.01, 4);
+  check_error_at(big, 0.5, 4);
+  check_error_at(big, 0.99, 4);
+  check_error_at(big, 0.6, 16);
+  // Truncated in the middle of the array
+  size_t length = strlen(big);
+  CHECK(cJSON_ParseParallel(big, length - length / 3, 4) == NULL);
+  CHECK(cJSON_ParseParallel(big, length - 1, 4) == NULL);
+
+  // Items of the threads don't come from the node pool, deleting them
+  // together with pooled ones is fine
+  cJSON_EnableNodePool(1);
+  check_same_as_sequential(big, 4);
+  cJSON_EnableNodePool(0);
+  CHECK(cJSON_ReleaseNodePool());
+
+  cJSON_free(small);
+  cJSON_free(big);
+  return test_done();
+}
@@ -0,0 +1,86 @@
+// Parsing into the items of an old tree gives the same tree as a new parse.
+#include "test.h"
+
+static size_t allocations;
+static size_t frees;
+
+static void *counting_malloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+static void counting_free(void *pointer) {
+  if (pointer) {
+    frees++;
+  }
+  free(pointer);
+}
+
+static int same_as_parse(cJSON *tree, const char *json) {
+  cJSON *plain = cJSON_Parse(json);
+  char *expected = cJSON_PrintUnformatted(plain);
+  char *printed = cJSON_PrintUnformatted(tree);
+  // cJSON_Compare doesn't handle the duplicate keys of random trees
+  int same = expected && printed && strcmp(expected, printed) == 0;
+  cJSON_free(printed);
+  cJSON_free(expected);
+  cJSON_Delete(plain);
+  return same;
+}
+
+int main(void) {
+  // Documents of other shapes one after another, and random ones
+  const char *documents[] = {
+      "{\"a\":[1,2,3],\"b\":\"short\",\"c\":{\"d\":null}}",
+      "{\"a\":[1,2,3,4,5],\"b\":\"a longer string than before\",\"c\":{}}",
+      "[true,false,\"x\",{\"k\":\"v\"}]",
+      "12345678901234567890",
+      "{\"a\":[1,2,3],\"b\":\"short\",\"c\":{\"d\":null}}",
+  };
+  cJSON *tree = NULL;
+  for (size_t i = 0; i < sizeof(documents) / sizeof(*documents); i++) {
+    tree = cJSON_ParseInto(tree, documents[i], strlen(documents[i]) + 1);
+    CHECK(same_as_parse(tree, documents[i]));
+  }
+  for (int i = 0; i < 200; i++) {
+    cJSON *random = test_random_tree(0);
+    char *json = cJSON_PrintUnformatted(random);
+    tree = cJSON_ParseInto(tree, json, strlen(json) + 1);
+    CHECK(same_as_parse(tree, json));
+    cJSON_free(json);
+    cJSON_Delete(random);
+  }
+
+  // Failing parses use up the tree and set the error like cJSON_Parse
+  const char *invalid = "{\"a\":[1,2,}";
+  tree = cJSON_ParseInto(tree, invalid, strlen(invalid));
+  CHECK(tree == NULL);
+  CHECK(cJSON_GetErrorPtr() == invalid + 10);
+  tree = cJSON_ParseInto(cJSON_Parse("[1]"), "[2]", 3);
+  CHECK_JSON(tree, "[2]");
+  CHECK(cJSON_GetErrorPtr() == NULL);
+  cJSON_Delete(tree);
+
+  // A tree from a context goes back to the hooks of the context
+  cJSON_ParseContext context;
+  cJSON_InitParseContext(&context);
+  context.hooks.malloc_fn = counting_malloc;
+  context.hooks.free_fn = counting_free;
+  const char *json = "{\"name\":\"first\",\"list\":[1,2,3]}";
+  tree = cJSON_ParseWithContext(&context, json, strlen(json));
+  size_t parsed = allocations;
+  json = "{\"name\":\"other\",\"list\":[4,5,6]}";
+  tree = cJSON_ParseIntoWithContext(&context, tree, json, strlen(json));
+  CHECK(allocations == parsed);
+  CHECK(same_as_parse(tree, json));
+  json = "{\"name\":\"x\"}";
+  tree = cJSON_ParseIntoWithContext(&context, tree, json, strlen(json));
+  CHECK(same_as_parse(tree, json));
+  context.reject_trailing = 1;
+  json = "[1] x";
+  tree = cJSON_ParseIntoWithContext(&context, tree, json, strlen(json));
+  CHECK(tree == NULL && context.position == 4);
+  CHECK(allocations == frees);
+
+  return test_done();
+}
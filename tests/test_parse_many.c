@@ -0,0 +1,109 @@
+// Newline delimited batches through cJSON_ParseMany: which lines reach the
+// callback, how many bytes are used up and where errors are reported.
+#include "test.h"
+
+#define MAX_LINES 16
+
+typedef struct {
+  char *printed[MAX_LINES]; // NULL for invalid lines
+  size_t error_offset[MAX_LINES];
+  size_t length[MAX_LINES];
+  size_t count;
+  size_t stop_after; // 0 to take every line
+} batch_t;
+
+static cJSON_bool collect(cJSON *item, const char *line, size_t length,
+                          void *user) {
+  batch_t *batch = user;
+  CHECK(batch->count < MAX_LINES);
+  if (batch->count < MAX_LINES) {
+    size_t i = batch->count++;
+    batch->printed[i] = item ? cJSON_PrintUnformatted(item) : NULL;
+    batch->length[i] = length;
+    batch->error_offset[i] = 0;
+    if (!item) {
+      const char *error = cJSON_GetErrorPtr();
+      CHECK(error != NULL && error >= line && error <= line + length);
+      batch->error_offset[i] = error ? (size_t)(error - line) : 0;
+    }
+  }
+  cJSON_Delete(item);
+  return batch->stop_after == 0 || batch->count < batch->stop_after;
+}
+
+static void free_batch(batch_t *batch) {
+  for (size_t i = 0; i < batch->count; i++) {
+    cJSON_free(batch->printed[i]);
+  }
+  memset(batch, 0, sizeof(*batch));
+}
+
+static size_t parse_many(const char *text, batch_t *batch) {
+  return cJSON_ParseMany(text, strlen(text), collect, batch);
+}
+
+#define CHECK_LINE(batch, i, expected)                                         \
+  CHECK((batch).printed[i] && strcmp((batch).printed[i], expected) == 0)
+
+int main(void) {
+  batch_t batch = {0};
+
+  // Blank lines, also ones of whitespace, don't reach the callback
+  const char *blank = "\n[1]\n\n \t\r\n{\"a\":2}\r\n\n";
+  CHECK(parse_many(blank, &batch) == strlen(blank));
+  CHECK(batch.count == 2);
+  CHECK_LINE(batch, 0, "[1]");
+  CHECK_LINE(batch, 1, "{\"a\":2}");
+  CHECK(batch.length[1] == 8);
+  free_batch(&batch);
+  CHECK(parse_many("\n\n\n", &batch) == 3 && batch.count == 0);
+  CHECK(parse_many("", &batch) == 0 && batch.count == 0);
+
+  // A final line without a newline is left for the next call
+  const char *unfinished = "1\n2\n{\"a\":";
+  CHECK(parse_many(unfinished, &batch) == 4);
+  CHECK(batch.count == 2);
+  CHECK_LINE(batch, 1, "2");
+  free_batch(&batch);
+  CHECK(parse_many("[1,2]", &batch) == 0 && batch.count == 0);
+
+  // Returning false stops after that line, the bytes used end after it
+  const char *many = "1\n\n2\n3\n4\n";
+  batch.stop_after = 2;
+  CHECK(parse_many(many, &batch) == 5);
+  CHECK(batch.count == 2);
+  CHECK_LINE(batch, 1, "2");
+  free_batch(&batch);
+  batch.stop_after = 1;
+  CHECK(parse_many("x\n2\n", &batch) == 2);
+  CHECK(batch.count == 1 && batch.printed[0] == NULL);
+  free_batch(&batch);
+
+  // Bad lines in the middle of a batch are handed over with the offset of the
+  // error in the line, the lines around them still parse
+  const char *mixed = "{\"a\":1}\n"
+                      "{\"a\":1,}\n"
+                      "[1,2] 3\n"
+                      "  [\"x\", tru]  \n"
+                      "[true]\n";
+  CHECK(parse_many(mixed, &batch) == strlen(mixed));
+  CHECK(batch.count == 5);
+  CHECK_LINE(batch, 0, "{\"a\":1}");
+  CHECK(batch.printed[1] == NULL && batch.error_offset[1] == 7);
+  CHECK(batch.length[1] == 8);
+  CHECK(batch.printed[2] == NULL && batch.error_offset[2] == 6);
+  CHECK(batch.printed[3] == NULL && batch.error_offset[3] == 8);
+  CHECK_LINE(batch, 4, "[true]");
+  free_batch(&batch);
+
+  // The parse of a line stops at its newline
+  CHECK(parse_many("[1,\n2]\n", &batch) == 7);
+  CHECK(batch.count == 2);
+  CHECK(batch.printed[0] == NULL && batch.printed[1] == NULL);
+  free_batch(&batch);
+
+  CHECK(cJSON_ParseMany(NULL, 2, collect, &batch) == 0);
+  CHECK(cJSON_ParseMany("1\n", 2, NULL, &batch) == 0);
+
+  return test_done();
+}
@@ -0,0 +1,79 @@
+// Node pool: items are recycled across parses and every call to malloc_fn
+// shows up in the pool statistics.
+#include "test.h"
+
+static const char layouts_changed[] =
+    "{\"KeyboardLayoutsChanged\":{\"keyboard_layouts\":"
+    "{\"names\":[\"English (US)\",\"Swedish\"],\"current_idx\":0}}}";
+
+static size_t malloc_calls;
+
+static void *counting_malloc(size_t size) {
+  malloc_calls++;
+  return malloc(size);
+}
+
+static size_t counted(const cJSON_PoolStats *stats) {
+  return stats->slab_allocations + stats->item_allocations +
+         stats->string_allocations;
+}
+
+int main(void) {
+  cJSON_Hooks hooks = {counting_malloc, free};
+  cJSON_PoolStats before, after;
+  cJSON *tree = NULL;
+
+  cJSON_InitHooks(&hooks);
+  cJSON_EnableNodePool(1);
+
+  // Warm up the pool, then every parse takes its items from the free list
+  cJSON_Delete(cJSON_Parse(layouts_changed));
+  for (int i = 0; i < 3; i++) {
+    cJSON_GetPoolStats(&before);
+    malloc_calls = 0;
+    tree = cJSON_Parse(layouts_changed);
+    CHECK(tree != NULL);
+    cJSON_Delete(tree);
+    cJSON_GetPoolStats(&after);
+
+    CHECK(after.slab_allocations == before.slab_allocations);
+    CHECK(after.item_allocations == before.item_allocations);
+    CHECK(after.pool_allocations - before.pool_allocations == 7);
+    CHECK(after.items_in_use == 0);
+    // keys and names are still allocated, and counted
+    CHECK(after.string_allocations - before.string_allocations == 6);
+    CHECK(counted(&after) - counted(&before) == malloc_calls);
+  }
+
+  // Reusing the strings as well leaves nothing to allocate
+  tree = cJSON_Parse(layouts_changed);
+  for (int i = 0; i < 3; i++) {
+    cJSON_GetPoolStats(&before);
+    malloc_calls = 0;
+    tree = cJSON_ParseInto(tree, layouts_changed, sizeof(layouts_changed) - 1);
+    CHECK(tree != NULL);
+    cJSON_GetPoolStats(&after);
+    CHECK(malloc_calls == 0);
+    CHECK(counted(&after) == counted(&before));
+  }
+  cJSON_Delete(tree);
+
+  // Items created by hand are counted too
+  cJSON_EnableNodePool(0);
+  cJSON_GetPoolStats(&before);
+  malloc_calls = 0;
+  tree = cJSON_CreateObject();
+  cJSON_AddStringToObject(tree, "name", "Swedish");
+  // a number literal too long for the stack buffer of the parser
+  cJSON_AddItemToObject(
+      tree, "long",
+      cJSON_Parse("0.12345678901234567890123456789012345678901234567890"
+                  "1234567890123456789012345678901234567890"));
+  cJSON_GetPoolStats(&after);
+  CHECK(counted(&after) - counted(&before) == malloc_calls);
+  cJSON_Delete(tree);
+
+  CHECK(cJSON_ReleaseNodePool());
+  cJSON_InitHooks(NULL);
+  return test_done();
+}
@@ -0,0 +1,65 @@
+// Printing sizes its output with cJSON_PrintedLength up front, so the
+// measured length has to be exactly what gets printed.
+#include "test.h"
+
+static void check_printed_length(const cJSON *item, cJSON_bool format) {
+  char *printed = format ? cJSON_Print(item) : cJSON_PrintUnformatted(item);
+  CHECK(printed != NULL);
+  if (printed && strlen(printed) != cJSON_PrintedLength(item, format)) {
+    fprintf(stderr, "measured %zu for %zu characters: %.200s\n",
+            cJSON_PrintedLength(item, format), strlen(printed), printed);
+    test_failures++;
+  }
+  cJSON_free(printed);
+}
+
+int main(void) {
+  cJSON_Printer *printer = cJSON_CreatePrinter();
+
+  for (int i = 0; i < 3000; i++) {
+    cJSON *tree = test_random_tree(0);
+    check_printed_length(tree, 0);
+    check_printed_length(tree, 1);
+
+    // The printer and a buffer of exactly the measured size print the same
+    char *expected = cJSON_Print(tree);
+    size_t length = 0;
+    const char *reused = cJSON_PrinterPrint(printer, tree, 1, &length);
+    CHECK(reused && expected && strcmp(reused, expected) == 0);
+    CHECK(length == cJSON_PrintedLength(tree, 1));
+    char *exact = malloc(length + 1);
+    CHECK(cJSON_PrintPreallocated(tree, exact, (int)length + 1, 1));
+    CHECK(strcmp(exact, expected) == 0);
+    free(exact);
+    cJSON_free(expected);
+    cJSON_Delete(tree);
+  }
+
+  // Escapes at both ends and across 8 byte blocks fill the reserved space
+  cJSON *escaped = cJSON_CreateString("\"abcdefgh\\\x01ijklmnop\n\"");
+  CHECK_JSON(escaped, "\"\\\"abcdefgh\\\\\\u0001ijklmnop\\n\\\"\"");
+  char exact_escaped[40];
+  CHECK(cJSON_PrintedLength(escaped, 0) == 32);
+  CHECK(cJSON_PrintPreallocated(escaped, exact_escaped, 33, 0));
+  CHECK(!cJSON_PrintPreallocated(escaped, exact_escaped, 32, 0));
+  cJSON_Delete(escaped);
+
+  // An empty raw value is printed as nothing, not an error
+  cJSON *object = cJSON_CreateObject();
+  cJSON_AddRawToObject(object, "r", "");
+  CHECK_JSON(object, "{\"r\":}");
+  check_printed_length(object, 1);
+  cJSON_Delete(object);
+  cJSON *raw = cJSON_CreateRaw("");
+  CHECK_JSON(raw, "");
+  CHECK(cJSON_PrintedLength(raw, 0) == 0);
+  cJSON_Delete(raw);
+
+  // Raw items without text can't be printed
+  raw = cJSON_CreateRaw(NULL);
+  CHECK(raw == NULL || cJSON_PrintUnformatted(raw) == NULL);
+  cJSON_Delete(raw);
+
+  cJSON_DeletePrinter(printer);
+  return test_done();
+}
@@ -0,0 +1,155 @@
+// Compiled JSON pointers run over documents: every result is the tree
+// cJSON_Parse gives for the value pointed at, and nothing leaks on failure.
+#include "test.h"
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+static int compiles(const char *pointer) {
+  cJSON_Query *query = cJSON_CompileQueries(&pointer, 1);
+  cJSON_DeleteQuery(query);
+  return query != NULL;
+}
+
+// Run a single pointer, the result is printed or NULL
+static char *run_one(const char *pointer, const char *json) {
+  cJSON_Query *query = cJSON_CompileQueries(&pointer, 1);
+  cJSON *result = NULL;
+  char *printed = NULL;
+  CHECK(query != NULL);
+  if (cJSON_RunQueries(query, json, strlen(json), &result) && result) {
+    printed = cJSON_PrintUnformatted(result);
+  }
+  cJSON_Delete(result);
+  cJSON_DeleteQuery(query);
+  return printed;
+}
+
+#define CHECK_QUERY(pointer, json, expected)                                   \
+  do {                                                                         \
+    char *printed_ = run_one(pointer, json);                                   \
+    const char *expected_ = expected;                                          \
+    if (expected_ ? !printed_ || strcmp(printed_, expected_) != 0              \
+                  : printed_ != NULL) {                                        \
+      fprintf(stderr, "%s:%d: %s found %s, expected %s\n", __FILE__,         \
+              __LINE__, pointer, printed_ ? printed_ : "NULL",                 \
+              expected_ ? expected_ : "NULL");                                 \
+      test_failures++;                                                         \
+    }                                                                          \
+    cJSON_free(printed_);                                                      \
+  } while (0)
+
+int main(void) {
+  const char *document =
+      "{\"KeyboardLayoutsChanged\":{\"keyboard_layouts\":"
+      "{\"names\":[\"English (US)\",\"Swedish\"],\"current_idx\":1}},"
+      "\"a/b\":1,\"m~n\":2,\"\":3,\"01\":4,\"s\":\"x\\\"y\"}";
+
+  // "" is the whole document
+  CHECK_QUERY("", "[1, {\"a\": null}]", "[1,{\"a\":null}]");
+  CHECK_QUERY("", " \"text\" ", "\"text\"");
+  CHECK_QUERY("", "7", "7");
+  CHECK_QUERY("/KeyboardLayoutsChanged/keyboard_layouts/current_idx", document,
+              "1");
+  CHECK_QUERY("/KeyboardLayoutsChanged/keyboard_layouts/names", document,
+              "[\"English (US)\",\"Swedish\"]");
+  CHECK_QUERY("/KeyboardLayoutsChanged/keyboard_layouts/names/1", document,
+              "\"Swedish\"");
+  CHECK_QUERY("/KeyboardLayoutsChanged/keyboard_layouts/names/2", document,
+              NULL);
+  CHECK_QUERY("/s", document, "\"x\\\"y\"");
+  CHECK_QUERY("/missing", document, NULL);
+  CHECK_QUERY("/s/0", document, NULL);
+
+  // ~1 is '/' and ~0 is '~', "/" is the empty key
+  CHECK_QUERY("/a~1b", document, "1");
+  CHECK_QUERY("/m~0n", document, "2");
+  CHECK_QUERY("/", document, "3");
+  CHECK_QUERY("/a/b", document, NULL);
+  CHECK(!compiles("/a~"));
+  CHECK(!compiles("/a~2"));
+  CHECK(!compiles("a"));
+  CHECK(compiles("/~01"));
+  CHECK_QUERY("/~01", "{\"~1\":5,\"/\":6}", "5");
+
+  // Indices are decimal without leading zeros, too big ones match no element
+  CHECK_QUERY("/0", "[10,11]", "10");
+  CHECK_QUERY("/01", "[10,11]", NULL);
+  CHECK_QUERY("/00", "[10,11]", NULL);
+  CHECK_QUERY("/01", document, "4");
+  CHECK_QUERY("/-1", "[10,11]", NULL);
+  CHECK_QUERY("/1a", "[10,11]", NULL);
+  CHECK_QUERY("/18446744073709551616", "[10,11]", NULL);
+  CHECK_QUERY("/184467440737095516160", "[10,11]", NULL);
+
+  // Of repeated keys the first one counts
+  CHECK_QUERY("/k", "{\"k\":1,\"k\":2}", "1");
+  CHECK_QUERY("/k/x", "{\"k\":{\"y\":1},\"k\":{\"x\":2}}", "2");
+
+  // Several pointers at once, one of them below another
+  const char *pointers[] = {"/KeyboardLayoutsChanged/keyboard_layouts",
+                            "/KeyboardLayoutsChanged/keyboard_layouts/names/0",
+                            "/a~1b", "/nothing", ""};
+  cJSON *results[COUNT(pointers)];
+  cJSON_Query *query = cJSON_CompileQueries(pointers, COUNT(pointers));
+  CHECK(query != NULL);
+  CHECK(cJSON_RunQueries(query, document, strlen(document), results));
+  CHECK_JSON(results[0], "{\"names\":[\"English (US)\",\"Swedish\"],"
+                         "\"current_idx\":1}");
+  CHECK_JSON(results[1], "\"English (US)\"");
+  CHECK_JSON(results[2], "1");
+  CHECK(results[3] == NULL);
+  cJSON *parsed = cJSON_Parse(document);
+  CHECK(cJSON_Compare(results[4], parsed, 1));
+  cJSON_Delete(parsed);
+  for (size_t i = 0; i < COUNT(results); i++) {
+    cJSON_Delete(results[i]);
+  }
+
+  // Invalid JSON fails and frees what matched before it
+  const char *malformed[] = {
+      "{\"a/b\":1,\"KeyboardLayoutsChanged\":{\"keyboard_layouts\":{]}",
+      "{\"a/b\":1,\"nothing\":",
+      "{\"a/b\":1,}",
+      "{\"a/b\":[1,2",
+      "{\"a/b\":1 \"x\":2}",
+      "",
+  };
+  for (size_t i = 0; i < COUNT(malformed); i++) {
+    for (size_t j = 0; j < COUNT(results); j++) {
+      results[j] = (cJSON *)&results; // overwritten by RunQueries
+    }
+    CHECK(!cJSON_RunQueries(query, malformed[i], strlen(malformed[i]),
+                            results));
+    for (size_t j = 0; j < COUNT(results); j++) {
+      CHECK(results[j] == NULL);
+    }
+  }
+  cJSON_DeleteQuery(query);
+
+  // Reading stops once every pointer matched, the rest isn't checked
+  const char *first = "/a";
+  query = cJSON_CompileQueries(&first, 1);
+  const char *trailing = "{\"a\":1,\"b\":]";
+  CHECK(cJSON_RunQueries(query, trailing, strlen(trailing), results));
+  CHECK_JSON(results[0], "1");
+  cJSON_Delete(results[0]);
+  cJSON_DeleteQuery(query);
+
+  // The same pointer twice, also when spelled differently, is an error
+  const char *twice[] = {"/a", "/b", "/a"};
+  CHECK(cJSON_CompileQueries(twice, COUNT(twice)) == NULL);
+  const char *escaped_twice[] = {"/a~1b", "/a/b", "/a~1b"};
+  CHECK(cJSON_CompileQueries(escaped_twice, COUNT(escaped_twice)) == NULL);
+  const char *both_whole[] = {"", ""};
+  CHECK(cJSON_CompileQueries(both_whole, COUNT(both_whole)) == NULL);
+  const char *invalid_later[] = {"/a", "/b/c", "/d~"};
+  CHECK(cJSON_CompileQueries(invalid_later, COUNT(invalid_later)) == NULL);
+
+  // No pointers at all is a query that matches trivially
+  query = cJSON_CompileQueries(NULL, 0);
+  CHECK(query != NULL);
+  CHECK(cJSON_RunQueries(query, "{}", 2, NULL));
+  cJSON_DeleteQuery(query);
+
+  return test_done();
+}
@@ -0,0 +1,210 @@
+// The pull reader and cJSON_Validate built on it.
+#include "test.h"
+
+// Tokens of a reader written out one after another, the error position
+// last if there is one
+static void describe_tokens(cJSON_Reader *reader, char *out, size_t size) {
+  static const char *const names[] = {"error", "end", "{", "}", "[", "]",
+                                      "key",   "s",   "n", "t", "f", "null"};
+  cJSON_Token token;
+  char text[64];
+  size_t used = 0;
+  int type;
+
+  out[0] = '\0';
+  do {
+    type = cJSON_ReaderNext(reader, &token);
+    text[0] = '\0';
+    if (type == cJSON_TokenKey || type == cJSON_TokenString) {
+      if (!cJSON_TokenCopyString(&token, text, sizeof(text))) {
+        strcpy(text, "?");
+      }
+    } else if (type == cJSON_TokenNumber) {
+      snprintf(text, sizeof(text), "%.*s", (int)token.length, token.text);
+    } else if (type == cJSON_TokenError) {
+      snprintf(text, sizeof(text), "%zu", reader->error_position);
+    }
+    used += snprintf(out + used, size - used, "%s%s%s ", names[type],
+                     text[0] ? ":" : "", text);
+  } while (type != cJSON_TokenEnd && type != cJSON_TokenError &&
+           used < size);
+}
+
+static int check_tokens(const char *json, const char *expected) {
+  char described[512];
+  cJSON_Reader reader;
+  cJSON_InitReader(&reader, json, strlen(json));
+  describe_tokens(&reader, described, sizeof(described));
+  cJSON_ReaderRelease(&reader);
+  if (strcmp(described, expected) != 0) {
+    fprintf(stderr, "%s: read %s, expected %s\n", json, described, expected);
+    return 0;
+  }
+  return 1;
+}
+
+// Segment reader over json cut at the given offsets gives the same tokens
+// and error position as the plain reader
+static int check_segments(const char *json, const size_t *cuts,
+                          size_t n_cuts) {
+  static char plain[1 << 16];
+  static char segmented[1 << 16];
+  cJSON_Segment segments[16];
+  cJSON_Reader reader;
+  size_t n = 0;
+  size_t start = 0;
+
+  cJSON_InitReader(&reader, json, strlen(json));
+  describe_tokens(&reader, plain, sizeof(plain));
+  cJSON_ReaderRelease(&reader);
+
+  for (size_t i = 0; i <= n_cuts; i++) {
+    size_t end = i < n_cuts ? cuts[i] : strlen(json);
+    segments[n].data = json + start;
+    segments[n].length = end - start;
+    n++;
+    start = end;
+  }
+  cJSON_InitSegmentReader(&reader, segments, n);
+  describe_tokens(&reader, segmented, sizeof(segmented));
+  cJSON_ReaderRelease(&reader);
+
+  if (strcmp(plain, segmented) != 0) {
+    fprintf(stderr, "%s: segments read %s, expected %s\n", json, segmented,
+            plain);
+    return 0;
+  }
+  return 1;
+}
+
+static cJSON_bool count_tokens(const cJSON_Token *token, size_t depth,
+                               void *user_data) {
+  (void)token;
+  (void)depth;
+  return ++*(int *)user_data < 3;
+}
+
+static int validate(const char *json, size_t length, size_t expected_offset) {
+  size_t offset = 12345;
+  int valid = cJSON_Validate(json, length, &offset);
+  CHECK(offset == expected_offset);
+  return valid;
+}
+
+int main(void) {
+  CHECK(check_tokens(" {\"a\": [1, -2.5e3, \"x\\ty\"], \"b\\u00e9\": "
+                     "{\"c\": true, \"d\": false}, \"e\": null} ",
+                     "{ key:a [ n:1 n:-2.5e3 s:x\ty ] key:b\xc3\xa9 { key:c t "
+                     "key:d f } key:e null } end "));
+  CHECK(check_tokens("[]", "[ ] end "));
+  CHECK(check_tokens("12", "n:12 end "));
+  CHECK(check_tokens("\"\\ud83d\\ude00\"", "s:\xf0\x9f\x98\x80 end "));
+  CHECK(check_tokens("[1,]", "[ n:1 error:3 "));
+  CHECK(check_tokens("{\"a\" 1}", "{ error:5 "));
+  CHECK(check_tokens("{\"a\":1]", "{ key:a n:1 error:6 "));
+  // Numbers follow the JSON grammar, strings take control characters like
+  // cJSON_Parse does
+  CHECK(check_tokens("[01]", "[ n:0 error:2 "));
+  CHECK(check_tokens("[1.]", "[ error:3 "));
+  CHECK(check_tokens("\"\\x\"", "error:1 "));
+  CHECK(check_tokens("\"a\nb\"", "s:a\nb end "));
+  CHECK(check_tokens("[tru]", "[ error:1 "));
+  CHECK(check_tokens("[1] 2", "[ n:1 ] error:4 "));
+  CHECK(check_tokens("  ", "error:2 "));
+
+  // Skipping a value, a key or what is left of a container
+  cJSON_Reader reader;
+  cJSON_Token token;
+  const char *json = "{\"a\":{\"x\":[1,{}]},\"b\":2,\"c\":[3,4]}";
+  cJSON_InitReader(&reader, json, strlen(json));
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenObjectStart);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenKey);
+  CHECK(cJSON_TokenEquals(&token, "a") && !cJSON_TokenEquals(&token, "ab"));
+  CHECK(cJSON_ReaderSkip(&reader));
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenKey);
+  CHECK(cJSON_TokenEquals(&token, "b"));
+  double number = 0;
+  cJSON_int64 integer = 0;
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenNumber);
+  CHECK(cJSON_TokenToNumber(&token, &number) && number == 2);
+  CHECK(cJSON_TokenToInt64(&token, &integer) && integer == 2);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenKey);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenArrayStart);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenNumber);
+  CHECK(cJSON_ReaderSkip(&reader) && reader.depth == 2);
+  CHECK(cJSON_ReaderSkip(&reader) && reader.depth == 1);
+  CHECK(cJSON_ReaderSkip(&reader) && reader.depth == 0);
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenEnd);
+  cJSON_ReaderRelease(&reader);
+
+  json = "[\"9223372036854775807\", 9223372036854775807]";
+  cJSON_InitReader(&reader, json, strlen(json));
+  cJSON_ReaderNext(&reader, &token);
+  cJSON_ReaderNext(&reader, &token);
+  char small[4];
+  CHECK(!cJSON_TokenCopyString(&token, small, sizeof(small)));
+  CHECK(cJSON_ReaderNext(&reader, &token) == cJSON_TokenNumber);
+  CHECK(cJSON_TokenToInt64(&token, &integer) &&
+        integer == 9223372036854775807LL);
+  cJSON_ReaderRelease(&reader);
+
+  // Every single cut and every pair of cuts, including empty segments
+  const char *split[] = {"{\"key\\u00e9\": [-12.5e-3, true, null, \"\\ud83d\\ude00\"]}",
+                         "[12345, \"abc\\\"\", fals]", "{\"a\":1} x", "[1.]"};
+  for (size_t i = 0; i < sizeof(split) / sizeof(*split); i++) {
+    size_t length = strlen(split[i]);
+    for (size_t a = 0; a <= length; a++) {
+      for (size_t b = a; b <= length; b++) {
+        size_t cuts[] = {a, b};
+        CHECK(check_segments(split[i], cuts, 2));
+      }
+    }
+  }
+
+  // Random documents, some of them with a byte changed, in random pieces
+  for (int i = 0; i < 300; i++) {
+    cJSON *tree = test_random_tree(0);
+    char *printed = cJSON_PrintUnformatted(tree);
+    size_t length = strlen(printed);
+    if (i % 3 == 0 && length > 0) {
+      printed[test_random() % length] = "{}[],:\"\\0ae "[test_random() % 12];
+    }
+    size_t cuts[15];
+    size_t n_cuts = test_random() % 15;
+    for (size_t c = 0; c < n_cuts; c++) {
+      cuts[c] = length ? test_random() % (length + 1) : 0;
+    }
+    for (size_t c = 1; c < n_cuts; c++) {
+      for (size_t d = c; d > 0 && cuts[d - 1] > cuts[d]; d--) {
+        size_t swap = cuts[d];
+        cuts[d] = cuts[d - 1];
+        cuts[d - 1] = swap;
+      }
+    }
+    CHECK(check_segments(printed, cuts, n_cuts));
+    cJSON_free(printed);
+    cJSON_Delete(tree);
+  }
+
+  int tokens = 0;
+  CHECK(cJSON_ParseTokens("[1,2,3,4]", 9, count_tokens, &tokens) &&
+        tokens == 3);
+  tokens = 0;
+  CHECK(!cJSON_ParseTokens("[1,", 3, count_tokens, &tokens));
+
+  CHECK(validate("{}", 2, 0));
+  CHECK(validate(" [1, {\"a\": null}]\n", 18, 0));
+  CHECK(validate("\"\\u00e9\"", 8, 0));
+  CHECK(!validate("", 0, 0));
+  CHECK(!validate("[1,]", 4, 3));
+  CHECK(!validate("{} x", 4, 3));
+  CHECK(!validate("{}{}", 4, 2));
+  CHECK(!validate("[1", 2, 2));
+  // A null byte ends the text for cJSON_Parse, but not for a given length
+  CHECK(!validate("{}\0garbage", 10, 2));
+  CHECK(!validate("{} \0", 4, 3));
+  CHECK(validate("{}\0garbage", 2, 0));
+  CHECK(!cJSON_Validate("[1,", 3, NULL));
+
+  return test_done();
+}
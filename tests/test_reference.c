@@ -0,0 +1,53 @@
+// References share the child list of another item, so their size and
+// elements follow that list as it changes.
+#include "test.h"
+
+int main(void) {
+  cJSON *array = cJSON_CreateArray();
+  cJSON_AddItemToArray(array, cJSON_CreateNumber(1));
+
+  cJSON *reference = cJSON_CreateArrayReference(array->child);
+  cJSON_AddItemToArray(array, cJSON_CreateNumber(2));
+  cJSON_AddItemToArray(array, cJSON_CreateNumber(3));
+  CHECK(cJSON_GetArraySize(reference) == 3);
+  CHECK(cJSON_GetArrayItem(reference, 2) != NULL &&
+        cJSON_GetArrayItem(reference, 2)->valueint == 3);
+  CHECK(cJSON_GetArrayItem(reference, 3) == NULL);
+  CHECK_JSON(reference, "[1,2,3]");
+  cJSON_Delete(reference);
+
+  cJSON *holder = cJSON_CreateObject();
+  cJSON_AddItemReferenceToObject(holder, "r", array);
+  cJSON_AddItemToArray(array, cJSON_CreateNumber(4));
+  cJSON *r = cJSON_GetObjectItem(holder, "r");
+  CHECK(cJSON_GetArraySize(r) == 4);
+  CHECK(cJSON_GetArrayItem(r, 3) != NULL);
+
+  // CBOR writes the length of arrays up front
+  size_t length = 0;
+  unsigned char *encoded = cJSON_EncodeCBOR(holder, 0, &length);
+  cJSON *decoded = encoded ? cJSON_DecodeCBOR(encoded, length, NULL) : NULL;
+  CHECK_JSON(decoded, "{\"r\":[1,2,3,4]}");
+  cJSON_Delete(decoded);
+  cJSON_free(encoded);
+
+  // A diff against the same data without references is empty
+  cJSON *plain = cJSON_Parse("{\"r\":[1,2,3,4]}");
+  cJSON *patch = cJSON_Diff(holder, plain, NULL);
+  CHECK(patch != NULL && cJSON_GetArraySize(patch) == 0);
+  cJSON_Delete(patch);
+  cJSON_Delete(plain);
+
+  cJSON *object = cJSON_CreateObject();
+  cJSON_AddTrueToObject(object, "a");
+  cJSON *object_reference = cJSON_CreateObjectReference(object->child);
+  cJSON_AddFalseToObject(object, "b");
+  CHECK(cJSON_GetArraySize(object_reference) == 2);
+  CHECK(cJSON_IsFalse(cJSON_GetObjectItem(object_reference, "b")));
+  cJSON_Delete(object_reference);
+
+  cJSON_Delete(holder);
+  cJSON_Delete(array);
+  cJSON_Delete(object);
+  return test_done();
+}
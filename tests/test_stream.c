@@ -0,0 +1,178 @@
+// Newline delimited JSON fed to cJSON_Stream in chunks: wherever the input is
+// split, the documents are the ones cJSON_ParseWithOpts gives for each line.
+#include "test.h"
+
+static const char input[] =
+    "{\"a\":[1,2.5,-3e2,\"x\\\"\\n\\u00e9\"],\"b\":{\"c\":null,\"d\":true,"
+    "\"e\":false,\"\":{}}}\n"
+    "\n"
+    "[1,]\n"
+    "  \"str\"  \n"
+    "12345678901234567890\n"
+    "{\"k\":1 \"j\":2}\n"
+    "[[],{},[[\"deep\",\"\\\\\"]]]\n"
+    "tru\n"
+    "1 x\n"
+    "{\"open\":[1\n"
+    "42\n";
+
+// What the stream has to report for input, invalid lines as "!" and the
+// position they were rejected at
+static const char *const invalid_positions[] = {"!3", "!7", "!3", "!2", "!10"};
+
+#define MAX_EVENTS 16
+
+typedef struct {
+  char *events[MAX_EVENTS];
+  size_t count;
+} events_t;
+
+static void add_event(events_t *events, char *event) {
+  CHECK(events->count < MAX_EVENTS);
+  if (events->count < MAX_EVENTS) {
+    events->events[events->count++] = event;
+  } else {
+    free(event);
+  }
+}
+
+static void free_events(events_t *events) {
+  for (size_t i = 0; i < events->count; i++) {
+    free(events->events[i]);
+  }
+  events->count = 0;
+}
+
+// Feed one chunk, calling again for what is left after each line
+static void feed(cJSON_Stream *stream, const char *chunk, size_t length,
+                 events_t *events) {
+  while (length > 0) {
+    size_t consumed = 0;
+    cJSON *document = NULL;
+    char position[32];
+    int result = cJSON_StreamFeed(stream, chunk, length, &consumed, &document);
+    CHECK(consumed <= length);
+    CHECK(result == cJSON_StreamNeedMore ? consumed == length : consumed > 0);
+    if (result == cJSON_StreamDocument) {
+      CHECK(document != NULL);
+      char *printed = cJSON_PrintUnformatted(document);
+      add_event(events, strdup(printed));
+      cJSON_free(printed);
+      cJSON_Delete(document);
+    } else if (result == cJSON_StreamInvalid) {
+      CHECK(document == NULL);
+      snprintf(position, sizeof(position), "!%zu",
+               cJSON_StreamErrorPosition(stream));
+      add_event(events, strdup(position));
+    }
+    chunk += consumed;
+    length -= consumed;
+  }
+}
+
+static void check_events(const events_t *actual, const events_t *expected,
+                         const char *how, size_t at) {
+  int same = actual->count == expected->count;
+  for (size_t i = 0; same && i < actual->count; i++) {
+    same = strcmp(actual->events[i], expected->events[i]) == 0;
+  }
+  if (!same) {
+    fprintf(stderr, "%s at %zu:", how, at);
+    for (size_t i = 0; i < actual->count; i++) {
+      fprintf(stderr, " %s", actual->events[i]);
+    }
+    fprintf(stderr, "\n");
+    test_failures++;
+  }
+}
+
+int main(void) {
+  const size_t length = sizeof(input) - 1;
+  events_t expected = {0};
+  events_t actual = {0};
+  size_t invalid = 0;
+
+  // Each line on its own, parsed with nothing allowed after the value
+  for (const char *line = input; *line;) {
+    const char *end = strchr(line, '\n');
+    char text[128];
+    memcpy(text, line, (size_t)(end - line));
+    text[end - line] = '\0';
+    line = end + 1;
+    if (text[0] == '\0') {
+      continue;
+    }
+    cJSON *parsed = cJSON_ParseWithOpts(text, NULL, 1);
+    if (parsed) {
+      char *printed = cJSON_PrintUnformatted(parsed);
+      add_event(&expected, strdup(printed));
+      cJSON_free(printed);
+      cJSON_Delete(parsed);
+    } else {
+      add_event(&expected, strdup(invalid_positions[invalid++]));
+    }
+  }
+  CHECK(invalid == sizeof(invalid_positions) / sizeof(*invalid_positions));
+
+  // Several documents in one chunk
+  cJSON_Stream *stream = cJSON_CreateStream();
+  CHECK(stream != NULL);
+  feed(stream, input, length, &actual);
+  check_events(&actual, &expected, "one chunk", 0);
+  free_events(&actual);
+
+  // Split at every byte, the stream carries the rest of the line over
+  for (size_t split = 1; split < length; split++) {
+    feed(stream, input, split, &actual);
+    feed(stream, input + split, length - split, &actual);
+    check_events(&actual, &expected, "split", split);
+    free_events(&actual);
+  }
+
+  // One byte at a time
+  for (size_t i = 0; i < length; i++) {
+    feed(stream, input + i, 1, &actual);
+  }
+  check_events(&actual, &expected, "byte by byte", 0);
+  free_events(&actual);
+
+  // A line without its newline isn't complete yet
+  size_t consumed = 0;
+  cJSON *document = NULL;
+  CHECK(cJSON_StreamFeed(stream, "[1]", 3, &consumed, &document) ==
+        cJSON_StreamNeedMore);
+  CHECK(consumed == 3 && document == NULL);
+  CHECK(cJSON_StreamFeed(stream, "\n[2]\n", 5, &consumed, &document) ==
+        cJSON_StreamDocument);
+  CHECK(consumed == 1);
+  CHECK_JSON(document, "[1]");
+  cJSON_Delete(document);
+  CHECK(cJSON_StreamFeed(stream, "[2]\n", 4, &consumed, &document) ==
+        cJSON_StreamDocument);
+  CHECK_JSON(document, "[2]");
+  cJSON_Delete(document);
+
+  // Misuse
+  CHECK(cJSON_StreamFeed(NULL, "1\n", 2, &consumed, &document) ==
+        cJSON_StreamInvalid);
+  CHECK(cJSON_StreamFeed(stream, "1\n", 2, NULL, &document) ==
+        cJSON_StreamInvalid);
+  CHECK(cJSON_StreamFeed(stream, NULL, 0, &consumed, &document) ==
+        cJSON_StreamNeedMore);
+  cJSON_DeleteStream(stream);
+
+  // Deleting a stream in the middle of a document frees what it holds: open
+  // containers, a key and a split string or number
+  const char *partial[] = {"{\"key\":[1,{\"s\":\"abc", "{\"key\":[1,{\"s\":",
+                           "{\"ke", "[[[[[[[[[[[{\"n\":-12.5e"};
+  for (size_t i = 0; i < sizeof(partial) / sizeof(*partial); i++) {
+    stream = cJSON_CreateStream();
+    CHECK(cJSON_StreamFeed(stream, partial[i], strlen(partial[i]), &consumed,
+                           &document) == cJSON_StreamNeedMore);
+    cJSON_DeleteStream(stream);
+  }
+  cJSON_DeleteStream(NULL);
+
+  free_events(&expected);
+  return test_done();
+}
@@ -0,0 +1,140 @@
+// The JSON writer gives the text cJSON_Print and cJSON_PrintUnformatted give
+// for the same tree, into growing and fixed buffers.
+#include "test.h"
+
+// Write item with the calls for each type rather than cJSON_WriteItem
+static void write_tree(cJSON_Writer *writer, const cJSON *item) {
+  if (cJSON_IsObject(item) || cJSON_IsArray(item)) {
+    cJSON_IsObject(item) ? cJSON_WriteObjectStart(writer)
+                         : cJSON_WriteArrayStart(writer);
+    for (const cJSON *child = item->child; child; child = child->next) {
+      if (cJSON_IsObject(item)) {
+        cJSON_WriteKey(writer, child->string);
+      }
+      write_tree(writer, child);
+    }
+    cJSON_IsObject(item) ? cJSON_WriteObjectEnd(writer)
+                         : cJSON_WriteArrayEnd(writer);
+  } else if (cJSON_IsString(item)) {
+    cJSON_WriteString(writer, item->valuestring);
+  } else if (cJSON_IsNumber(item)) {
+    cJSON_IsInt64(item) ? cJSON_WriteInt64(writer, cJSON_GetInt64Value(item))
+                        : cJSON_WriteNumber(writer, item->valuedouble);
+  } else if (cJSON_IsBool(item)) {
+    cJSON_WriteBool(writer, cJSON_IsTrue(item));
+  } else if (cJSON_IsRaw(item)) {
+    cJSON_WriteRaw(writer, item->valuestring);
+  } else {
+    cJSON_WriteNull(writer);
+  }
+}
+
+static void check_output(const cJSON_Writer *writer, const char *expected) {
+  size_t length = 0;
+  const char *output = cJSON_WriterOutput(writer, &length);
+  if (!output || !expected || strcmp(output, expected) != 0 ||
+      length != strlen(expected)) {
+    fprintf(stderr, "wrote %.200s\nexpected %.200s\n", output ? output : "NULL",
+            expected ? expected : "NULL");
+    test_failures++;
+  }
+}
+
+int main(void) {
+  cJSON_Writer writer;
+  char fixed[4096];
+
+  for (int i = 0; i < 2000; i++) {
+    cJSON *tree = test_random_tree(0);
+    for (int format = 0; format < 2; format++) {
+      char *expected = format ? cJSON_Print(tree) : cJSON_PrintUnformatted(tree);
+      size_t length = strlen(expected);
+
+      // Growing buffer, and the same writer again after a reset
+      cJSON_InitWriter(&writer, NULL, 0, format);
+      write_tree(&writer, tree);
+      check_output(&writer, expected);
+      cJSON_ResetWriter(&writer);
+      CHECK(cJSON_WriterOutput(&writer, NULL) == NULL);
+      write_tree(&writer, tree);
+      check_output(&writer, expected);
+      cJSON_FreeWriter(&writer);
+
+      // A buffer with room for exactly the text and its terminator
+      if (length < sizeof(fixed)) {
+        cJSON_InitWriter(&writer, fixed, length + 1, format);
+        write_tree(&writer, tree);
+        check_output(&writer, expected);
+
+        // One byte less runs out, and the writer stays failed
+        cJSON_InitWriter(&writer, fixed, length, format);
+        write_tree(&writer, tree);
+        CHECK(writer.failed);
+        CHECK(cJSON_WriterOutput(&writer, NULL) == NULL);
+        CHECK(!cJSON_WriteNull(&writer));
+        CHECK(strlen(fixed) < length);
+
+        // After a reset the same buffer is good for a smaller document
+        cJSON_ResetWriter(&writer);
+        CHECK(!writer.failed && (length == 0 || fixed[0] == '\0'));
+        if (length >= sizeof("[]")) {
+          CHECK(cJSON_WriteArrayStart(&writer) && cJSON_WriteArrayEnd(&writer));
+          check_output(&writer, "[]");
+        }
+      }
+      cJSON_free(expected);
+    }
+    cJSON_Delete(tree);
+  }
+
+  // Raw text and existing trees at any depth, next to written values
+  cJSON *tree = cJSON_CreateObject();
+  cJSON *list = cJSON_AddArrayToObject(tree, "list");
+  cJSON_AddItemToArray(list, cJSON_CreateRaw("{\"pre\": [1, 2]}"));
+  cJSON *item = cJSON_Parse("{\"a\":[true,{\"b\":null}],\"c\":\"d\"}");
+  cJSON_AddItemToArray(list, cJSON_Duplicate(item, 1));
+  cJSON_AddItemToArray(list, cJSON_CreateNumber(1.5));
+  cJSON_AddRawToObject(tree, "raw", "12345678901234567890");
+  for (int format = 0; format < 2; format++) {
+    char *expected = format ? cJSON_Print(tree) : cJSON_PrintUnformatted(tree);
+    cJSON_InitWriter(&writer, NULL, 0, format);
+    CHECK(cJSON_WriteObjectStart(&writer));
+    CHECK(cJSON_WriteKey(&writer, "list"));
+    CHECK(cJSON_WriteArrayStart(&writer));
+    CHECK(cJSON_WriteRaw(&writer, "{\"pre\": [1, 2]}"));
+    CHECK(cJSON_WriteItem(&writer, item));
+    CHECK(cJSON_WriteNumber(&writer, 1.5));
+    CHECK(cJSON_WriterOutput(&writer, NULL) == NULL);
+    CHECK(cJSON_WriteArrayEnd(&writer));
+    CHECK(cJSON_WriteKey(&writer, "raw"));
+    CHECK(cJSON_WriteRaw(&writer, "12345678901234567890"));
+    CHECK(cJSON_WriteObjectEnd(&writer));
+    check_output(&writer, expected);
+    cJSON_FreeWriter(&writer);
+    cJSON_free(expected);
+  }
+  cJSON_Delete(item);
+  cJSON_Delete(tree);
+
+  // Misuse fails the writer
+  cJSON_InitWriter(&writer, fixed, sizeof(fixed), 0);
+  CHECK(cJSON_WriteObjectStart(&writer));
+  CHECK(!cJSON_WriteNull(&writer));
+  CHECK(!cJSON_WriteObjectEnd(&writer));
+  cJSON_ResetWriter(&writer);
+  CHECK(cJSON_WriteArrayStart(&writer));
+  CHECK(!cJSON_WriteKey(&writer, "k"));
+  cJSON_ResetWriter(&writer);
+  CHECK(cJSON_WriteArrayStart(&writer));
+  CHECK(!cJSON_WriteObjectEnd(&writer));
+  cJSON_ResetWriter(&writer);
+  CHECK(!cJSON_WriteRaw(&writer, NULL));
+  cJSON_ResetWriter(&writer);
+  CHECK(cJSON_WriteNull(&writer));
+  CHECK(!cJSON_WriteNull(&writer));
+  cJSON_ResetWriter(&writer);
+  CHECK(cJSON_WriteString(&writer, "only"));
+  check_output(&writer, "\"only\"");
+
+  return test_done();
+}